@@ -18,6 +18,9 @@
  * Sun 2025-04-06 File created.                                                 Version: 00.01
  * Mon 2025-04-07 Changed All names to new Samael naming convention.            Version: 00.02
  * Tue 2025-04-08 Bug Fixed: Call of ToString(versionIn, buffer); L116          Version: 00.03
+ * Sat 2026-10-17 Hash chain pointer for the framework's version index.         Version: 00.04
+ * Sat 2026-10-17 VersionRecord for the link-time version table.                Version: 00.05
+ * Sat 2026-10-17 Interned names, packed numbers, entries from a pool.          Version: 00.06
  * ********************************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,17 +39,184 @@
 #include "Version.h"
 
 // -------------------------------------------------------------------------------------------
-// RegVersion - Automatically registers this component's version information with the 
-// versioning system of the Samael framework.
-// 
-// This function is marked with the constructor attribute in the implementation file 
-// (Version.c), which means it will automatically be executed prior to the execution 
-// of the main() function. This pre-main invocation is part of the automatic versioning 
-// mechanism, ensuring that the version details for this component are registered as soon 
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegVersion(void) {
-    RegisterVersion("Samael.Chronicle", "Version", 0, 2);
+// RegVersion - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
+// -------------------------------------------------------------------------------------------
+SAMAEL_VERSION(RegVersion, "Samael.Chronicle", "Version", 0, 6);
+
+// -------------------------------------------------------------------------------------------
+// A Pool hands out memory from blocks, one piece after the other, and never takes any back. The
+// first block has POOL_FIRST_BLOCK bytes, every further one twice the one before, up to
+// POOL_LAST_BLOCK, so a program with a handful of components doesn't pay for thousands. The
+// pieces are rounded to the size of a pointer, so each is aligned for one. A thread takes a
+// piece by adding its size to the used bytes of the current block. If that runs past the end,
+// it puts a new block in place with a compare-and-swap, a thread losing that race frees its
+// block and takes from the winner's. Pieces bigger than POOL_FIRST_BLOCK / 4 get their own malloc.
+//
+// Version entries and interned strings have a pool each, so the entries lie next to each other.
+// --------------------------------------------------------------------------------------------
+#define POOL_FIRST_BLOCK 1024
+#define POOL_LAST_BLOCK 65536
+
+typedef struct PoolBlock {
+    struct PoolBlock* previous; // The block filled before, kept for the debugger
+    size_t size;                // Bytes of data
+    size_t used;                // Bytes handed out, may run past size while full
+    void* data[];               // The memory, aligned for pointers
+} PoolBlock;
+
+typedef struct {
+    PoolBlock* current;         // The block pieces are taken from
+} Pool;
+
+static Pool versionPool = { NULL };
+static Pool stringPool = { NULL };
+
+// -------------------------------------------------------------------------------------------
+// PoolAllocate - Takes a piece of memory from a pool.
+//
+// @param poolIn    - The pool.
+// @param sizeIn    - The size of the piece in bytes.
+// @return          - The piece, NULL if out of memory.
+// -------------------------------------------------------------------------------------------
+static void* PoolAllocate(Pool* poolIn, size_t sizeIn) {
+    size_t size = (sizeIn + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    if (size > POOL_FIRST_BLOCK / 4) {
+        return malloc(size);
+    }
+
+    for (;;) {
+        PoolBlock* block = __atomic_load_n(&poolIn->current, __ATOMIC_ACQUIRE);
+        if (block != NULL) {
+            size_t offset = __atomic_fetch_add(&block->used, size, __ATOMIC_RELAXED);
+            if (offset + size <= block->size) {
+                return (char*)block->data + offset;
+            }
+        }
+
+        size_t blockSize = block == NULL ? POOL_FIRST_BLOCK
+                         : block->size < POOL_LAST_BLOCK ? block->size * 2 : POOL_LAST_BLOCK;
+        PoolBlock* fresh = malloc(sizeof(PoolBlock) + blockSize);
+        if (fresh == NULL) {
+            return NULL;
+        }
+        fresh->previous = block;
+        fresh->size = blockSize;
+        fresh->used = size;
+        if (__atomic_compare_exchange_n(&poolIn->current, &block, fresh, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return fresh->data;
+        }
+        free(fresh);
+    }
+}
+
+// -------------------------------------------------------------------------------------------
+// The table of interned strings is a number of buckets, each a list of the strings with its
+// hash, the newest first, pushed with a compare-and-swap like the framework's hash index. The
+// table is made on first use, with a bucket for every entry ReserveVersions announced, at
+// least STRING_BUCKETS. It can't be swapped for a bigger one without a lock, more strings
+// only make the lists longer.
+// --------------------------------------------------------------------------------------------
+#define STRING_BUCKETS 16
+
+typedef struct InternedString {
+    struct InternedString* next;  // Next string in the same bucket
+    char text[];                  // The string
+} InternedString;
+
+typedef struct {
+    size_t mask;                  // Number of buckets minus one
+    InternedString* buckets[];    // The lists of strings
+} StringTable;
+
+static StringTable* stringIndex = NULL;
+
+// -------------------------------------------------------------------------------------------
+// GetStringTable - Returns the table of interned strings, and makes it if there is none yet.
+// If two threads make it at once, the one losing the compare-and-swap frees its table.
+//
+// @param countIn   - The number of strings to expect.
+// @return          - The table, NULL if out of memory.
+// -------------------------------------------------------------------------------------------
+static StringTable* GetStringTable(size_t countIn) {
+    StringTable* table = __atomic_load_n(&stringIndex, __ATOMIC_ACQUIRE);
+    if (table != NULL) {
+        return table;
+    }
+
+    size_t buckets = STRING_BUCKETS;
+    while (buckets < countIn) {
+        buckets *= 2;
+    }
+    StringTable* fresh = calloc(1, sizeof(StringTable) + sizeof(InternedString*) * buckets);
+    if (fresh == NULL) {
+        return NULL;
+    }
+    fresh->mask = buckets - 1;
+    if (__atomic_compare_exchange_n(&stringIndex, &table, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return fresh;
+    }
+    free(fresh);
+    return table;
+}
+
+// -------------------------------------------------------------------------------------------
+// ReserveVersions - Sizes the table of interned strings for the number of entries about to be
+// created. Only the first call before any entry exists has an effect.
+//
+// @param countIn   - The number of entries.
+// -------------------------------------------------------------------------------------------
+void ReserveVersions(int countIn) {
+    GetStringTable(countIn > 0 ? (size_t)countIn : 0);
+}
+
+// -------------------------------------------------------------------------------------------
+// InternString - Looks up a string in the table of interned strings, and adds a copy if it
+// isn't there yet. If two threads add the same string at once, the one losing the push finds
+// the other's copy, its own stays unused in the pool.
+//
+// @param textIn    - The string.
+// @return          - The interned copy, NULL if out of memory.
+// -------------------------------------------------------------------------------------------
+const char* InternString(const char* textIn) {
+    if (textIn[0] == '\0') {
+        return "";
+    }
+
+    unsigned int hash = 2166136261u;
+    size_t length = 0;
+    for (; textIn[length] != '\0'; length++) {
+        hash = (hash ^ (unsigned char)textIn[length]) * 16777619u;
+    }
+
+    StringTable* table = GetStringTable(0);
+    if (table == NULL) {
+        return NULL;
+    }
+    InternedString** bucket = &table->buckets[hash & table->mask];
+    InternedString* first = __atomic_load_n(bucket, __ATOMIC_ACQUIRE);
+    InternedString* compared = NULL;  // From here on the strings were compared already
+    InternedString* fresh = NULL;
+    for (;;) {
+        for (InternedString* current = first; current != compared; current = current->next) {
+            if (strcmp(current->text, textIn) == 0) {
+                return current->text;
+            }
+        }
+        compared = first;
+
+        if (fresh == NULL) {
+            fresh = PoolAllocate(&stringPool, sizeof(InternedString) + length + 1);
+            if (fresh == NULL) {
+                return NULL;
+            }
+            memcpy(fresh->text, textIn, length + 1);
+        }
+        fresh->next = first;
+        if (__atomic_compare_exchange_n(bucket, &first, fresh, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+            return fresh->text;
+        }
+    }
 }
 
 // -------------------------------------------------------------------------------------------
@@ -59,20 +229,23 @@ __attribute__((constructor)) void RegVersion(void) {
 // @param major    - The major version number.
 // @param minor    - The minor version number.
 // -------------------------------------------------------------------------------------------
-Version* CreateVersion(char* packageIn, char* nameIn, int majorIn, int minorIn) {
+Version* CreateVersion(const char* packageIn, const char* nameIn, int majorIn, int minorIn) {
     
-    Version* versionOut = (Version*)malloc(sizeof(Version));
+    Version* versionOut = PoolAllocate(&versionPool, sizeof(Version));
+    const char* package = InternString(packageIn);
+    const char* name = InternString(nameIn);
     
-    if (versionOut == NULL) {
+    if (versionOut == NULL || package == NULL || name == NULL) {
         fprintf(stderr, "Memory allocation failed for new version entry.\n");
         return NULL;
     }
     
-    snprintf(versionOut->package, sizeof(versionOut->package), "%s", packageIn);
-    snprintf(versionOut->name, sizeof(versionOut->name), "%s", nameIn);
-    versionOut->major = majorIn;
-    versionOut->minor = minorIn;
+    versionOut->package = package;
+    versionOut->name = name;
+    versionOut->major = (unsigned short)majorIn;
+    versionOut->minor = (unsigned short)minorIn;
     versionOut->tail = NULL;  // Initialize the tail pointer to NULL
+    versionOut->chain = NULL; // Not in the hash index yet
     
     return versionOut;
 }
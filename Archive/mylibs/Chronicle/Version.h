@@ -12,6 +12,9 @@
  * Sun 2025-04-06 File created.                                                 Version: 00.01
  * Mon 2025-04-07 Changed All names to new Samael naming convention.            Version: 00.02
  * Tue 2025-04-08 Bug Fixed: Call of ToString(versionIn, buffer); L116          Version: 00.03
+ * Sat 2026-10-17 Hash chain pointer for the framework's version index.         Version: 00.04
+ * Sat 2026-10-17 VersionRecord for the link-time version table.                Version: 00.05
+ * Sat 2026-10-17 Interned names, packed numbers, entries from a pool.          Version: 00.06
  * ********************************************************************************************/
 
 #ifndef VERSION_H
@@ -28,6 +31,13 @@
 // - The major version number, representing significant changes in functionality.
 // - The minor version number, indicating smaller revisions or refinements.
 // - A pointer to the next version enty in the linked list, allowing for dynamic version management.
+// - A pointer to the next version entry in the same bucket of the framework's hash index.
+//
+// Package and component name point into a table of interned strings, so all components of a
+// package share one copy of its name, and the version numbers take 16 bits each. An entry is
+// 40 bytes on a 64 bit system instead of more than 200, and CreateVersion takes the entries
+// one after another from a pool, which keeps walking the list cache friendly. Entries and
+// strings stay until the program ends, the registry never removes one.
 //
 // These version entries are connected in a linked list, allowing the framework to dynamically 
 // manage registered components, sort them into structured hierarchies, and retrieve version 
@@ -39,36 +49,58 @@
 // framework versions.
 // -------------------------------------------------------------------------------------------
 typedef struct Version {
-    char package[100];   // Package name
-    char name[100];      // Component name
-    int major;
-    int minor;
-    struct Version* tail;  // Linked list pointer
+    const char* package;    // Package name, interned
+    const char* name;       // Component name, interned, "" for the package itself
+    struct Version* tail;   // Linked list pointer
+    struct Version* chain;  // Next entry in the same bucket of the hash index
+    unsigned short major;
+    unsigned short minor;
 } Version;
 
 // -------------------------------------------------------------------------------------------
-// RegVersion - Automatically registers this component's version information with the 
-// versioning system of the Samael framework.
-// 
-// This function is marked with the constructor attribute in the implementation file 
-// (Version.c), which means it will automatically be executed prior to the execution 
-// of the main() function. This pre-main invocation is part of the automatic versioning 
-// mechanism, ensuring that the version details for this component are registered as soon 
-// as the module is loaded.
+// Struct VersionRecord:
+// The constant form of a version entry the SAMAEL_VERSION macro of the framework places in the
+// link-time version table. It only points to the string literals of package and component
+// name, the framework makes Version entries of it once the list is asked for.
 // -------------------------------------------------------------------------------------------
-void RegVersion();
+typedef struct VersionRecord {
+    const char* package;    // Package name
+    const char* name;       // Component name, "" for the package itself
+    int major;
+    int minor;
+} VersionRecord;
 
 // -------------------------------------------------------------------------------------------
 // This function creates a new version entry with the specified package name, component name,
 // major version number, and minor version number. It initializes the version entry and
-// returns a pointer to the newly created Version structure.
+// returns a pointer to the newly created Version structure. The names are interned, so the
+// strings passed in don't need to outlive the call. The entry is never freed.
 //
 // @param packageIn - The name of the framework or software package.
 // @param nameIn    - The name of the component or module.
 // @param majorIn   - The major version number.
 // @param minorIn   - The minor version number.
 // -------------------------------------------------------------------------------------------
-Version* CreateVersion(char* packageIn, char* nameIn, int majorIn, int minorIn);
+Version* CreateVersion(const char* packageIn, const char* nameIn, int majorIn, int minorIn);
+
+// -------------------------------------------------------------------------------------------
+// InternString - Looks up a string in the table of interned strings, and adds a copy if it
+// isn't there yet. Equal strings give the same pointer. Safe to call from several threads
+// at once, it takes no lock.
+//
+// @param textIn    - The string.
+// @return          - The interned copy, NULL if out of memory.
+// -------------------------------------------------------------------------------------------
+const char* InternString(const char* textIn);
+
+// -------------------------------------------------------------------------------------------
+// ReserveVersions - Sizes the table of interned strings for the number of entries about to be
+// created, the framework calls it with the size of its link-time version table. Only the
+// first call before any entry exists has an effect, without it the table starts small.
+//
+// @param countIn   - The number of entries.
+// -------------------------------------------------------------------------------------------
+void ReserveVersions(int countIn);
 
 // -------------------------------------------------------------------------------------------
 // This function creates a formatted string representing the version information of the given
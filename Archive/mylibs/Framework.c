@@ -27,6 +27,11 @@
  * Mon 2025-04-07 Bugfix: Dynamically allocated string in toListString().       Version: 00.03
  * Mon 2025-04-07 Bugfix: Displaying package and component in toListString().   Version: 00.04
  * Mon 2025-04-07 Implemented all new Samael nameing conventions.               Version: 00.05
+ * Sat 2026-10-17 Tail pointer and hash index, FindVersion() in O(1).           Version: 00.06
+ * Sat 2026-10-17 SAMAEL_VERSION: version records in a link-time table.         Version: 00.07
+ * Sat 2026-10-17 Lock-free registry: atomic appends and bucket pushes.         Version: 00.08
+ * Sat 2026-10-17 Linear ToListString into one exact buffer, JSON and binary.   Version: 00.09
+ * Sat 2026-10-17 Version entries from the pool of CreateVersion.               Version: 00.10
  * ********************************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,6 +39,14 @@
 
 #include "Framework.h"
 
+#ifdef _WIN32
+    #include <windows.h>
+    #define YieldThread() SwitchToThread()
+#else
+    #include <sched.h>
+    #define YieldThread() sched_yield()
+#endif
+
 #ifdef _WIN32
 // --= Windows Section please uncomment what you need! =-- //
 #include "Chronicle/Version.h"
@@ -53,24 +66,191 @@
 static Version* snakeHead = NULL;
 
 // -------------------------------------------------------------------------------------------
-// RegFramework - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
+// The snakeTail points to the last element of the list, so a new component is appended without
+// walking the snake from its head. Every component registers itself at load time, walking the
+// list made loading all of them quadratic.
 //
-// This function is marked with the constructor attribute in the implementation file
-// (Framework.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// Plugins may be loaded from several threads at once, so the registry takes no lock: head, tail
+// and the links of the list only change with atomic compare-and-swap operations. An entry is
+// complete before it is linked in and never changes or goes away afterwards, so a reader that
+// follows the list sees every entry up to the moment it got the head, or a few more.
+// The snakeTail may lag one entry behind, whoever sees that moves it on.
+// --------------------------------------------------------------------------------------------
+static Version* snakeTail = NULL;
+
+// -------------------------------------------------------------------------------------------
+// The hash index finds a component by package and name without walking the list. Every bucket
+// holds the entries of its hash linked through their chain pointer, the newest first. A new
+// entry is pushed onto its bucket with a compare-and-swap. LoadRecords makes the index with a
+// bucket for every record of the link-time version table, at least VERSION_BUCKETS, before
+// anything is registered. A growing index can't be swapped without a lock, so plugins
+// registered later only make the chains longer. Without an index FindVersion walks the list.
+// --------------------------------------------------------------------------------------------
+#define VERSION_BUCKETS 16
+
+typedef struct {
+    size_t mask;            // Number of buckets minus one
+    Version* buckets[];     // The chains of entries
+} VersionIndex;
+
+static VersionIndex* versionIndex = NULL;
+
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegFramework(void) {
-    // For example, registering the framework itself with version 1.0.
-    RegisterVersion("Samael", "Framework", 0, 5);
+// The bounds of the link-time version table SAMAEL_VERSION fills. The linker defines them for
+// the section of this binary, they are weak so a binary without any record still links.
+// --------------------------------------------------------------------------------------------
+#if defined(_WIN32)
+    #define recordsStart ((const VersionRecord*)NULL)
+    #define recordsStop ((const VersionRecord*)NULL)
+#elif defined(__APPLE__)
+    extern const VersionRecord recordsStart[] __asm("section$start$__DATA$__samael_vers") __attribute__((weak));
+    extern const VersionRecord recordsStop[] __asm("section$end$__DATA$__samael_vers") __attribute__((weak));
+#else
+    extern const VersionRecord __start_samael_versions[] __attribute__((weak, visibility("hidden")));
+    extern const VersionRecord __stop_samael_versions[] __attribute__((weak, visibility("hidden")));
+    #define recordsStart __start_samael_versions
+    #define recordsStop __stop_samael_versions
+#endif
+
+// 0 before the records of the table are in the list, 1 while one thread puts them there, 2 after.
+static int recordsState = 0;
+
+// -------------------------------------------------------------------------------------------
+// HashVersion - 64 bit FNV-1a hash over package and component name, with a zero byte between
+// them so "A.B" + "C" and "A" + "B.C" don't collide by construction.
+//
+// @param packageIn - The name of the package.
+// @param nameIn    - The name of the component.
+// @return          - The hash.
+// -------------------------------------------------------------------------------------------
+static unsigned long long HashVersion(const char* packageIn, const char* nameIn) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (const char* c = packageIn; *c != '\0'; c++)
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    hash *= 1099511628211ULL;
+    for (const char* c = nameIn; *c != '\0'; c++)
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    return hash;
 }
 
+// -------------------------------------------------------------------------------------------
+// IndexVersion - Pushes an entry onto its bucket of the hash index.
+//
+// @param versionIn - The entry to add, already appended to the list.
+// -------------------------------------------------------------------------------------------
+static void IndexVersion(Version* versionIn) {
+    VersionIndex* index = __atomic_load_n(&versionIndex, __ATOMIC_ACQUIRE);
+    if (index == NULL) {
+        return;
+    }
+    Version** bucket = &index->buckets[HashVersion(versionIn->package, versionIn->name) & index->mask];
+    Version* first = __atomic_load_n(bucket, __ATOMIC_ACQUIRE);
+    do {
+        versionIn->chain = first;
+    } while (!__atomic_compare_exchange_n(bucket, &first, versionIn, 1, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+// -------------------------------------------------------------------------------------------
+// AppendVersion - Appends an entry to the list without a lock. The entry is linked behind the
+// entry whose tail is still NULL, then the snakeTail is moved on to it. A thread finding the
+// snakeTail behind moves it on first, so no append waits for another thread.
+//
+// @param versionIn - The entry, its tail NULL.
+// -------------------------------------------------------------------------------------------
+static void AppendVersion(Version* versionIn) {
+    for (;;) {
+        Version* last = __atomic_load_n(&snakeTail, __ATOMIC_ACQUIRE);
+        if (last == NULL) {
+            // The list is empty, or its first entry has no snakeTail yet.
+            Version* first = NULL;
+            if (__atomic_compare_exchange_n(&snakeHead, &first, versionIn, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+                __atomic_compare_exchange_n(&snakeTail, &last, versionIn, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+                return;
+            }
+            __atomic_compare_exchange_n(&snakeTail, &last, first, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        Version* next = __atomic_load_n(&last->tail, __ATOMIC_ACQUIRE);
+        if (next != NULL) {
+            __atomic_compare_exchange_n(&snakeTail, &last, next, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&last->tail, &next, versionIn, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+            __atomic_compare_exchange_n(&snakeTail, &last, versionIn, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------
+// LoadRecords - Turns the link-time version table into version entries, once, before the list
+// is read or RegisterVersion appends to it. The entries come from the pool of CreateVersion,
+// one after the other, and start the list, as if they had registered first. One thread does
+// the work, a thread coming along meanwhile waits the few microseconds until it is done.
+// -------------------------------------------------------------------------------------------
+static void LoadRecords(void) {
+    int state = __atomic_load_n(&recordsState, __ATOMIC_ACQUIRE);
+    if (state == 2) {
+        return;
+    }
+    if (state != 0 || !__atomic_compare_exchange_n(&recordsState, &state, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&recordsState, __ATOMIC_ACQUIRE) != 2) {
+            YieldThread();
+        }
+        return;
+    }
+
+    const VersionRecord* start = recordsStart;
+    const VersionRecord* stop = recordsStop;
+    size_t count = start != NULL && stop > start ? (size_t)(stop - start) : 0;
+    ReserveVersions((int)count);
+
+    size_t buckets = VERSION_BUCKETS;
+    while (buckets < count) {
+        buckets *= 2;
+    }
+    VersionIndex* index = calloc(1, sizeof(VersionIndex) + sizeof(Version*) * buckets);
+    if (index != NULL) {
+        index->mask = buckets - 1;
+        __atomic_store_n(&versionIndex, index, __ATOMIC_RELEASE);
+    }
+
+    Version* first = NULL;
+    Version* last = NULL;
+    for (size_t i = 0; i < count; i++) {
+        Version* entry = CreateVersion(start[i].package, start[i].name, start[i].major, start[i].minor);
+        if (entry == NULL) {
+            break;
+        }
+        if (last == NULL) {
+            first = entry;
+        } else {
+            last->tail = entry;
+        }
+        last = entry;
+        IndexVersion(entry);
+    }
+
+    // Nobody appended yet, everyone waits for this, so the list is still empty.
+    if (first != NULL) {
+        __atomic_store_n(&snakeHead, first, __ATOMIC_RELEASE);
+        __atomic_store_n(&snakeTail, last, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&recordsState, 2, __ATOMIC_RELEASE);
+}
+
+// -------------------------------------------------------------------------------------------
+// RegFramework - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
+// -------------------------------------------------------------------------------------------
+SAMAEL_VERSION(RegFramework, "Samael", "Framework", 0, 10);
+
 // -------------------------------------------------------------------------------------------
 // This function creates a new version entry with the specified package name, component name,
 // major version number, and minor version number. It initializes the version entry and
-// returns a pointer to the newly created Version structure.
+// returns a pointer to the newly created Version structure. Components linked into the
+// binary use SAMAEL_VERSION, this is for plugins and versions only known at runtime.
 //
 // @param packageIn  - The name of the framework or software package.
 // @param nameIn     - The name of the component or module.
@@ -79,22 +259,17 @@ __attribute__((constructor)) void RegFramework(void) {
 // -------------------------------------------------------------------------------------------
 void RegisterVersion(const char* packageIn, const char* nameIn, int majorIn, int minorIn) {
     
-    Version* newVersion = CreateVersion((char*)packageIn, (char*)nameIn, majorIn, minorIn);
+    // The records of the table come first, they also size the index and the string table.
+    LoadRecords();
+    Version* newVersion = CreateVersion(packageIn, nameIn, majorIn, minorIn);
     
     if (newVersion == NULL) {
         return;  // Alternatively, you could handle the error appropriately
     }
     
-    if (snakeHead == NULL) {
-        snakeHead = newVersion;
-    } else {
-        // Append at the end of the linked list
-        Version* current = snakeHead;
-        while (current->tail != NULL) {
-            current = current->tail;
-        }
-        current->tail = newVersion;
-    }
+    // Append at the end of the linked list, the tail pointer knows where it is.
+    AppendVersion(newVersion);
+    IndexVersion(newVersion);
 }
 
 // -------------------------------------------------------------------------------------------
@@ -105,71 +280,304 @@ void RegisterVersion(const char* packageIn, const char* nameIn, int majorIn, int
 // @return Version* - Pointer to the head of the linked list containing all registered versions.
 // -------------------------------------------------------------------------------------------
 const Version* GetVersionList(void) {
-    return snakeHead;
+    LoadRecords();
+    return __atomic_load_n(&snakeHead, __ATOMIC_ACQUIRE);
 }
 
 // -------------------------------------------------------------------------------------------
-// Generates a formatted string containing version information for the entire software project.
-// The function dynamically allocates memory for the output, ensuring sufficient space to store 
-// all registered components and packages in a structured, human-readable format.
-//
-// The returned string is dynamically allocated and must be freed by the caller when no longer needed.
+// FindVersion - Looks up the version entry of a component through the hash index of the
+// registry, without walking the list. Package entries are found with an empty name.
 //
-// @return A dynamically allocated string containing the version information. The caller is 
-//         responsible for freeing this memory.
+// @param packageIn - The name of the framework or software package.
+// @param nameIn    - The name of the component, "" for the package itself.
+// @return          - The version entry, NULL if nothing with that name is registered.
 // -------------------------------------------------------------------------------------------
-char* ToListString(void) {
-    
-    if (snakeHead == NULL) {
-        return strdup("");  // Return an empty string if no versions are registered
+const Version* FindVersion(const char* packageIn, const char* nameIn) {
+    LoadRecords();
+    if (packageIn == NULL || nameIn == NULL) {
+        return NULL;
     }
 
-    Version* current = snakeHead;
-    size_t totalSize = 1; // Start with space for the null terminator
+    VersionIndex* index = __atomic_load_n(&versionIndex, __ATOMIC_ACQUIRE);
+    if (index == NULL) {
+        const Version* current = __atomic_load_n(&snakeHead, __ATOMIC_ACQUIRE);
+        for (; current != NULL; current = __atomic_load_n(&current->tail, __ATOMIC_ACQUIRE)) {
+            if (strcmp(current->name, nameIn) == 0 && strcmp(current->package, packageIn) == 0) {
+                return current;
+            }
+        }
+        return NULL;
+    }
 
-    // First pass: Calculate required buffer size dynamically
-    while (current != NULL) {
-        if (strcmp(current->name, "") == 0) { 
-            // It's a package
-            totalSize += snprintf(NULL, 0, "\nPackage:   %s v%02d.%02d\n------------------------------\n",
-                                  current->package, current->major, current->minor);
-        } else { 
-            // It's a component
-            totalSize += snprintf(NULL, 0, "Component: %s.%s v%02d.%02d\n",
-                                  current->package, current->name, current->major, current->minor);
+    size_t bucket = HashVersion(packageIn, nameIn) & index->mask;
+    Version* first = __atomic_load_n(&index->buckets[bucket], __ATOMIC_ACQUIRE);
+    for (Version* current = first; current != NULL; current = current->chain) {
+        if (strcmp(current->name, nameIn) == 0 && strcmp(current->package, packageIn) == 0) {
+            return current;
         }
-        current = current->tail;
     }
+    return NULL;
+}
 
-    // Allocate the final buffer
-    char *bufferOut = malloc(totalSize);
-    if (bufferOut == NULL) {
-        perror("malloc failed");
-        return NULL;
+// -------------------------------------------------------------------------------------------
+// The ListWriter is the cursor the exporters write through. Every exporter runs twice over the
+// same entries: with a NULL cursor it only counts the bytes it would write, then it writes them
+// into one allocation of exactly that size. Nothing is formatted twice into temporary buffers
+// and nothing is appended by searching the end of the string, so the work is linear.
+// --------------------------------------------------------------------------------------------
+typedef struct {
+    char* cursor;   // The next byte to write, NULL to count only.
+    size_t size;    // Bytes written or counted so far.
+} ListWriter;
+
+// -------------------------------------------------------------------------------------------
+// WriteText - Writes a number of bytes through the cursor.
+//
+// @param writerIn  - The writer.
+// @param textIn    - The bytes.
+// @param lengthIn  - The number of bytes.
+// -------------------------------------------------------------------------------------------
+static void WriteText(ListWriter* writerIn, const char* textIn, size_t lengthIn) {
+    if (writerIn->cursor != NULL) {
+        memcpy(writerIn->cursor, textIn, lengthIn);
+        writerIn->cursor += lengthIn;
     }
-    bufferOut[0] = '\0';  // Ensure an empty string to start
+    writerIn->size += lengthIn;
+}
 
-    current = snakeHead;
+// -------------------------------------------------------------------------------------------
+// WriteNumber - Writes a number in decimal, with leading zeros up to the given digits, like
+// %02d does.
+//
+// @param writerIn  - The writer.
+// @param valueIn   - The number.
+// @param digitsIn  - The minimum number of digits.
+// -------------------------------------------------------------------------------------------
+static void WriteNumber(ListWriter* writerIn, int valueIn, int digitsIn) {
+    char digits[16];
+    int length = 0;
+    unsigned int value = valueIn < 0 ? 0u - (unsigned int)valueIn : (unsigned int)valueIn;
+    do {
+        digits[sizeof(digits) - 1 - length++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0 || length < digitsIn);
+    if (valueIn < 0) {
+        digits[sizeof(digits) - 1 - length++] = '-';
+    }
+    WriteText(writerIn, digits + sizeof(digits) - length, (size_t)length);
+}
 
-    // Second pass: Append formatted output
-    while (current != NULL) {
-        char lineBuffer[256];
+// -------------------------------------------------------------------------------------------
+// WriteJsonString - Writes a string as a JSON string literal, quotes, backslashes and control
+// characters escaped.
+//
+// @param writerIn  - The writer.
+// @param textIn    - The string.
+// -------------------------------------------------------------------------------------------
+static void WriteJsonString(ListWriter* writerIn, const char* textIn) {
+    static const char hex[] = "0123456789abcdef";
+    WriteText(writerIn, "\"", 1);
+    const char* run = textIn;
+    for (const char* c = textIn; ; c++) {
+        unsigned char ch = (unsigned char)*c;
+        if (ch != '\0' && ch != '"' && ch != '\\' && ch >= 0x20) {
+            continue;
+        }
+        WriteText(writerIn, run, (size_t)(c - run));
+        if (ch == '\0') {
+            break;
+        }
+        char escape[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 15] };
+        if (ch == '"' || ch == '\\') {
+            escape[1] = (char)ch;
+            WriteText(writerIn, escape, 2);
+        } else {
+            WriteText(writerIn, escape, 6);
+        }
+        run = c + 1;
+    }
+    WriteText(writerIn, "\"", 1);
+}
 
-        if (strcmp(current->name, "") == 0) {
+// -------------------------------------------------------------------------------------------
+// WriteUnsigned16 - Writes a 16 bit number in little endian byte order.
+//
+// @param writerIn  - The writer.
+// @param valueIn   - The number, cut to 16 bits.
+// -------------------------------------------------------------------------------------------
+static void WriteUnsigned16(ListWriter* writerIn, size_t valueIn) {
+    char bytes[2] = { (char)(valueIn & 0xff), (char)((valueIn >> 8) & 0xff) };
+    WriteText(writerIn, bytes, 2);
+}
+
+// -------------------------------------------------------------------------------------------
+// CountVersions - Counts the entries of the list. The exporters write exactly that many, so an
+// entry registered by another thread while they run can't change the size between counting
+// and writing.
+//
+// @param headIn    - The first entry.
+// @return          - The number of entries.
+// -------------------------------------------------------------------------------------------
+static size_t CountVersions(const Version* headIn) {
+    size_t count = 0;
+    for (const Version* current = headIn; current != NULL; current = __atomic_load_n(&current->tail, __ATOMIC_ACQUIRE)) {
+        count++;
+    }
+    return count;
+}
+
+// -------------------------------------------------------------------------------------------
+// WriteList - Writes the entries in the human-readable form of ToListString.
+//
+// @param writerIn  - The writer.
+// @param headIn    - The first entry.
+// @param countIn   - The number of entries.
+// -------------------------------------------------------------------------------------------
+static void WriteList(ListWriter* writerIn, const Version* headIn, size_t countIn) {
+    static const char line[] = "------------------------------\n";
+    const Version* current = headIn;
+    for (size_t i = 0; i < countIn; i++) {
+        if (current->name[0] == '\0') {
             // It's a package
-            snprintf(lineBuffer, sizeof(lineBuffer), "\nPackage:   %s v%02d.%02d\n------------------------------\n",
-                     current->package, current->major, current->minor);
+            WriteText(writerIn, "\nPackage:   ", 12);
+            WriteText(writerIn, current->package, strlen(current->package));
         } else {
             // It's a component
-            snprintf(lineBuffer, sizeof(lineBuffer), "Component: %s.%s v%02d.%02d\n",
-                     current->package, current->name, current->major, current->minor);
+            WriteText(writerIn, "Component: ", 11);
+            WriteText(writerIn, current->package, strlen(current->package));
+            WriteText(writerIn, ".", 1);
+            WriteText(writerIn, current->name, strlen(current->name));
         }
+        WriteText(writerIn, " v", 2);
+        WriteNumber(writerIn, current->major, 2);
+        WriteText(writerIn, ".", 1);
+        WriteNumber(writerIn, current->minor, 2);
+        WriteText(writerIn, "\n", 1);
+        if (current->name[0] == '\0') {
+            WriteText(writerIn, line, sizeof(line) - 1);
+        }
+        current = __atomic_load_n(&current->tail, __ATOMIC_ACQUIRE);
+    }
+}
 
-        strcat(bufferOut, lineBuffer);
-        current = current->tail;
+// -------------------------------------------------------------------------------------------
+// WriteJson - Writes the entries as a JSON array of objects.
+//
+// @param writerIn  - The writer.
+// @param headIn    - The first entry.
+// @param countIn   - The number of entries.
+// -------------------------------------------------------------------------------------------
+static void WriteJson(ListWriter* writerIn, const Version* headIn, size_t countIn) {
+    const Version* current = headIn;
+    WriteText(writerIn, "[", 1);
+    for (size_t i = 0; i < countIn; i++) {
+        WriteText(writerIn, i > 0 ? ",{\"package\":" : "{\"package\":", i > 0 ? 12 : 11);
+        WriteJsonString(writerIn, current->package);
+        WriteText(writerIn, ",\"name\":", 8);
+        WriteJsonString(writerIn, current->name);
+        WriteText(writerIn, ",\"major\":", 9);
+        WriteNumber(writerIn, current->major, 1);
+        WriteText(writerIn, ",\"minor\":", 9);
+        WriteNumber(writerIn, current->minor, 1);
+        WriteText(writerIn, "}", 1);
+        current = __atomic_load_n(&current->tail, __ATOMIC_ACQUIRE);
     }
+    WriteText(writerIn, "]", 1);
+}
 
-    return bufferOut;  // Caller must free this memory
+// -------------------------------------------------------------------------------------------
+// WriteBinary - Writes the entries in the binary form of ToBinary. A package or name longer
+// than its 16 bit length field is cut to 65535 bytes, the same in the counting pass.
+//
+// @param writerIn  - The writer.
+// @param headIn    - The first entry.
+// @param countIn   - The number of entries.
+// -------------------------------------------------------------------------------------------
+static void WriteBinary(ListWriter* writerIn, const Version* headIn, size_t countIn) {
+    const Version* current = headIn;
+    WriteText(writerIn, "SMV1", 4);
+    WriteUnsigned16(writerIn, countIn);
+    WriteUnsigned16(writerIn, countIn >> 16);
+    for (size_t i = 0; i < countIn; i++) {
+        size_t packageLength = strnlen(current->package, 0xffff);
+        size_t nameLength = strnlen(current->name, 0xffff);
+        WriteUnsigned16(writerIn, (size_t)current->major);
+        WriteUnsigned16(writerIn, (size_t)current->minor);
+        WriteUnsigned16(writerIn, packageLength);
+        WriteText(writerIn, current->package, packageLength);
+        WriteUnsigned16(writerIn, nameLength);
+        WriteText(writerIn, current->name, nameLength);
+        current = __atomic_load_n(&current->tail, __ATOMIC_ACQUIRE);
+    }
+}
+
+// -------------------------------------------------------------------------------------------
+// Export - Runs an exporter over all registered entries, first counting, then writing into one
+// allocation of the exact size, with a terminating zero byte behind the data.
+//
+// @param writeIn   - The exporter.
+// @param sizeOut   - Receives the number of bytes without the zero byte, may be NULL.
+// @return          - The data, NULL if out of memory. The caller frees it.
+// -------------------------------------------------------------------------------------------
+static char* Export(void (*writeIn)(ListWriter*, const Version*, size_t), size_t* sizeOut) {
+    const Version* head = GetVersionList();
+    size_t count = CountVersions(head);
+
+    ListWriter writer = { NULL, 0 };
+    writeIn(&writer, head, count);
+
+    char* bufferOut = malloc(writer.size + 1);
+    if (bufferOut == NULL) {
+        perror("malloc failed");
+        return NULL;
+    }
+    writer.cursor = bufferOut;
+    writer.size = 0;
+    writeIn(&writer, head, count);
+    *writer.cursor = '\0';
+
+    if (sizeOut != NULL) {
+        *sizeOut = writer.size;
+    }
+    return bufferOut;
+}
+
+// -------------------------------------------------------------------------------------------
+// Generates a formatted string containing version information for the entire software project.
+// The function dynamically allocates memory for the output, ensuring sufficient space to store 
+// all registered components and packages in a structured, human-readable format.
+//
+// The returned string is dynamically allocated and must be freed by the caller when no longer needed.
+//
+// @return A dynamically allocated string containing the version information. The caller is 
+//         responsible for freeing this memory.
+// -------------------------------------------------------------------------------------------
+char* ToListString(void) {
+    return Export(WriteList, NULL);
+}
+
+// -------------------------------------------------------------------------------------------
+// ToJsonString - Generates the version information of all registered components as a JSON
+// array, one object per entry: {"package":"Samael","name":"Framework","major":0,"minor":9}.
+// Package entries have an empty name.
+//
+// @return A dynamically allocated string, NULL if out of memory. The caller frees it.
+// -------------------------------------------------------------------------------------------
+char* ToJsonString(void) {
+    return Export(WriteJson, NULL);
+}
+
+// -------------------------------------------------------------------------------------------
+// ToBinary - Generates the version information of all registered components in a compact
+// binary form, all numbers little endian: the magic "SMV1", the number of entries (32 bit),
+// then per entry major, minor, package length (16 bit each), the package, the name length
+// (16 bit) and the name, without terminating zeros. Longer strings are cut to 65535 bytes.
+//
+// @param sizeOut   - Receives the number of bytes.
+// @return          - The data, NULL if out of memory. The caller frees it.
+// -------------------------------------------------------------------------------------------
+unsigned char* ToBinary(size_t* sizeOut) {
+    return (unsigned char*)Export(WriteBinary, sizeOut);
 }
 
 // -------------------------------------------------------------------------------------------
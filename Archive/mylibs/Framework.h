@@ -27,6 +27,11 @@
  * Mon 2025-04-07 Bugfix: Dynamically allocated string in toListString().       Version: 00.03
  * Mon 2025-04-07 Bugfix: Displaying package and component in toListString().   Version: 00.04
  * Mon 2025-04-07 Implemented all new Samael nameing conventions.               Version: 00.05
+ * Sat 2026-10-17 Tail pointer and hash index, FindVersion() in O(1).           Version: 00.06
+ * Sat 2026-10-17 SAMAEL_VERSION: version records in a link-time table.         Version: 00.07
+ * Sat 2026-10-17 Lock-free registry: atomic appends and bucket pushes.         Version: 00.08
+ * Sat 2026-10-17 Linear ToListString into one exact buffer, JSON and binary.   Version: 00.09
+ * Sat 2026-10-17 Version entries from the pool of CreateVersion.               Version: 00.10
  * ********************************************************************************************/
 
 #ifndef FRAMEWORK_H
@@ -45,16 +50,42 @@
 #endif
 
 // -------------------------------------------------------------------------------------------
-// RegFramework - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
+// SAMAEL_VERSION - Registers a component's version information with the versioning system of
+// the Samael framework, without running any code when the binary is loaded.
 //
-// This function is marked with the constructor attribute in the implementation file
-// (Framework.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// On ELF (Linux) and Mach-O (MacOS) systems the macro places a constant VersionRecord into the
+// samael_versions section. The linker collects the records of all components of a binary into
+// one table, the framework turns it into version entries the first time the list is asked for.
+// Windows has no such section support in every toolchain, there the macro falls back to a
+// constructor calling RegisterVersion.
+//
+// The table only holds the records linked into the same binary as Framework.c. A plugin loaded
+// later with dlopen registers itself with RegisterVersion instead.
+//
+// @param idIn      - A name unique to the component, like RegRotor.
+// @param packageIn - The name of the framework or software package, a string literal.
+// @param nameIn    - The name of the component, "" for the package itself.
+// @param majorIn   - The major version number.
+// @param minorIn   - The minor version number.
 // -------------------------------------------------------------------------------------------
-void RegFramework(void);
+#if defined(_WIN32)
+    #define SAMAEL_VERSION(idIn, packageIn, nameIn, majorIn, minorIn)                           \
+        __attribute__((constructor)) static void idIn(void) {                                   \
+            RegisterVersion(packageIn, nameIn, majorIn, minorIn);                               \
+        }
+#elif defined(__APPLE__)
+    #define SAMAEL_VERSION_SECTION __attribute__((used, section("__DATA,__samael_vers"), aligned(sizeof(void*))))
+#else
+    // The explicit alignment keeps the compiler from padding larger records to 16 or 32 bytes,
+    // the table has to be a plain array of them.
+    #define SAMAEL_VERSION_SECTION __attribute__((used, section("samael_versions"), aligned(sizeof(void*))))
+#endif
+
+#ifdef SAMAEL_VERSION_SECTION
+    #define SAMAEL_VERSION(idIn, packageIn, nameIn, majorIn, minorIn)                           \
+        static const VersionRecord idIn##Record SAMAEL_VERSION_SECTION =                        \
+            { packageIn, nameIn, majorIn, minorIn }
+#endif
 
 // -------------------------------------------------------------------------------------------
 // This function creates a new version entry with the specified package name, component name,
@@ -65,6 +96,9 @@ void RegFramework(void);
 // @param nameIn    - The name of the component or module.
 // @param majorIn   - The major version number.
 // @param minorIn   - The minor version number.
+//
+// RegisterVersion takes no lock and may be called from several threads at once, like plugins
+// loaded in parallel. Readers of the list see a consistent list at any time.
 // -------------------------------------------------------------------------------------------
 void RegisterVersion(const char* packageIn, const char* nameIn, int majorIn, int minorIn);
 
@@ -80,6 +114,26 @@ void RegisterVersion(const char* packageIn, const char* nameIn, int majorIn, int
 // -------------------------------------------------------------------------------------------
 char* ToListString(void);
 
+// -------------------------------------------------------------------------------------------
+// ToJsonString - Generates the version information of all registered components as a JSON
+// array, one object per entry: {"package":"Samael","name":"Framework","major":0,"minor":9}.
+// Package entries have an empty name.
+//
+// @return A dynamically allocated string, NULL if out of memory. The caller frees it.
+// -------------------------------------------------------------------------------------------
+char* ToJsonString(void);
+
+// -------------------------------------------------------------------------------------------
+// ToBinary - Generates the version information of all registered components in a compact
+// binary form, all numbers little endian: the magic "SMV1", the number of entries (32 bit),
+// then per entry major, minor, package length (16 bit each), the package, the name length
+// (16 bit) and the name, without terminating zeros. Longer strings are cut to 65535 bytes.
+//
+// @param sizeOut   - Receives the number of bytes.
+// @return          - The data, NULL if out of memory. The caller frees it.
+// -------------------------------------------------------------------------------------------
+unsigned char* ToBinary(size_t* sizeOut);
+
 // -------------------------------------------------------------------------------------------
 // This function prints the version information of all registered components.
 // It iterates through the linked list of version entries and prints the package name,
@@ -95,4 +149,15 @@ void PrintListString(void);
 // -------------------------------------------------------------------------------------------
 const Version* GetVersionList(void);
 
+// -------------------------------------------------------------------------------------------
+// FindVersion - Looks up the version entry of a component through the hash index of the
+// registry, without walking the list. Package entries are found with an empty name.
+//
+// @param packageIn - The name of the framework or software package.
+// @param nameIn    - The name of the component, "" for the package itself.
+// @return          - The version entry, NULL if nothing with that name is registered. If a
+//                    component registered twice, the latest registration is returned.
+// -------------------------------------------------------------------------------------------
+const Version* FindVersion(const char* packageIn, const char* nameIn);
+
 #endif
\ No newline at end of file
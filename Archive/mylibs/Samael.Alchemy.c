@@ -22,22 +22,14 @@
  * Wed 2025-03-26 File created.                                                 Version: 00.01
  * Sun 2025-04-06 Register package Alchemy with it's version number.            Version: 00.02
  * Mon 2025-04-07 Implemented all new Samael nameing conventions.               Version: 00.03
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.04
  * ********************************************************************************************/
 
 #include "Samael.h"
 #include "Samael.Alchemy.h"
 
 // -------------------------------------------------------------------------------------------
-// RegAlchemy - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.Alchemy.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegAlchemy - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegAlchemy(void) {
-    // Register the version information for the Samael.Alchemy component
-    RegisterVersion("Samael.Alchemy", "", 0, 3);
-}
\ No newline at end of file
+SAMAEL_VERSION(RegAlchemy, "Samael.Alchemy", "", 0, 4);
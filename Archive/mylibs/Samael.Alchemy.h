@@ -22,6 +22,7 @@
  * Wed 2025-03-26 File created.                                                 Version: 00.01
  * Sun 2025-04-06 Register package Alchemy with it's version number.            Version: 00.02
  * Mon 2025-04-07 Implemented all new Samael nameing conventions.               Version: 00.03
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.         Version: 00.04
  * ********************************************************************************************/
 
 #ifndef SAMAEL_ALCHEMY_H
@@ -39,16 +40,4 @@
 
 #endif
 
-// -------------------------------------------------------------------------------------------
-// RegAlchemy - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.Alchemy.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegAlchemy(void);
-
 #endif
\ No newline at end of file
@@ -23,22 +23,14 @@
  * Sun 2025-04-06 Register package Chronicle with it's version number.          Version: 00.02
  * Sun 2025-04-06 Added Componet Version to the package Chronicle.              Version: 00.03
  * Mon 2025-04-07 Implemented all new Samael nameing conventions.               Version: 00.04
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.05
  * ********************************************************************************************/
 
 #include "Samael.h"
 #include "Samael.Chronicle.h"
 
 // -------------------------------------------------------------------------------------------
-// RegChronicle - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.Chronicle.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegChronicle - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegChronicle(void) {
-    // Register the version information for the Samael.Chronicle component
-    RegisterVersion("Samael.Chronicle", "", 0, 4);
-}
\ No newline at end of file
+SAMAEL_VERSION(RegChronicle, "Samael.Chronicle", "", 0, 5);
@@ -22,22 +22,14 @@
  * Sun 2025-04-06 Register package HuginAndMunin with it's version number.      Version: 00.02
  * Mon 2025-04-07 Implemented the new Samael naming convention.                 Version: 00.03
  * Tue 2025-04-08 BugFix: RegisterVersion("HuginAndMunin", "", 0, 4);           version: 00.04
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.05
  * ********************************************************************************************/
 
 #include "Samael.h"
 #include "Samael.HuginAndMunin.h"
 
 // -------------------------------------------------------------------------------------------
-// regHuginAndMunin - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.HuginAndMunin.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegHuginAndMunin - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegHuginAndMunin(void) {
-    // Register the component with its version number.
-    RegisterVersion("Samael.HuginAndMunin", "", 0, 4);  // Version 00.04
-}
\ No newline at end of file
+SAMAEL_VERSION(RegHuginAndMunin, "Samael.HuginAndMunin", "", 0, 5);
@@ -22,6 +22,7 @@
  * Sun 2025-04-06 Register package HuginAndMunin with it's version number.      Version: 00.02
  * Mon 2025-04-07 Implemented the new Samael naming convention.                 Version: 00.03
  * Tue 2025-04-08 BugFix: RegisterVersion("HuginAndMunin", "", 0, 4);           version: 00.04
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.         Version: 00.05
  * ********************************************************************************************/
 
 #ifndef SAMAEL_HUGINANDMUNIN_H
@@ -39,16 +40,4 @@
 
 #endif
 
-// -------------------------------------------------------------------------------------------
-// regHuginAndMunin - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.HuginAndMunin.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegHuginAndMunin(void);
-
 #endif
\ No newline at end of file
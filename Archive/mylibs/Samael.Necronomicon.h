@@ -18,6 +18,7 @@
  * Sun 2025-04-06 Register package Necronomicon with it's version number.       Version: 00.02
  * Mon 2025-04-07 Implemented the Samael naming convention.                     Version: 00.03
  * Tue 2025-04-08 BugFix: RegisterVersion("Samael.Necronomicon", "", 0, 4);     Version: 00.04
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.         Version: 00.05
  * ********************************************************************************************/
 
 #ifndef SAMAEL_NECRONOMICON_H
@@ -35,16 +36,4 @@
 
 #endif
 
-// -------------------------------------------------------------------------------------------
-// regNecronomicon - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.Necronomicon.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegNecronomicon(void);
-
 #endif
\ No newline at end of file
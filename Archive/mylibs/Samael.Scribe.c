@@ -18,22 +18,14 @@
  * Sun 2025-04-06 Register package Scribe with it's version number.             Version: 00.02
  * Mon 2025-04-07 Implemented the Samael naming convention.                     Version: 00.03
  * Tue 2025-04-08 BugFix: RegisterVersion("Samael.Scribe", "", 0, 4);           Version: 00.04
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.05
  * ********************************************************************************************/
 
 #include "Samael.h"
 #include "Samael.Scribe.h"
 
 // -------------------------------------------------------------------------------------------
-// RegScribe - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.Entanglement.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegScribe - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegScribe(void) {
-    // Register the Scribe package with its version number.
-    RegisterVersion("Samael.Scribe", "", 0, 4);
-}
\ No newline at end of file
+SAMAEL_VERSION(RegScribe, "Samael.Scribe", "", 0, 5);
@@ -26,6 +26,7 @@
  * Sun 2025-04-06 Register package ToolBox with it's version number.            Version: 00.04
  * Mon 2025-04-07 Component StringAppend added to Samael.ToolBox.               Version: 00.05
  * Mon 2025-04-07 Implemented the Samael naming convention.                     Version: 00.06
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.         Version: 00.07
  * ********************************************************************************************/
 
 #ifndef SAMAEL_TOOLBOX_H
@@ -51,16 +52,4 @@
 
 #endif
 
-// -------------------------------------------------------------------------------------------
-// RegToolBox - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.c, which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegToolBox(void);
-
 #endif
\ No newline at end of file
@@ -21,21 +21,13 @@
  * Sun 2025-04-06 Added component Rotor to Samael.TowerOfBabel.                 Version: 00.03
  * Sun 2025-04-06 Register Samael.TowerOfBabel with Version Control.            Version: 00.04
  * Tue 2025-04-08 Implemented the Samael naming convention.                     Version: 00.05
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.06
  * ********************************************************************************************/
 #include "Samael.h"
 #include "Samael.TowerOfBabel.h"
 
 // -------------------------------------------------------------------------------------------
-// regCProgress - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.cProgress.c, which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegTowerOfBabel - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegTowerOfBabel(void) {
-    // Register the component with the version control system
-    RegisterVersion("Samael.TowerOfBabel", "", 0, 5);
-}
\ No newline at end of file
+SAMAEL_VERSION(RegTowerOfBabel, "Samael.TowerOfBabel", "", 0, 6);
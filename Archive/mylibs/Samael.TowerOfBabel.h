@@ -21,6 +21,7 @@
  * Sun 2025-04-06 Added component Rotor to Samael.TowerOfBabel.                 Version: 00.03
  * Sun 2025-04-06 Register Samael.TowerOfBabel with Version Control.            Version: 00.04
  * Tue 2025-04-08 Implemented the Samael naming convention.                     Version: 00.05
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.         Version: 00.06
  * ********************************************************************************************/
 #ifndef SAMAEL_TOWEROFBABEL_H
 #define SAMAEL_TOWEROFBABEL_H
@@ -41,16 +42,4 @@
 
 #endif
 
-// -------------------------------------------------------------------------------------------
-// regTowerOfBabel - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.TowerOfBabel.c, which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegTowerOfBabel(void);
-
 #endif
\ No newline at end of file
@@ -13,6 +13,7 @@
  * Mon 2025-04-07 File created.                                                 Version: 00.01
  * Sun 2025-04-06 Regiter the component with the frameworks versioning system.  Version: 00.02
  * Mon 2025-04-07 Changed All names to new Samael naming convention.            Version: 00.03
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.04
  * ********************************************************************************************/
 #include<stdio.h>
 #include<stdlib.h>
@@ -37,19 +38,10 @@
 #endif
 
 // -------------------------------------------------------------------------------------------
-// RegStringAppend - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.StringAppend.c, which means it will automatically be executed prior to the
-// execution of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon as
-// the module is loaded.
+// RegStringAppend - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegStringAppend(void) {
-    // Register the StringAppend package with its version number.
-    RegisterVersion("Samael.ToolBox", "StringAppend", 0, 3);
-}
+SAMAEL_VERSION(RegStringAppend, "Samael.ToolBox", "StringAppend", 0, 4);
 
 // --------------------------------------------------------------------------------------------
 // By encapsulating the process of appending formatted content within this method, we ensure a
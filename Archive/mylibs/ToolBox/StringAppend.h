@@ -13,22 +13,11 @@
  * Mon 2025-04-07 File created.                                                 Version: 00.01
  * Sun 2025-04-06 Regiter the component with the frameworks versioning system.  Version: 00.02
  * Mon 2025-04-07 Changed All names to new Samael naming convention.            Version: 00.03
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.         Version: 00.04
  * ********************************************************************************************/
 #ifndef STRING_APPEND_H
 #define STRING_APPEND_H
 
-// -------------------------------------------------------------------------------------------
-// RegStringAppend - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.StringAppend.c, which means it will automatically be executed prior to the
-// execution of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon as
-// the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegStringAppend(void);
-
 /* --------------------------------------------------------------------------------------------
  * By encapsulating the process of appending formatted content within this method, we ensure a
  * seamless and efficient way to dynamically build strings. This method not only enhances the
@@ -22,6 +22,7 @@
  * Mon 2025-04-07 append_format exluded to StringAppend.                                    Version: 00.09
  * Tue 2025-04-08 BugFix: RegisterVersion("Samael.ToolBox", "cManPage", 0, 10);             Version: 00.10
  * Tue 2025-04-08 BugFix: AppendFormat(&mp.filename, filenameIn);                           Version: 00.11
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.                     Version: 00.12
  * *****************************************************************************************************/
 #ifndef CMANPAGE_H
 #define CMANPAGE_H
@@ -42,18 +43,6 @@ typedef struct {
     char *manual;
 } ManPage;
 
-// -------------------------------------------------------------------------------------------
-// regCManPage - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.cManPage.c, which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void regCManPage(void);
-
 /* ----------------------------------------------------------------------------------------------------
  * By encapsulating the creation of manual pages within this method, we ensure a seamless and efficient
  * process for generating documentation. This not only enhances the maintainability and readability of
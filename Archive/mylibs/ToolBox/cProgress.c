@@ -22,6 +22,7 @@
  * Sun 2025-04-06 Moved to the ToolBox.                                                 Version: 00.08
  * Sun 2025-04-06 New versioning system implemented.                                    Version: 00.09
  * Tue 2025-04-08 BugFix: RegisterVersion("Samael.ToolBox", "cProgress", 0, 10);        Version: 00.10
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.                Version: 00.11
  * **************************************************************************************************/
 #include <stdio.h>
 
@@ -57,19 +58,10 @@
 const int DIVIDER = 60;     // The DIVIDER defines how many markers are seen in the progress bar.
 
 // -------------------------------------------------------------------------------------------
-// regCProgress - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.cProgress.c, which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// regCProgress - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void regCProgress(void) {
-    // Register the Progress package with its version number.
-    RegisterVersion("Samael.ToolBox", "cProgress", 0, 10); // BugFix: From registerVersion -> RegisterVersion Version 00.10
-}
+SAMAEL_VERSION(regCProgress, "Samael.ToolBox", "cProgress", 0, 11);
 
 // ***************************************************************************************************
 // With create_progress, setting up a sophisticated progress bar is effortless. This powerful function
@@ -23,6 +23,7 @@
  * Sun 2025-04-06 Moved to the ToolBox.                                                 Version: 00.08
  * Sun 2025-04-06 New versioning system implemented.                                    Version: 00.09
  * Tue 2025-04-08 BugFix: RegisterVersion("Samael.ToolBox", "cProgress", 0, 10);        Version: 00.10
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.                 Version: 00.11
  * **************************************************************************************************/
  #ifndef CPROGRESS_H
  #define CPROGRESS_H
@@ -51,18 +52,6 @@ typedef struct {
     int time;
 } Progress;
 
-// -------------------------------------------------------------------------------------------
-// regCProgress - Automatically registers this component's version information with the
-// versioning system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// Samael.ToolBox.cProgress.c, which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void regCProgress(void);
-
 // ***********************************************************************************************
 // With create_progress, setting up a sophisticated progress bar is effortless. This powerful
 // function encapsulates the essence of your task's progress, transforming it into a visually
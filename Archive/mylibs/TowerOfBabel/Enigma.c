@@ -38,6 +38,7 @@
  * Sun 2025-04-06 Renamed encrypt and decrypt to encryptChar and decryptChar.       Version: 00.05
  * Tue 2025-04-08 Implemented the new Samael naming conventions.                    Version: 00.06
  * Tue 2025-04-08 BugFix: RegisterVersion instead of registerVersion.               Version: 00.07
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.            Version: 00.08
  * ***********************************************************************************************/
 #include <stdio.h>
 #include <string.h>
@@ -58,18 +59,10 @@
 #endif
 
 // -------------------------------------------------------------------------------------------
-// RegEnigma - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.TowerOfBabel.Enigma.c), which means it will automatically be executed prior to the
-// execution of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegEnigma - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegEnigma(void) {
-    RegisterVersion("Samael.TowerOfBabel", "Enigma", 0, 7); // BugFix: RegisterVersion instead of registerVersion Version 00.07
-}
+SAMAEL_VERSION(RegEnigma, "Samael.TowerOfBabel", "Enigma", 0, 8);
 
 // -----------------------------------------------------------------------------------------------
 // Definition of the three rotors used in the Enigma machine. The small, medium, and large rotor
@@ -39,24 +39,13 @@
  * Sun 2025-04-06 Renamed encrypt and decrypt to encryptChar and decryptChar.       Version: 00.05
  * Tue 2025-04-08 Implemented the new Samael naming conventions.                    Version: 00.06
  * Tue 2025-04-08 BugFix: RegisterVersion instead of registerVersion.               Version: 00.07
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.             Version: 00.08
  * ***********************************************************************************************/
 #ifndef ENIGMA_H
 #define ENIGMA_H
 
 #include "Rotor.h"
 
-// -------------------------------------------------------------------------------------------
-// RegEnigma - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.TowerOfBabel.Enigma.c), which means it will automatically be executed prior to the
-// execution of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegEnigma(void);
-
 // -----------------------------------------------------------------------------------------------
 // These types are specifically used for the enigma cipher machine to identify the rotor type and
 // its mapping. A mapping is the sequence of values the rotor is using to work its magic. The enigma
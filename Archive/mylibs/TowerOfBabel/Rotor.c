@@ -26,6 +26,7 @@
  * Sun 2025-04-06 Register component with its version in the Samael Framework.      Version: 00.03
  * Tue 2025-04-08 Implemented the new Samael naming conventions.                    Version: 00.04
  * Tue 2025-04-08 BugFix: RegisterVersion instead of registerVersion.               Version: 00.05
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.            Version: 00.06
  * -----------------------------------------------------------------------------------------------
  * To Do:
  * - Change the rotor length to a dynamic value for more flexibility.
@@ -52,19 +53,10 @@
 int rotorLength = -1;
 
 // -------------------------------------------------------------------------------------------
-// RegRotor - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.TowerOfBabel.Rotor.c), which means it will automatically be executed prior to the
-// execution of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// RegRotor - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void RegRotor(void) {
-    // Register the component with its version information
-    RegisterVersion("Samael.TowerOfBabel", "Rotor", 0, 5);  // BugFix: RegisterVersion instead of registerVersion Version 00.05
-}
+SAMAEL_VERSION(RegRotor, "Samael.TowerOfBabel", "Rotor", 0, 6);
 
 // -----------------------------------------------------------------------------------------------
 // SetRotorLength - Set the rotor length to a specific value. This function is used to set the rotor
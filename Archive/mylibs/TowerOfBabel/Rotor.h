@@ -25,6 +25,7 @@
  * Thu 2025-03-27 Replaced the ROTOR_LENGTH with a dynamic value rotorLength.       Version: 00.02
  * Sun 2025-04-06 Register component with its version in the Samael Framework.      Version: 00.03
  * Tue 2025-04-08 Implemented the new Samael naming conventions.                    Version: 00.04
+ * Sat 2026-10-17 Registration moved to SAMAEL_VERSION, no constructor.             Version: 00.05
  * -----------------------------------------------------------------------------------------------
  * To Do:
  * - Change the rotor length to a dynamic value for more flexibility.
@@ -57,18 +58,6 @@ typedef struct {
     bool initialized;   // Tracks if the rotor is fully initialized
 } Rotor;
 
-// -------------------------------------------------------------------------------------------
-// RegRotor - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.TowerOfBabel.Rotor.c), which means it will automatically be executed prior to the
-// execution of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
-// -------------------------------------------------------------------------------------------
-void RegRotor(void);
-
 // -----------------------------------------------------------------------------------------------
 // SetRotorLength - Set the rotor length to a specific value. This function is used to set the rotor
 // length to a specific value. The rotor length is the number of characters in the rotor's mapping.
@@ -31,20 +31,13 @@
  * Thu 2025-03-27 Include all the modules for the Samael Framework.             Version: 00.05
  * Sun 2025-04-06 Register the Samael framework with it's version number.       Version: 00.06
  * Mon 2025-04-07 Implemented all new Samael nameing conventions.               Version: 00.07
+ * Sat 2026-10-17 Version record in the link-time table, no constructor.        Version: 00.08
  * ********************************************************************************************/
 
 #include "Samael.h"
 
 // -------------------------------------------------------------------------------------------
-// RegSamael - Automatically registers this component's version information with the versioning
-// system of the Samael framework.
-//
-// This function is marked with the constructor attribute in the implementation file
-// (Samael.c), which means it will automatically be executed prior to the execution
-// of the main() function. This pre-main invocation is part of the automatic versioning
-// mechanism, ensuring that the version details for this component are registered as soon
-// as the module is loaded.
+// regSamael - Registers this component's version information with the versioning system of
+// the Samael framework, as a record in the link-time version table.
 // -------------------------------------------------------------------------------------------
-__attribute__((constructor)) void regSamael(void) {
-    RegisterVersion("Samael", "", 0, 6);
-}
\ No newline at end of file
+SAMAEL_VERSION(regSamael, "Samael", "", 0, 8);
@@ -21,6 +21,15 @@
  * GitHub:  www.github.com/PatrikEigenmann/cpp
  * -------------------------------------------------------------------------------------------
  * Mon 2025-03-17 File created.                                                 Version: 00.01
+ * Sat 2026-10-17 Incremental builds: a state file maps sources to their        Version: 00.10
+ *                classes, only changed sources and the users of changed class
+ *                signatures are passed to javac.
+ * Sat 2026-10-17 src=@ walks the tree in process instead of running find,      Version: 00.11
+ *                skips ignore= directories and caches the directory listings.
+ * Sat 2026-10-17 server=yes / --server compiles through a resident javac       Version: 00.12
+ *                server over a loopback socket, jmake --stop ends it.
+ * Sat 2026-10-17 module= builds sibling projects first, ordered by their       Version: 00.13
+ *                classpaths, independent ones in parallel (-j), out= for javac -d.
  * -------------------------------------------------------------------------------------------
  * To Do's:
  * ********************************************************************************************/
@@ -30,12 +39,18 @@
 #include <stdarg.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 #ifdef _WIN32
     // Include Windows relevant libraries
     #include <io.h>
+    #include <direct.h>
     
     #define _home() getenv("USERPROFILE")
+    #define _makedir(p) _mkdir(p)
+    #define _mtime_ns(st) ((long long)(st).st_mtime * 1000000000LL)
 
     /* ----------------------------------------------------------------------------------------------------
      * Windows version:
@@ -107,8 +122,24 @@
 #else
     // Include Unix relevant libraries
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <sys/socket.h>
+    #include <sys/wait.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #ifdef __linux__
+        #include <sys/syscall.h>
+    #endif
 
     #define _home() getenv("HOME")
+    #define _makedir(p) mkdir(p, 0755)
+
+    #ifdef __APPLE__
+        #define _mtime_ns(st) ((long long)(st).st_mtimespec.tv_sec * 1000000000LL + (st).st_mtimespec.tv_nsec)
+    #else
+        #define _mtime_ns(st) ((long long)(st).st_mtim.tv_sec * 1000000000LL + (st).st_mtim.tv_nsec)
+    #endif
 
     /* -------------------------------------------------------------------------------------------------
      * MacOS version:
@@ -394,7 +425,7 @@ int isHelpTriggered(int argcIn, char *argvIn) {
 void print_help() {
 
     // Version control implemented
-    Version v = create_version(0, 9);
+    Version v = create_version(0, 13);
     
     // The buffer is needed to write
     // the correct formated version number.
@@ -420,7 +451,8 @@ void print_help() {
     append_format(&manpage, "       turnaround times and improved project management.\n");
     append_format(&manpage, "\n");
     append_format(&manpage, "SYNOPSIS\n");
-    append_format(&manpage, "       jmake <makefile>\n");
+    append_format(&manpage, "       jmake <makefile> [--full] [--server] [-j <jobs>]\n");
+    append_format(&manpage, "       jmake --stop\n");
     append_format(&manpage, "       jmake <-h\\-help\\-H\\-Help>\n");
     append_format(&manpage, "\n");
     append_format(&manpage, "DESCRIPTION\n");
@@ -446,7 +478,7 @@ void print_help() {
     append_format(&manpage, "           # Source files to compile, if left empty it will compile all java files\n");
     append_format(&manpage, "           # in the active folder by using *.java. or you can list the files to compile.\n");
     append_format(&manpage, "           # Or you can let jmake find all .java files in the active folder and subfolders.\n");
-    append_format(&manpage, "           # by using the @<source_file>.txt\n");
+    append_format(&manpage, "           # by using the @<source_file>.txt, no file is written for it.\n");
     append_format(&manpage, "           src=\n");
     append_format(&manpage, "\n");
     append_format(&manpage, "           # OR\n");
@@ -454,8 +486,53 @@ void print_help() {
     append_format(&manpage, "\n");
     append_format(&manpage, "           # OR\n");
     append_format(&manpage, "           src=@sources.txt (optional)\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           # Directories src=@ skips, hidden ones like .git are always skipped.\n");
+    append_format(&manpage, "           ignore=build out (optional)\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           # Compile through the resident compiler server, same as --server.\n");
+    append_format(&manpage, "           server=yes (optional)\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           # Directory javac -d writes the classes to, next to the sources if left out.\n");
+    append_format(&manpage, "           out=build/classes (optional)\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           # Makefiles of sibling projects to build before this one (optional).\n");
+    append_format(&manpage, "           module=core/core.jmake app/app.jmake\n");
     append_format(&manpage, "           ---------------------------------------\n");
     append_format(&manpage, "\n");
+    append_format(&manpage, "       jmake compiles incrementally. .jmake/<makefile>.state records the\n");
+    append_format(&manpage, "       stamp of every source, the classes javac made of it and the\n");
+    append_format(&manpage, "       classes of the project they reference (from their constant pools).\n");
+    append_format(&manpage, "       Only changed sources are compiled, then the users of every class\n");
+    append_format(&manpage, "       whose signatures changed, round by round. A changed constant\n");
+    append_format(&manpage, "       compiles everything, and the classes of removed sources are\n");
+    append_format(&manpage, "       deleted. The directory listings of src=@ are kept in the state\n");
+    append_format(&manpage, "       file as well, a directory is only read again once it changed.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       Every module= is a project with its own makefile, sources and out=.\n");
+    append_format(&manpage, "       It is built in its own directory after every module whose directory\n");
+    append_format(&manpage, "       or out= is on its classpath, modules that don't depend on each other\n");
+    append_format(&manpage, "       are built at the same time. When a module changes the api of a class,\n");
+    append_format(&manpage, "       the modules using it are compiled fully. The sources of the makefile\n");
+    append_format(&manpage, "       itself, if it has a src=, are built last.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --full\n");
+    append_format(&manpage, "              Compile every source, whatever the state file says.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --server\n");
+    append_format(&manpage, "              Compile through a compiler server that keeps javac warm in one\n");
+    append_format(&manpage, "              JVM. The first build writes it to .jmake/server, compiles and\n");
+    append_format(&manpage, "              starts it, later builds send their sources over a loopback\n");
+    append_format(&manpage, "              socket. It ends after 30 idle minutes. Unix only, without a\n");
+    append_format(&manpage, "              server javac is started as usual.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --stop\n");
+    append_format(&manpage, "              Stop the compiler server of the current directory.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       -j <jobs>\n");
+    append_format(&manpage, "              Build up to <jobs> modules at the same time, the default is\n");
+    append_format(&manpage, "              the number of cores.\n");
+    append_format(&manpage, "\n");
     append_format(&manpage, "       -h, -help -H -Help\n");
     append_format(&manpage, "              Display this help and exit.\n");
     append_format(&manpage, "\n");
@@ -475,138 +552,2295 @@ void print_help() {
     free(manpage);
 }
 
-/* ------------------------------------------------------------------------------------------------
- * The process_makefile function is a pivotal component of our custom "Make" program, designed to
- * streamline the build process by reading and executing commands from a specified makefile. This
- * function ensures efficient parsing and execution of build instructions, enhancing productivity
- * and simplifying project management for developers.
+/* ***************************************START INCREMENTAL BUILD****************************************** */
+
+/* --------------------------------------------------------------------------------------------------------
+ * A ClassFile is one .class file javac wrote for a source. Next to its name jmake keeps two hashes: the
+ * api hash covers everything other classes compile against (super types, non private fields and methods
+ * with their signatures), the constant hash covers the values of constant fields. javac copies these
+ * values into the classes using them without a reference back, so a changed constant rebuilds all.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *path;                     // The class file.
+    char *name;                     // The binary name, like com/example/Main$Inner.
+    unsigned long long api;         // Hash over the signatures other classes see.
+    unsigned long long constants;   // Hash over the values of constant fields.
+} ClassFile;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A SourceRecord is what jmake remembers about a source from the last build: its stamp, the classes it
+ * produced and the classes of the project those classes reference, read from their constant pools.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *path;             // The source file as listed for javac.
+    long long mtime;        // Modification time when it was compiled, -1 to compile it again.
+    long long size;         // Size when it was compiled.
+    ClassFile *classes;     // The classes javac produced from it.
+    int classCount;         // Number of classes.
+    char **refs;            // Binary names of the project classes it references.
+    int refCount;           // Number of references.
+    ClassFile *previous;    // The classes of the last build while the source is compiled again.
+    int previousCount;      // Number of previous classes.
+    int seen;               // 1 if the source is part of this build.
+    int dirty;              // 1 if it is compiled in this build.
+    int compiled;           // 1 once it was handed to javac in this build.
+} SourceRecord;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A DirListing is the cached content of a directory jmake looked for sources in. It is kept in the state
+ * file and trusted as long as the modification time of the directory is unchanged.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *path;             // The directory.
+    long long mtime;        // Modification time of the directory when it was read, -1 to read it again.
+    char **names;           // The entries without hidden ones, directories end in '/'.
+    int count;              // Number of entries.
+    int used;               // 1 if this build looked at it, only those are saved.
+} DirListing;
+
+typedef struct {
+    SourceRecord *sources;  // All sources, sorted by path.
+    int count;              // Number of sources.
+    DirListing *dirs;       // Directory listings, hashed by path.
+    int dirCount;           // Number of listings.
+    int dirSize;            // Number of slots in dirs, always a power of two.
+} JavaState;
+
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME  1099511628211ULL
+
+/* --------------------------------------------------------------------------------------------------------
+ * Continues a 64 bit FNV-1a hash over a block of memory.
  *
- * @param filename  The name of the makefile to be processed. This file contains the build instructions
- *                  to be executed.
- * ------------------------------------------------------------------------------------------------- */
-void process_makefile(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("fopen");
-        exit(EXIT_FAILURE);
+ * @param unsigned long long hashIn - The hash so far, FNV_OFFSET to start a new one.
+ * @param const void *dataIn        - The data to hash.
+ * @param size_t lengthIn           - The number of bytes.
+ * @return unsigned long long       - The updated hash.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long hash_bytes(unsigned long long hashIn, const void *dataIn, size_t lengthIn) {
+    const unsigned char *data = dataIn;
+    for (size_t i = 0; i < lengthIn; i++) {
+        hashIn ^= data[i];
+        hashIn *= FNV_PRIME;
     }
-    
-    char line[MAX_LINE_LENGTH];
-    char javac[MAX_LINE_LENGTH] = "";
-    char classpath[MAX_LINE_LENGTH * 4] = "";
-    char src[MAX_LINE_LENGTH * 4] = "";
-    bool in_classpath = false;
-    
-    while (fgets(line, sizeof(line), file)) {
-        // Trim newline character
-        line[strcspn(line, "\n")] = 0;
-                
-        // Parse javac directive
-        if (strncmp(line, "javac=", 6) == 0 && !in_classpath) {
-            strcpy(javac, line + 6);
-            if (strlen(javac) == 0) {
-                strcpy(javac, "javac"); // Default to system javac
-            }
+    return hashIn;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads the stamp of a file.
+ *
+ * @param const char *pathIn    - The file.
+ * @param long long *mtimeOut   - Receives the modification time in nanoseconds.
+ * @param long long *sizeOut    - Receives the size in bytes.
+ * @return int                  - 0 on success, -1 if the file doesn't exist.
+ * -------------------------------------------------------------------------------------------------------- */
+int stamp_file(const char *pathIn, long long *mtimeOut, long long *sizeOut) {
+    struct stat st;
+    if (stat(pathIn, &st) != 0)
+        return -1;
+    *mtimeOut = _mtime_ns(st);
+    *sizeOut = (long long)st.st_size;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads a whole file into memory.
+ *
+ * @param const char *pathIn    - The file.
+ * @param size_t *sizeOut       - Receives the size.
+ * @return unsigned char*       - The content, the caller frees it. NULL if the file can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned char *read_file(const char *pathIn, size_t *sizeOut) {
+    FILE *file = fopen(pathIn, "rb");
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    unsigned char *data = malloc(size > 0 ? size : 1);
+    *sizeOut = data ? fread(data, 1, size > 0 ? size : 0, file) : 0;
+    fclose(file);
+    return data;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds a class name to a list unless it is already there.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_name(char ***namesIn, int *countIn, const char *nameIn, size_t lengthIn) {
+    for (int i = 0; i < *countIn; i++)
+        if (strlen((*namesIn)[i]) == lengthIn && strncmp((*namesIn)[i], nameIn, lengthIn) == 0)
+            return;
+    *namesIn = realloc(*namesIn, sizeof(char *) * (*countIn + 1));
+    (*namesIn)[*countIn] = NULL;
+    append_format(&(*namesIn)[(*countIn)++], "%.*s", (int)lengthIn, nameIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds every class named in a field or method descriptor, like (Lcom/x/A;[Lcom/x/B;)V, to a list.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_descriptor_names(char ***namesIn, int *countIn, const char *descriptorIn, size_t lengthIn) {
+    for (size_t i = 0; i < lengthIn; i++) {
+        if (descriptorIn[i] != 'L')
+            continue;
+        size_t end = i + 1;
+        while (end < lengthIn && descriptorIn[end] != ';' && descriptorIn[end] != '<')
+            end++;
+        if (end < lengthIn)
+            add_name(namesIn, countIn, descriptorIn + i + 1, end - i - 1);
+        i = end;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Parses a class file: its name, the source it was compiled from (the SourceFile attribute), its api and
+ * constant hashes and every class it references through its constant pool, as class entry or inside a
+ * descriptor.
+ *
+ * @param const char *pathIn            - The class file.
+ * @param ClassFile *classOut           - Receives path, name and hashes.
+ * @param char **sourceFileOut          - Receives the file name of the source, NULL if not recorded.
+ * @param char ***refsIn                - The references, new ones are appended.
+ * @param int *refCountIn               - The number of references.
+ * @return int                          - 0 on success, -1 if the file is no valid class file.
+ * -------------------------------------------------------------------------------------------------------- */
+int read_class_file(const char *pathIn, ClassFile *classOut, char **sourceFileOut, char ***refsIn, int *refCountIn) {
+    size_t size = 0;
+    unsigned char *data = read_file(pathIn, &size);
+    *sourceFileOut = NULL;
+    if (data == NULL)
+        return -1;
+
+    #define U2(p) ((unsigned)data[p] << 8 | data[(p) + 1])
+    #define U4(p) ((unsigned long)U2(p) << 16 | U2((p) + 2))
+
+    int result = -1;
+    size_t *entries = NULL;
+    size_t p = 10;
+    classOut->path = NULL;
+    classOut->name = NULL;
+    if (size < 10 || U4(0) != 0xCAFEBABEUL)
+        goto done;
+
+    // The constant pool: remember where every entry starts, long and double take two slots. Every entry
+    // has to lie completely inside the file, a class file javac didn't finish writing is no class file.
+    unsigned count = U2(8);
+    entries = calloc(count + 1, sizeof(size_t));
+    for (unsigned i = 1; i < count; i++) {
+        size_t entrySize;
+        if (p >= size)
+            goto done;
+        switch (data[p]) {
+            case 1:  entrySize = p + 3 <= size ? 3 + U2(p + 1) : 3; break;
+            case 3: case 4: case 9: case 10: case 11: case 12: case 17: case 18: entrySize = 5; break;
+            case 5: case 6: entrySize = 9; break;
+            case 7: case 8: case 16: case 19: case 20: entrySize = 3; break;
+            case 15: entrySize = 4; break;
+            default: goto done;
         }
+        if (p + entrySize > size)
+            goto done;
+        entries[i] = p;
+        i += data[p] == 5 || data[p] == 6;
+        p += entrySize;
+    }
 
-        // Parse classpath directive
-        // Start processing a classpath block
-        if (strncmp(line, "classpath=", 10) == 0) {
-            in_classpath = true;
-            strcpy(classpath, line + 10);
-            if (classpath[0] == '@') {
-                // Handle @ directive for classpath
-                FILE *classpathFile = fopen(classpath + 1, "r");
-                if (classpathFile) {
-                    char path[MAX_LINE_LENGTH];
-                    classpath[0] = '\0'; // Reset classpath
-                    while (fgets(path, sizeof(path), classpathFile)) {
-                        path[strcspn(path, "\n")] = 0; // Trim newline characters
-                        if (path[0] == '#' || path[0] == '\0') continue; // Skip comments/empty lines
-                        if (strlen(classpath) > 0) strcat(classpath, ":");
-                        strcat(classpath, path);
-                    }
-                    fclose(classpathFile);
-                }
-                in_classpath = false; // Single-line directive is complete
+    // A utf8 entry as pointer and length, the name of a class entry resolved.
+    #define UTF8(i) ((i) > 0 && (i) < count && data[entries[i]] == 1 ? (const char *)data + entries[i] + 3 : "")
+    #define UTF8LEN(i) ((i) > 0 && (i) < count && data[entries[i]] == 1 ? U2(entries[i] + 1) : 0)
+    #define CLASSNAME(i) ((i) > 0 && (i) < count && data[entries[i]] == 7 ? U2(entries[i] + 1) : 0)
+
+    for (unsigned i = 1; i < count; i++) {
+        if (entries[i] == 0)
+            continue;
+        unsigned tag = data[entries[i]];
+        if (tag == 7) {
+            unsigned name = U2(entries[i] + 1);
+            if (UTF8(name)[0] == '[')
+                add_descriptor_names(refsIn, refCountIn, UTF8(name), UTF8LEN(name));
+            else
+                add_name(refsIn, refCountIn, UTF8(name), UTF8LEN(name));
+        } else if (tag == 12 || tag == 16) {
+            unsigned descriptor = U2(entries[i] + (tag == 12 ? 3 : 1));
+            add_descriptor_names(refsIn, refCountIn, UTF8(descriptor), UTF8LEN(descriptor));
+        }
+    }
+
+    if (p + 8 > size)
+        goto done;
+    unsigned long long api = hash_bytes(FNV_OFFSET, data + p, 2);
+    unsigned thisClass = CLASSNAME(U2(p + 2));
+    unsigned superClass = CLASSNAME(U2(p + 4));
+    append_format(&classOut->path, "%s", pathIn);
+    append_format(&classOut->name, "%.*s", (int)UTF8LEN(thisClass), UTF8(thisClass));
+    api = hash_bytes(api, UTF8(superClass), UTF8LEN(superClass) + 1);
+    unsigned interfaces = U2(p + 6);
+    p += 8;
+    if (p + 2 * (size_t)interfaces > size)
+        goto done;
+    for (unsigned i = 0; i < interfaces; i++, p += 2)
+        api = hash_bytes(api, UTF8(CLASSNAME(U2(p))), UTF8LEN(CLASSNAME(U2(p))) + 1);
+
+    // Fields and methods: private members don't belong to the api, their descriptors still reference.
+    unsigned long long constants = FNV_OFFSET;
+    for (int kind = 0; kind < 2; kind++) {
+        if (p + 2 > size)
+            goto done;
+        unsigned members = U2(p);
+        p += 2;
+        for (unsigned m = 0; m < members; m++) {
+            if (p + 8 > size)
+                goto done;
+            unsigned access = U2(p), name = U2(p + 2), descriptor = U2(p + 4), attributes = U2(p + 6);
+            int visible = !(access & 0x0002);
+            add_descriptor_names(refsIn, refCountIn, UTF8(descriptor), UTF8LEN(descriptor));
+            if (visible) {
+                api = hash_bytes(api, data + p, 2);
+                api = hash_bytes(api, UTF8(name), UTF8LEN(name) + 1);
+                api = hash_bytes(api, UTF8(descriptor), UTF8LEN(descriptor) + 1);
             }
-        } 
-        // Continue processing multi-line classpath block
-        else if (in_classpath) {
-            if (line[0] == '\0' || strncmp(line, "javac=", 6) == 0
-                || strncmp(line, "src=", 4) == 0
-                || strcmp(line, "# end of classpath") == 0) {
-                in_classpath = false; // End of classpath block
-            } else {
-                if (line[0] != '#') { // Skip comments/empty lines
-                    if (strlen(classpath) > 0) strcat(classpath, ":");
-                    strcat(classpath, line);
+            p += 8;
+            for (unsigned a = 0; a < attributes; a++) {
+                if (p + 6 > size)
+                    goto done;
+                unsigned attribute = U2(p);
+                unsigned long length = U4(p + 2);
+                if (p + 6 + length > size)
+                    goto done;
+                if (visible && length >= 2 && UTF8LEN(attribute) == 13 && strncmp(UTF8(attribute), "ConstantValue", 13) == 0) {
+                    unsigned value = U2(p + 6);
+                    constants = hash_bytes(constants, UTF8(name), UTF8LEN(name) + 1);
+                    if (value > 0 && value < count) {
+                        size_t entry = entries[value];
+                        size_t length = data[entry] == 5 || data[entry] == 6 ? 9 : data[entry] == 8 ? 3 : 5;
+                        constants = hash_bytes(constants, data + entry, length);
+                        if (data[entry] == 8)
+                            constants = hash_bytes(constants, UTF8(U2(entry + 1)), UTF8LEN(U2(entry + 1)));
+                    }
+                } else if (visible && length >= 2 && UTF8LEN(attribute) == 9 && strncmp(UTF8(attribute), "Signature", 9) == 0) {
+                    api = hash_bytes(api, UTF8(U2(p + 6)), UTF8LEN(U2(p + 6)) + 1);
                 }
+                p += 6 + length;
             }
         }
-        
-        // Parse src directive
-        else if (strncmp(line, "src=", 4) == 0 && !in_classpath) {
-            strcpy(src, line + 4);
-            if (strlen(src) == 0) {
-                strcpy(src, "*.java"); // Default to all .java files
-            } else if (src[0] == '@') {
-                // Generate sources.txt file
-                char create[MAX_LINE_LENGTH];
-                snprintf(create, sizeof(create), "find . -name \"*.java\" > %s", src + 1);
-                system(create);
-            }
+    }
+
+    // The class attributes, SourceFile names the source and Signature carries the generics.
+    if (p + 2 > size)
+        goto done;
+    unsigned attributes = U2(p);
+    p += 2;
+    for (unsigned a = 0; a < attributes; a++) {
+        if (p + 6 > size)
+            goto done;
+        unsigned attribute = U2(p);
+        unsigned long length = U4(p + 2);
+        if (p + 6 + length > size)
+            goto done;
+        if (UTF8LEN(attribute) == 10 && strncmp(UTF8(attribute), "SourceFile", 10) == 0 && length >= 2)
+            append_format(sourceFileOut, "%.*s", (int)UTF8LEN(U2(p + 6)), UTF8(U2(p + 6)));
+        else if (UTF8LEN(attribute) == 9 && strncmp(UTF8(attribute), "Signature", 9) == 0 && length >= 2)
+            api = hash_bytes(api, UTF8(U2(p + 6)), UTF8LEN(U2(p + 6)) + 1);
+        p += 6 + length;
+    }
+
+    classOut->api = api;
+    classOut->constants = constants;
+    result = 0;
+
+    #undef CLASSNAME
+    #undef UTF8LEN
+    #undef UTF8
+    #undef U4
+    #undef U2
+done:
+    if (result != 0) {
+        free(classOut->path);
+        free(classOut->name);
+        free(*sourceFileOut);
+        *sourceFileOut = NULL;
+    }
+    free(entries);
+    free(data);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The state file lives in .jmake/ next to the makefile and is named after it.
+ *
+ * @param const char *makefileIn - The path of the makefile.
+ * @return char*                 - The path of the state file, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *state_path(const char *makefileIn) {
+    char *path = NULL;
+    const char *slash = strrchr(makefileIn, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(makefileIn, '\\');
+    if (backslash > slash) slash = backslash;
+#endif
+
+    if (slash != NULL)
+        append_format(&path, "%.*s/.jmake/%s.state", (int)(slash - makefileIn), makefileIn, slash + 1);
+    else
+        append_format(&path, ".jmake/%s.state", makefileIn);
+    return path;
+}
+
+int compare_sources(const void *aIn, const void *bIn) {
+    return strcmp(((const SourceRecord *)aIn)->path, ((const SourceRecord *)bIn)->path);
+}
+
+int compare_strings(const void *aIn, const void *bIn) {
+    return strcmp(*(char *const *)aIn, *(char *const *)bIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the record of a source.
+ *
+ * @param JavaState *stateIn    - The state, sorted by path.
+ * @param const char *pathIn    - The source.
+ * @return SourceRecord*        - The record, NULL if the source is new.
+ * -------------------------------------------------------------------------------------------------------- */
+SourceRecord *find_source(JavaState *stateIn, const char *pathIn) {
+    SourceRecord key = {0};
+    key.path = (char *)pathIn;
+    return stateIn->count ? bsearch(&key, stateIn->sources, stateIn->count, sizeof(SourceRecord), compare_sources) : NULL;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Releases a list of classes.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_classes(ClassFile *classesIn, int countIn) {
+    for (int i = 0; i < countIn; i++) {
+        free(classesIn[i].path);
+        free(classesIn[i].name);
+    }
+    free(classesIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds an entry to a directory listing. Directories get a trailing '/', an entry of unknown type is
+ * stat'ed to find out. Hidden entries like .git/ and .jmake/ are left out.
+ *
+ * @param char ***namesIn       - The entries so far.
+ * @param int *countIn          - The number of entries.
+ * @param const char *dirIn     - The directory, to stat entries of unknown type.
+ * @param const char *nameIn    - The name of the entry.
+ * @param int isDirIn           - 1 for a directory, 0 for anything else, -1 if unknown.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_entry(char ***namesIn, int *countIn, const char *dirIn, const char *nameIn, int isDirIn) {
+    if (nameIn[0] == '.')
+        return;
+
+    if (isDirIn < 0) {
+        char *path = NULL;
+        append_format(&path, "%s/%s", dirIn, nameIn);
+        struct stat st;
+        isDirIn = stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+        free(path);
+    }
+
+    if (*countIn == 0 || (*countIn >= 16 && (*countIn & (*countIn - 1)) == 0)) {
+        char **grown = realloc(*namesIn, sizeof(char *) * (*countIn ? *countIn * 2 : 16));
+        if (grown == NULL)
+            return;
+        *namesIn = grown;
+    }
+    (*namesIn)[*countIn] = NULL;
+    append_format(&(*namesIn)[(*countIn)++], "%s%s", nameIn, isDirIn ? "/" : "");
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads the entries of a directory. Linux reads the raw getdents64 records in large batches, they carry
+ * the type of every entry and no entry needs a stat() of its own. Elsewhere readdir() does the same job.
+ *
+ * @param const char *dirIn     - The directory.
+ * @param char ***namesOut      - Receives the entries, the caller frees every entry and the array.
+ * @param int *countOut         - Receives the number of entries.
+ * @return int                  - 0 on success, -1 if the directory can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int read_directory(const char *dirIn, char ***namesOut, int *countOut) {
+    *namesOut = NULL;
+    *countOut = 0;
+
+#ifdef __linux__
+    int fd = open(dirIn, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    // The layout of the records the kernel writes.
+    struct linux_dirent64 {
+        unsigned long long ino;
+        long long offset;
+        unsigned short length;
+        unsigned char type;
+        char name[];
+    };
+
+    long long buffer[4096];
+    long n;
+    while ((n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0) {
+        for (long offset = 0; offset < n; ) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)((char *)buffer + offset);
+            add_entry(namesOut, countOut, dirIn, entry->name,
+                      entry->type == DT_UNKNOWN || entry->type == DT_LNK ? -1 : entry->type == DT_DIR);
+            offset += entry->length;
         }
     }
-    
-    fclose(file);
+    close(fd);
+    if (n < 0)
+        return -1;
+#else
+    DIR *dir = opendir(dirIn);
+    if (dir == NULL)
+        return -1;
 
-    char *command = NULL;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        #ifdef DT_DIR
+            // Unix version
+            add_entry(namesOut, countOut, dirIn, entry->d_name,
+                      entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK ? -1 : entry->d_type == DT_DIR);
+        #else
+            // Windows version
+            add_entry(namesOut, countOut, dirIn, entry->d_name, -1);
+        #endif
+    }
+    closedir(dir);
+#endif
+
+    qsort(*namesOut, *countOut, sizeof(char *), compare_strings);
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the cached listing of a directory, or adds an empty one that is read on first use.
+ *
+ * @param JavaState *stateIn    - The state with the listings.
+ * @param const char *pathIn    - The directory.
+ * @return DirListing*          - The listing, valid until the next lookup of a new directory.
+ * -------------------------------------------------------------------------------------------------------- */
+DirListing *dir_listing(JavaState *stateIn, const char *pathIn) {
 
-    append_format(&command, "%s ", javac);
+    if (stateIn->dirCount * 2 >= stateIn->dirSize) {
+        int size = stateIn->dirSize ? stateIn->dirSize * 2 : 64;
+        DirListing *dirs = calloc(size, sizeof(DirListing));
+        if (dirs == NULL) {
+            perror("calloc failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < stateIn->dirSize; i++) {
+            if (stateIn->dirs[i].path == NULL)
+                continue;
+            const char *path = stateIn->dirs[i].path;
+            unsigned long long slot = hash_bytes(FNV_OFFSET, path, strlen(path)) & (size - 1);
+            while (dirs[slot].path != NULL)
+                slot = (slot + 1) & (size - 1);
+            dirs[slot] = stateIn->dirs[i];
+        }
+        free(stateIn->dirs);
+        stateIn->dirs = dirs;
+        stateIn->dirSize = size;
+    }
 
-    if(classpath[0] != '\0')
-        append_format(&command, "-cp %s ", classpath);
+    unsigned long long slot = hash_bytes(FNV_OFFSET, pathIn, strlen(pathIn)) & (stateIn->dirSize - 1);
+    while (stateIn->dirs[slot].path != NULL) {
+        if (strcmp(stateIn->dirs[slot].path, pathIn) == 0)
+            return &stateIn->dirs[slot];
+        slot = (slot + 1) & (stateIn->dirSize - 1);
+    }
 
-    if(src[0] != '\0')
-        append_format(&command, "%s ", src);
+    DirListing *listing = &stateIn->dirs[slot];
+    append_format(&listing->path, "%s", pathIn);
+    listing->mtime = -1;
+    stateIn->dirCount++;
+    return listing;
+}
 
-    printf("Compiling command:\n");
-    printf("%s\n", command);
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the listing of a directory, from the state as long as the modification time of the directory
+ * is the recorded one, because creating, deleting or renaming an entry changes it. Otherwise the
+ * directory is read again. A directory modified in the last two seconds is read but not trusted next
+ * time, a file created in the same clock tick wouldn't change the time again.
+ *
+ * @param JavaState *stateIn    - The state with the listings.
+ * @param const char *dirIn     - The directory.
+ * @return DirListing*          - The listing, NULL if the directory can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+DirListing *list_directory(JavaState *stateIn, const char *dirIn) {
+    struct stat st;
+    if (stat(dirIn, &st) != 0 || !S_ISDIR(st.st_mode))
+        return NULL;
+    long long mtime = _mtime_ns(st);
+
+    DirListing *listing = dir_listing(stateIn, dirIn);
+    listing->used = 1;
+    if (listing->mtime == mtime)
+        return listing;
+
+    for (int i = 0; i < listing->count; i++)
+        free(listing->names[i]);
+    free(listing->names);
+    if (read_directory(dirIn, &listing->names, &listing->count) != 0)
+        return NULL;
+    listing->mtime = (long long)time(NULL) * 1000000000LL - mtime < 2000000000LL ? -1 : mtime;
+    return listing;
+}
 
-    // Execute the command
-    int result = system(command);
+/* --------------------------------------------------------------------------------------------------------
+ * Collects every .java file below a directory, like find . -name "*.java" did, without the directories
+ * of ignore=. Unchanged directories come from the cached listings, so only the stat() of every directory
+ * remains.
+ *
+ * @param JavaState *stateIn    - The state with the listings.
+ * @param const char *dirIn     - The directory, "." to start.
+ * @param char **ignoreIn       - Names of directories to skip, like build or out.
+ * @param int ignoreCountIn     - Number of names.
+ * @param char ***sourcesIn     - The sources, new ones are appended.
+ * @param int *countIn          - The number of sources.
+ * -------------------------------------------------------------------------------------------------------- */
+void walk_sources(JavaState *stateIn, const char *dirIn, char **ignoreIn, int ignoreCountIn, char ***sourcesIn,
+                  int *countIn) {
+    DirListing *listing = list_directory(stateIn, dirIn);
+    if (listing == NULL)
+        return;
 
-    // clean up
-    if(src[0] == '@') {
-        char del[MAX_LINE_LENGTH];
-        snprintf(del, sizeof(del), "rm %s", src + 1);
-        system(del);
+    // The listing moves when the recursion adds directories, the subdirectories are collected first.
+    char **subdirs = NULL;
+    int subdirCount = 0;
+    for (int i = 0; i < listing->count; i++) {
+        const char *name = listing->names[i];
+        size_t length = strlen(name);
+        if (name[length - 1] == '/') {
+            int ignored = 0;
+            for (int g = 0; g < ignoreCountIn && !ignored; g++)
+                ignored = strlen(ignoreIn[g]) == length - 1 && strncmp(ignoreIn[g], name, length - 1) == 0;
+            if (!ignored) {
+                subdirs = realloc(subdirs, sizeof(char *) * (subdirCount + 1));
+                subdirs[subdirCount] = NULL;
+                append_format(&subdirs[subdirCount++], "%s/%.*s", dirIn, (int)(length - 1), name);
+            }
+        } else if (length > 5 && strcmp(name + length - 5, ".java") == 0) {
+            *sourcesIn = realloc(*sourcesIn, sizeof(char *) * (*countIn + 1));
+            (*sourcesIn)[*countIn] = NULL;
+            append_format(&(*sourcesIn)[(*countIn)++], "%s/%s", dirIn, name);
+        }
     }
 
-    if (result != 0) {
-        fprintf(stderr, "Command failed: %s\n", command);
-        exit(EXIT_FAILURE);
+    for (int i = 0; i < subdirCount; i++) {
+        walk_sources(stateIn, subdirs[i], ignoreIn, ignoreCountIn, sourcesIn, countIn);
+        free(subdirs[i]);
     }
+    free(subdirs);
 }
 
-// ---------------------------------------------------------------------------------------------
-// main - The main function is the starting point of a C or C++ program, where execution begins.
-// This version of the main function allows the program to take command-line arguments when it
-// runs. The function typically returns an numbered value to the operating system, often zero
-// to signify successful execution.
-//
-// @param argc  The number of command-line arguments.
-// @param argv  The array of command-line arguments.
-// @return      0 on successful completion, 1 on error.
-// ----------------------------------------------------------------------------------------------
-int main (int argc, char **argv) {
-    // Check if the help is triggered.
-    if(isHelpTriggered(argc, argv[1])) {
-        print_help();
-        return 1;
+/* --------------------------------------------------------------------------------------------------------
+ * Reads a G line of the state file back into its listing.
+ *
+ * @param JavaState *stateIn    - The state.
+ * @param char *lineIn          - The line behind "G\t": directory, mtime and entries, tab separated.
+ * -------------------------------------------------------------------------------------------------------- */
+void load_listing(JavaState *stateIn, char *lineIn) {
+    char *mtime = strchr(lineIn, '\t');
+    if (mtime == NULL)
+        return;
+    *mtime++ = '\0';
+
+    DirListing *listing = dir_listing(stateIn, lineIn);
+    listing->mtime = strtoll(mtime, NULL, 10);
+    for (char *entry = strchr(mtime, '\t'); entry != NULL; ) {
+        *entry++ = '\0';
+        char *next = strchr(entry, '\t');
+        if (next != NULL)
+            *next = '\0';
+        size_t length = strlen(entry);
+        int isDir = length > 0 && entry[length - 1] == '/';
+        if (isDir)
+            entry[length - 1] = '\0';
+        add_entry(&listing->names, &listing->count, listing->path, entry, isDir);
+        entry = next;
     }
+}
 
-    process_makefile(argv[1]);
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+/* --------------------------------------------------------------------------------------------------------
+ * Loads the state file. Every line is one tab separated entry:
+ *   S <source> <mtime> <size>
+ *   C <class file> <binary name> <api hash> <constant hash>
+ *   R <binary name>
+ *   G <directory> <mtime> <entry> <entry> ...
+ * The C and R lines follow the S line of their source, a G line is the listing of a directory. A
+ * missing file gives an empty state, which compiles everything.
+ *
+ * @param const char *pathIn    - The state file.
+ * @param JavaState *stateOut   - The state to fill.
+ * -------------------------------------------------------------------------------------------------------- */
+void load_java_state(const char *pathIn, JavaState *stateOut) {
+    memset(stateOut, 0, sizeof(JavaState));
+
+    size_t size = 0;
+    char *text = (char *)read_file(pathIn, &size);
+    if (text == NULL)
+        return;
+    text = realloc(text, size + 1);
+    text[size] = '\0';
+
+    SourceRecord *current = NULL;
+    for (char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        if (line[0] == 'G' && line[1] == '\t') {
+            load_listing(stateOut, line + 2);
+            continue;
+        }
+
+        char *fields[5] = { line, "", "", "", "" };
+        for (int n = 1; n < 5; n++) {
+            char *tab = strchr(fields[n - 1], '\t');
+            if (tab == NULL)
+                break;
+            *tab = '\0';
+            fields[n] = tab + 1;
+        }
+
+        if (strcmp(fields[0], "S") == 0) {
+            stateOut->sources = realloc(stateOut->sources, sizeof(SourceRecord) * (stateOut->count + 1));
+            current = &stateOut->sources[stateOut->count++];
+            memset(current, 0, sizeof(SourceRecord));
+            append_format(&current->path, "%s", fields[1]);
+            current->mtime = strtoll(fields[2], NULL, 10);
+            current->size = strtoll(fields[3], NULL, 10);
+        } else if (strcmp(fields[0], "C") == 0 && current != NULL) {
+            current->classes = realloc(current->classes, sizeof(ClassFile) * (current->classCount + 1));
+            ClassFile *classFile = &current->classes[current->classCount++];
+            memset(classFile, 0, sizeof(ClassFile));
+            append_format(&classFile->path, "%s", fields[1]);
+            append_format(&classFile->name, "%s", fields[2]);
+            classFile->api = strtoull(fields[3], NULL, 16);
+            classFile->constants = strtoull(fields[4], NULL, 16);
+        } else if (strcmp(fields[0], "R") == 0 && current != NULL) {
+            add_name(&current->refs, &current->refCount, fields[1], strlen(fields[1]));
+        }
+    }
+    free(text);
+
+    qsort(stateOut->sources, stateOut->count, sizeof(SourceRecord), compare_sources);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes the records of all sources of this build to the state file. References to classes outside the
+ * project, like java/lang/String, are dropped, they never change through a build, and so are references
+ * of a source to its own classes. The file is written under a temporary name and renamed.
+ *
+ * @param const char *pathIn    - The state file.
+ * @param JavaState *stateIn    - The state to save.
+ * -------------------------------------------------------------------------------------------------------- */
+void save_java_state(const char *pathIn, JavaState *stateIn) {
+    // All class names of the project, sorted for the lookup of references.
+    char **names = NULL;
+    int nameCount = 0;
+    for (int i = 0; i < stateIn->count; i++) {
+        names = realloc(names, sizeof(char *) * (nameCount + stateIn->sources[i].classCount + 1));
+        for (int c = 0; c < stateIn->sources[i].classCount; c++)
+            names[nameCount++] = stateIn->sources[i].classes[c].name;
+    }
+    qsort(names, nameCount, sizeof(char *), compare_strings);
+
+    char *temp = NULL;
+    append_format(&temp, "%s.tmp", pathIn);
+    FILE *file = fopen(temp, "w");
+    if (file == NULL) {
+        perror(temp);
+        free(temp);
+        free(names);
+        return;
+    }
+
+    for (int i = 0; i < stateIn->count; i++) {
+        SourceRecord *record = &stateIn->sources[i];
+        if (!record->seen)
+            continue;
+        fprintf(file, "S\t%s\t%lld\t%lld\n", record->path, record->mtime, record->size);
+        for (int c = 0; c < record->classCount; c++)
+            fprintf(file, "C\t%s\t%s\t%016llx\t%016llx\n", record->classes[c].path, record->classes[c].name,
+                    record->classes[c].api, record->classes[c].constants);
+        for (int r = 0; r < record->refCount; r++) {
+            int own = 0;
+            for (int c = 0; c < record->classCount && !own; c++)
+                own = strcmp(record->refs[r], record->classes[c].name) == 0;
+            if (!own && nameCount > 0 && bsearch(&record->refs[r], names, nameCount, sizeof(char *), compare_strings))
+                fprintf(file, "R\t%s\n", record->refs[r]);
+        }
+    }
+
+    for (int i = 0; i < stateIn->dirSize; i++) {
+        DirListing *listing = &stateIn->dirs[i];
+        if (listing->path == NULL || !listing->used || listing->mtime < 0)
+            continue;
+        fprintf(file, "G\t%s\t%lld", listing->path, listing->mtime);
+        for (int n = 0; n < listing->count; n++)
+            fprintf(file, "\t%s", listing->names[n]);
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    remove(pathIn);
+    rename(temp, pathIn);
+    free(temp);
+    free(names);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Releases all memory of the state.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_java_state(JavaState *stateIn) {
+    for (int i = 0; i < stateIn->count; i++) {
+        SourceRecord *record = &stateIn->sources[i];
+        free(record->path);
+        free_classes(record->classes, record->classCount);
+        free_classes(record->previous, record->previousCount);
+        for (int r = 0; r < record->refCount; r++)
+            free(record->refs[r]);
+        free(record->refs);
+    }
+    free(stateIn->sources);
+    for (int i = 0; i < stateIn->dirSize; i++) {
+        for (int n = 0; n < stateIn->dirs[i].count; n++)
+            free(stateIn->dirs[i].names[n]);
+        free(stateIn->dirs[i].names);
+        free(stateIn->dirs[i].path);
+    }
+    free(stateIn->dirs);
+    memset(stateIn, 0, sizeof(JavaState));
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Lists the sources of src=. A word like *.java stands for the files with that ending in the current
+ * directory, or in the directory in front of it. @<name> stands for every .java file below the current
+ * directory, found by walking the tree in process, the name is only kept for older makefiles.
+ *
+ * @param JavaState *stateIn    - The state with the cached listings.
+ * @param const char *srcIn     - The value of src=.
+ * @param const char *ignoreIn  - The value of ignore=, directories the walk skips.
+ * @param char ***sourcesOut    - Receives the sources, the caller frees every entry and the array.
+ * @return int                  - The number of sources.
+ * -------------------------------------------------------------------------------------------------------- */
+int list_sources(JavaState *stateIn, const char *srcIn, const char *ignoreIn, char ***sourcesOut) {
+    char **sources = NULL;
+    int count = 0;
+
+    char *ignoreWords = NULL;
+    append_format(&ignoreWords, "%s", ignoreIn);
+    char **ignore = NULL;
+    int ignoreCount = 0;
+    for (char *word = strtok(ignoreWords, " \t"); word != NULL; word = strtok(NULL, " \t")) {
+        ignore = realloc(ignore, sizeof(char *) * (ignoreCount + 1));
+        ignore[ignoreCount++] = word;
+    }
+
+    char *words = NULL;
+    append_format(&words, "%s", srcIn);
+    for (char *word = strtok(words, " \t"); word != NULL; word = strtok(NULL, " \t")) {
+        if (word[0] == '@') {
+            walk_sources(stateIn, ".", ignore, ignoreCount, &sources, &count);
+            continue;
+        }
+
+        char *star = strchr(word, '*');
+        if (star == NULL) {
+            sources = realloc(sources, sizeof(char *) * (count + 1));
+            sources[count] = NULL;
+            append_format(&sources[count++], "%s", word);
+            continue;
+        }
+
+        // A pattern: the directory in front of the star, the ending behind it.
+        char *slash = strrchr(word, '/');
+        char *directory = NULL;
+        append_format(&directory, "%.*s", slash ? (int)(slash - word) : 1, slash ? word : ".");
+        const char *ending = star + 1;
+        size_t endingLength = strlen(ending);
+        DirListing *listing = list_directory(stateIn, directory);
+        for (int i = 0; listing != NULL && i < listing->count; i++) {
+            const char *name = listing->names[i];
+            size_t length = strlen(name);
+            if (length < endingLength || strcmp(name + length - endingLength, ending) != 0)
+                continue;
+            sources = realloc(sources, sizeof(char *) * (count + 1));
+            sources[count] = NULL;
+            if (slash != NULL)
+                append_format(&sources[count++], "%s/%s", directory, name);
+            else
+                append_format(&sources[count++], "%s", name);
+        }
+        free(directory);
+    }
+    free(words);
+    free(ignore);
+    free(ignoreWords);
+
+    qsort(sources, count, sizeof(char *), compare_strings);
+    *sourcesOut = sources;
+    return count;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The compiler server is a small Java program jmake writes to .jmake/server/, compiles once and starts in
+ * the background. It keeps one JVM with javac loaded and warmed up, and runs every compile it receives
+ * over a loopback socket through the in-process tool API (java.util.spi.ToolProvider). A warm build
+ * saves the start of a JVM and the warm-up of javac, which is most of the time of a small build.
+ *
+ * The server writes "<port> <token>" to .jmake/server.port. A request is the line "JMAKE1 <token>"
+ * followed by one javac argument per line and an empty line, the answer is "<status> <bytes>" followed by
+ * that many bytes of compiler output. The token keeps other local users from compiling through it, the
+ * port file is created readable by its owner only, before the token is written into it. The
+ * server ends itself after 30 idle minutes, or when it receives the single argument --stop.
+ * -------------------------------------------------------------------------------------------------------- */
+const char *SERVER_SOURCE =
+    "import java.io.*;\n"
+    "import java.net.*;\n"
+    "import java.nio.charset.StandardCharsets;\n"
+    "import java.nio.file.*;\n"
+    "import java.nio.file.attribute.PosixFilePermissions;\n"
+    "import java.security.SecureRandom;\n"
+    "import java.util.*;\n"
+    "import java.util.spi.ToolProvider;\n"
+    "\n"
+    "public class JMakeServer {\n"
+    "    public static void main(String[] args) throws Exception {\n"
+    "        ToolProvider javac = ToolProvider.findFirst(\"javac\").orElseThrow();\n"
+    "        ServerSocket server = new ServerSocket(0, 50, InetAddress.getLoopbackAddress());\n"
+    "        server.setSoTimeout(Integer.parseInt(args[1]) * 1000);\n"
+    "        String token = Long.toHexString(new SecureRandom().nextLong());\n"
+    "        Path portFile = Paths.get(args[0]);\n"
+    "        Path temp = Paths.get(args[0] + \".tmp\");\n"
+    "        Files.deleteIfExists(temp);\n"
+    "        try {\n"
+    "            Files.createFile(temp, PosixFilePermissions.asFileAttribute(PosixFilePermissions.fromString(\"rw-------\")));\n"
+    "        } catch (UnsupportedOperationException notPosix) {\n"
+    "            Files.createFile(temp);\n"
+    "        }\n"
+    "        Files.write(temp, (server.getLocalPort() + \" \" + token + \"\\n\").getBytes(StandardCharsets.UTF_8));\n"
+    "        Files.move(temp, portFile, StandardCopyOption.REPLACE_EXISTING);\n"
+    "        try {\n"
+    "            while (true) {\n"
+    "                try (Socket client = server.accept()) {\n"
+    "                    BufferedReader in = new BufferedReader(new InputStreamReader(client.getInputStream(), StandardCharsets.UTF_8));\n"
+    "                    if (!(\"JMAKE1 \" + token).equals(in.readLine()))\n"
+    "                        continue;\n"
+    "                    List<String> arguments = new ArrayList<>();\n"
+    "                    for (String line = in.readLine(); line != null && !line.isEmpty(); line = in.readLine())\n"
+    "                        arguments.add(line);\n"
+    "                    if (arguments.size() == 1 && arguments.get(0).equals(\"--stop\"))\n"
+    "                        break;\n"
+    "                    StringWriter output = new StringWriter();\n"
+    "                    PrintWriter writer = new PrintWriter(output);\n"
+    "                    int status = javac.run(writer, writer, arguments.toArray(new String[0]));\n"
+    "                    writer.flush();\n"
+    "                    byte[] text = output.toString().getBytes(StandardCharsets.UTF_8);\n"
+    "                    OutputStream out = client.getOutputStream();\n"
+    "                    out.write((status + \" \" + text.length + \"\\n\").getBytes(StandardCharsets.UTF_8));\n"
+    "                    out.write(text);\n"
+    "                    out.flush();\n"
+    "                } catch (SocketTimeoutException idle) {\n"
+    "                    break;\n"
+    "                } catch (IOException broken) {\n"
+    "                    // A client that went away doesn't stop the server.\n"
+    "                }\n"
+    "            }\n"
+    "        } finally {\n"
+    "            Files.deleteIfExists(portFile);\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+#define SERVER_DIRECTORY ".jmake/server"
+#define SERVER_PORT_FILE ".jmake/server.port"
+#define SERVER_IDLE_SECONDS 1800
+
+/* --------------------------------------------------------------------------------------------------------
+ * Derives the java launcher from the compiler: javac becomes java, /opt/jdk/bin/javac /opt/jdk/bin/java.
+ *
+ * @param const char *javacIn   - The compiler.
+ * @return char*                - The launcher, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *java_launcher(const char *javacIn) {
+    char *java = NULL;
+    const char *name = strstr(javacIn, "javac");
+    if (name != NULL && strstr(name + 1, "javac") == NULL)
+        append_format(&java, "%.*sjava%s", (int)(name - javacIn), javacIn, name + 5);
+    else
+        append_format(&java, "java");
+    return java;
+}
+
+#ifdef _WIN32
+
+    // Windows version: without the server every compile starts javac.
+    int server_javac(const char *javacIn, const char *classpathIn, const char *argfileIn) {
+        (void)javacIn; (void)classpathIn; (void)argfileIn;
+        fprintf(stderr, "jmake: the compiler server is not available on Windows, javac is started instead.\n");
+        return -2;
+    }
+
+    int stop_server(void) {
+        return 0;
+    }
+
+#else
+
+    /* ----------------------------------------------------------------------------------------------------
+     * Reads the port file of a running server.
+     *
+     * @param int *portOut      - Receives the port.
+     * @param char *tokenOut    - Receives the token, at least 64 bytes.
+     * @return int              - 0 on success, -1 if no server announced itself.
+     * ---------------------------------------------------------------------------------------------------- */
+    int read_port_file(int *portOut, char *tokenOut) {
+        FILE *file = fopen(SERVER_PORT_FILE, "r");
+        if (file == NULL)
+            return -1;
+        int read = fscanf(file, "%d %63s", portOut, tokenOut);
+        fclose(file);
+        return read == 2 ? 0 : -1;
+    }
+
+    /* ----------------------------------------------------------------------------------------------------
+     * Connects to the server and sends a request.
+     *
+     * @param char **argumentsIn    - The javac arguments.
+     * @param int countIn           - The number of arguments.
+     * @return int                  - The connected socket, -1 if no server answers.
+     * ---------------------------------------------------------------------------------------------------- */
+    int send_request(char **argumentsIn, int countIn) {
+        int port = 0;
+        char token[64];
+        if (read_port_file(&port, token) != 0)
+            return -1;
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((unsigned short)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+            if (fd >= 0)
+                close(fd);
+            return -1;
+        }
+
+        char *request = NULL;
+        append_format(&request, "JMAKE1 %s\n", token);
+        for (int i = 0; i < countIn; i++)
+            append_format(&request, "%s\n", argumentsIn[i]);
+        append_format(&request, "\n");
+
+        size_t length = strlen(request), sent = 0;
+        while (sent < length) {
+            ssize_t n = write(fd, request + sent, length - sent);
+            if (n <= 0)
+                break;
+            sent += (size_t)n;
+        }
+        free(request);
+        if (sent < length) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /* ----------------------------------------------------------------------------------------------------
+     * Starts the server: writes its source, compiles it if the source changed and launches it detached
+     * from jmake, then waits until it announced its port.
+     *
+     * @param const char *javacIn   - The compiler, also gives the java launcher.
+     * @return int                  - 0 once the server runs, -1 if it couldn't be started.
+     * ---------------------------------------------------------------------------------------------------- */
+    int start_server(const char *javacIn) {
+        _makedir(".jmake");
+        _makedir(SERVER_DIRECTORY);
+
+        // Only a changed source is written and compiled again.
+        size_t size = 0;
+        char *current = (char *)read_file(SERVER_DIRECTORY "/JMakeServer.java", &size);
+        int changed = current == NULL || size != strlen(SERVER_SOURCE) || memcmp(current, SERVER_SOURCE, size) != 0;
+        free(current);
+        long long mtime, classSize;
+        if (changed || stamp_file(SERVER_DIRECTORY "/JMakeServer.class", &mtime, &classSize) != 0) {
+            FILE *file = fopen(SERVER_DIRECTORY "/JMakeServer.java", "w");
+            if (file == NULL) {
+                perror(SERVER_DIRECTORY "/JMakeServer.java");
+                return -1;
+            }
+            fputs(SERVER_SOURCE, file);
+            fclose(file);
+
+            char *command = NULL;
+            append_format(&command, "%s -d %s %s/JMakeServer.java", javacIn, SERVER_DIRECTORY, SERVER_DIRECTORY);
+            int result = system(command);
+            free(command);
+            if (result != 0)
+                return -1;
+        }
+
+        remove(SERVER_PORT_FILE);
+        char *java = java_launcher(javacIn);
+        char idle[16];
+        snprintf(idle, sizeof(idle), "%d", SERVER_IDLE_SECONDS);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            free(java);
+            return -1;
+        }
+        if (pid == 0) {
+            // The server outlives jmake and must not hold on to its terminal.
+            setsid();
+            int null = open("/dev/null", O_RDWR);
+            int log = open(".jmake/server.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            dup2(null, 0);
+            dup2(log >= 0 ? log : null, 1);
+            dup2(log >= 0 ? log : null, 2);
+            execlp(java, java, "-cp", SERVER_DIRECTORY, "JMakeServer", SERVER_PORT_FILE, idle, (char *)NULL);
+            _exit(127);
+        }
+        free(java);
+
+        // The JVM needs a moment, up to 20 seconds on a slow machine.
+        for (int i = 0; i < 400; i++) {
+            int port;
+            char token[64];
+            if (read_port_file(&port, token) == 0)
+                return 0;
+            if (waitpid(pid, NULL, WNOHANG) == pid)
+                break;
+            usleep(50000);
+        }
+        fprintf(stderr, "jmake: the compiler server didn't start, see .jmake/server.log.\n");
+        return -1;
+    }
+
+    /* ----------------------------------------------------------------------------------------------------
+     * Compiles through the server, starting it first if none runs in this directory.
+     *
+     * @param const char *javacIn       - The compiler.
+     * @param const char *classpathIn   - The classpath, empty for none.
+     * @param const char *argfileIn     - The argument file with the sources.
+     * @return int                      - The exit status of javac, -2 if the server isn't available.
+     * ---------------------------------------------------------------------------------------------------- */
+    int server_javac(const char *javacIn, const char *classpathIn, const char *argfileIn) {
+        char *cp = "-cp";
+        char *at = NULL;
+        append_format(&at, "@%s", argfileIn);
+        char *arguments[3] = { cp, (char *)classpathIn, at };
+        char **list = classpathIn[0] != '\0' ? arguments : arguments + 2;
+        int count = classpathIn[0] != '\0' ? 3 : 1;
+
+        // A server gone since the last build left its port file behind.
+        signal(SIGPIPE, SIG_IGN);
+        int fd = send_request(list, count);
+        if (fd < 0 && start_server(javacIn) == 0)
+            fd = send_request(list, count);
+        free(at);
+        if (fd < 0)
+            return -2;
+
+        // The answer: "<status> <bytes>\n" and the compiler output.
+        char header[64];
+        size_t length = 0;
+        while (length + 1 < sizeof(header) && read(fd, header + length, 1) == 1 && header[length] != '\n')
+            length++;
+        header[length] = '\0';
+        int status = -2;
+        long bytes = 0;
+        if (sscanf(header, "%d %ld", &status, &bytes) != 2) {
+            close(fd);
+            return -2;
+        }
+
+        char buffer[65536];
+        while (bytes > 0) {
+            ssize_t n = read(fd, buffer, bytes < (long)sizeof(buffer) ? (size_t)bytes : sizeof(buffer));
+            if (n <= 0)
+                break;
+            fwrite(buffer, 1, (size_t)n, stderr);
+            bytes -= n;
+        }
+        close(fd);
+        return status;
+    }
+
+    /* ----------------------------------------------------------------------------------------------------
+     * Stops the server of this directory, if one runs.
+     *
+     * @return int - 1 if a server was stopped, 0 if none ran.
+     * ---------------------------------------------------------------------------------------------------- */
+    int stop_server(void) {
+        char *stop = "--stop";
+        signal(SIGPIPE, SIG_IGN);
+        int fd = send_request(&stop, 1);
+        if (fd < 0) {
+            remove(SERVER_PORT_FILE);
+            return 0;
+        }
+
+        // The server closes the connection once it is on its way out.
+        char c;
+        while (read(fd, &c, 1) > 0)
+            ;
+        close(fd);
+        return 1;
+    }
+
+#endif
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads the package declaration of a source, the directory javac -d puts its classes in.
+ *
+ * @param const char *pathIn    - The source.
+ * @return char*                - The package with slashes and a trailing one, like com/example/, an empty
+ *                                string for the default package. The caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *source_package(const char *pathIn) {
+    size_t size = 0;
+    char *text = (char *)read_file(pathIn, &size);
+    char *package = NULL;
+    append_format(&package, "");
+    size_t i = 0;
+    while (text != NULL && i < size) {
+        // Comments and annotations of a package-info.java may come first.
+        if (isspace((unsigned char)text[i])) {
+            i++;
+        } else if (i + 1 < size && text[i] == '/' && text[i + 1] == '/') {
+            while (i < size && text[i] != '\n')
+                i++;
+        } else if (i + 1 < size && text[i] == '/' && text[i + 1] == '*') {
+            for (i += 2; i + 1 < size && !(text[i] == '*' && text[i + 1] == '/'); i++)
+                ;
+            i += 2;
+        } else if (text[i] == '@') {
+            for (i++; i < size && (isalnum((unsigned char)text[i]) || text[i] == '.' || text[i] == '_'); i++)
+                ;
+        } else {
+            if (size - i > 8 && strncmp(text + i, "package", 7) == 0 && isspace((unsigned char)text[i + 7])) {
+                for (i += 8; i < size && text[i] != ';'; i++) {
+                    if (text[i] == '.')
+                        append_format(&package, "/");
+                    else if (!isspace((unsigned char)text[i]))
+                        append_format(&package, "%c", text[i]);
+                }
+                if (package[0] != '\0')
+                    append_format(&package, "/");
+            }
+            break;
+        }
+    }
+    free(text);
+    return package;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes one argument to a javac argument file. Quoted, so blanks in paths survive, a backslash has to be
+ * doubled inside quotes.
+ * -------------------------------------------------------------------------------------------------------- */
+void write_argument(FILE *fileIn, const char *argumentIn) {
+    fputc('"', fileIn);
+    for (const char *c = argumentIn; *c != '\0'; c++) {
+        if (*c == '\\' || *c == '"')
+            fputc('\\', fileIn);
+        fputc(*c, fileIn);
+    }
+    fputs("\"\n", fileIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the roots of the package trees the sources are in: the directory of a source without the
+ * directories of its package, so src/com/example/A.java in package com.example has the root src.
+ *
+ * @param char **sourcesIn  - The sources.
+ * @param int countIn       - The number of sources.
+ * @return char*            - The roots separated by colons, "." for the current directory. The caller
+ *                            frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *source_roots(char **sourcesIn, int countIn) {
+    char **roots = NULL;
+    int rootCount = 0;
+    for (int i = 0; i < countIn; i++) {
+        const char *path = sourcesIn[i];
+        const char *slash = strrchr(path, '/');
+        size_t length = slash != NULL ? (size_t)(slash - path) + 1 : 0;
+        char *package = source_package(path);
+        size_t packageLength = strlen(package);
+
+        // The directory, with its slash, ends with the package: the root is what comes before.
+        if (packageLength <= length && strncmp(path + length - packageLength, package, packageLength) == 0 &&
+            (packageLength == length || path[length - packageLength - 1] == '/'))
+            length -= packageLength;
+        if (length > 1)
+            add_name(&roots, &rootCount, path, length - 1);
+        else
+            add_name(&roots, &rootCount, length == 1 ? "/" : ".", 1);
+        free(package);
+    }
+
+    char *joined = NULL;
+    append_format(&joined, "%s", rootCount > 0 ? "" : ".");
+    for (int i = 0; i < rootCount; i++) {
+        append_format(&joined, "%s%s", i > 0 ? ":" : "", roots[i]);
+        free(roots[i]);
+    }
+    free(roots);
+    return joined;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Hands sources to javac through an argument file, so no list is too long for the command line. An
+ * incremental build only compiles some of the sources, javac finds the classes of the others in the
+ * output directory, which is put first on the classpath, and their sources through -sourcepath.
+ *
+ * @param const char *javacIn       - The compiler.
+ * @param const char *classpathIn   - The classpath, empty for none.
+ * @param const char *argfileIn     - The argument file to write.
+ * @param char **sourcesIn          - The sources.
+ * @param int countIn               - The number of sources.
+ * @param const char *outIn         - The output directory for -d, empty to put classes next to the sources.
+ * @param int serverIn              - 1 to compile through the compiler server.
+ * @return int                      - The exit status of javac.
+ * -------------------------------------------------------------------------------------------------------- */
+int run_javac(const char *javacIn, const char *classpathIn, const char *argfileIn, char **sourcesIn, int countIn,
+              const char *outIn, int serverIn) {
+    FILE *file = fopen(argfileIn, "w");
+    if (file == NULL) {
+        perror(argfileIn);
+        return -1;
+    }
+
+    // Without out= the classes are next to their sources, the source roots are the output roots.
+    char *roots = source_roots(sourcesIn, countIn);
+    char *classpath = NULL;
+    append_format(&classpath, "%s", outIn[0] != '\0' ? outIn : roots);
+    if (classpathIn[0] != '\0')
+        append_format(&classpath, ":%s", classpathIn);
+
+    fputs("-sourcepath\n", file);
+    write_argument(file, roots);
+    if (outIn[0] != '\0') {
+        fputs("-d\n", file);
+        write_argument(file, outIn);
+    }
+    for (int i = 0; i < countIn; i++)
+        write_argument(file, sourcesIn[i]);
+    fclose(file);
+
+    char *command = NULL;
+    append_format(&command, "%s -cp %s @%s", javacIn, classpath, argfileIn);
+
+    printf("Compiling command%s:\n", serverIn ? " (server)" : "");
+    printf("%s\n", command);
+    fflush(stdout);
+
+    int result = serverIn ? server_javac(javacIn, classpath, argfileIn) : -2;
+    if (result == -2)
+        result = system(command);
+    if (result != 0)
+        fprintf(stderr, "Command failed: %s\n", command);
+    free(command);
+    free(classpath);
+    free(roots);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Creates a directory with all its missing parents, like mkdir -p.
+ *
+ * @param const char *pathIn - The directory.
+ * -------------------------------------------------------------------------------------------------------- */
+void make_directories(const char *pathIn) {
+    char *path = NULL;
+    append_format(&path, "%s", pathIn);
+    for (char *c = path + 1; *c != '\0'; c++) {
+        if (*c == '/' || *c == '\\') {
+            char separator = *c;
+            *c = '\0';
+            _makedir(path);
+            *c = separator;
+        }
+    }
+    _makedir(path);
+    free(path);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the source of a class among the sources compiled in this round.
+ *
+ * @param JavaState *stateIn        - The state.
+ * @param char **directoriesIn      - The source directories that wrote into the class directory.
+ * @param int countIn               - Number of directories.
+ * @param const char *sourceFileIn  - The file name of the source, from the class file.
+ * @return SourceRecord*            - The compiled source, NULL if it isn't one of them.
+ * -------------------------------------------------------------------------------------------------------- */
+SourceRecord *find_compiled(JavaState *stateIn, char **directoriesIn, int countIn, const char *sourceFileIn) {
+    SourceRecord *record = NULL;
+    for (int i = 0; i < countIn && record == NULL; i++) {
+        char *source = NULL;
+        append_format(&source, "%s%s", directoriesIn[i], sourceFileIn);
+        record = find_source(stateIn, source);
+        if (record != NULL && !(record->compiled && record->dirty))
+            record = NULL;
+        free(source);
+    }
+    return record;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the classes javac wrote for the sources compiled in this round. Without out= javac puts every
+ * class next to its source, with out= into the directory of its package below out=. The SourceFile
+ * attribute of the class names the source, which also covers nested and further top level classes of a
+ * source. Source roots sharing a package, like src/main/java and src/test/java, share its class directory,
+ * so a class is looked up in every source directory that wrote into its directory. Every directory is
+ * read once.
+ *
+ * @param JavaState *stateIn    - The state.
+ * @param int *roundIn          - Positions of the sources compiled in this round.
+ * @param int countIn           - Number of positions.
+ * @param const char *outIn     - The value of out=, empty for none.
+ * -------------------------------------------------------------------------------------------------------- */
+void collect_classes(JavaState *stateIn, int *roundIn, int countIn, const char *outIn) {
+    // Class directories with the source directories their classes came from, in the same order.
+    char **directories = NULL;
+    char ***sourceDirectories = NULL;
+    int *sourceDirectoryCounts = NULL;
+    int directoryCount = 0;
+    for (int i = 0; i < countIn; i++) {
+        const char *path = stateIn->sources[roundIn[i]].path;
+        const char *slash = strrchr(path, '/');
+        char *sourceDirectory = NULL;
+        append_format(&sourceDirectory, "%.*s", slash ? (int)(slash - path + 1) : 0, path);
+        char *directory = NULL;
+        if (outIn[0] != '\0') {
+            char *package = source_package(path);
+            append_format(&directory, "%s/%s", outIn, package);
+            free(package);
+        } else {
+            append_format(&directory, "%s", sourceDirectory);
+        }
+
+        int before = directoryCount;
+        add_name(&directories, &directoryCount, directory, strlen(directory));
+        if (directoryCount > before) {
+            sourceDirectories = realloc(sourceDirectories, sizeof(char **) * directoryCount);
+            sourceDirectoryCounts = realloc(sourceDirectoryCounts, sizeof(int) * directoryCount);
+            sourceDirectories[before] = NULL;
+            sourceDirectoryCounts[before] = 0;
+        }
+        int d = 0;
+        while (strcmp(directories[d], directory) != 0)
+            d++;
+        add_name(&sourceDirectories[d], &sourceDirectoryCounts[d], sourceDirectory, strlen(sourceDirectory));
+        free(sourceDirectory);
+        free(directory);
+    }
+
+    for (int d = 0; d < directoryCount; d++) {
+        DIR *dir = opendir(directories[d][0] ? directories[d] : ".");
+        struct dirent *entry;
+        while (dir != NULL && (entry = readdir(dir)) != NULL) {
+            size_t length = strlen(entry->d_name);
+            if (length < 7 || strcmp(entry->d_name + length - 6, ".class") != 0)
+                continue;
+
+            char *path = NULL;
+            append_format(&path, "%s%s", directories[d], entry->d_name);
+            ClassFile classFile;
+            char *sourceFile = NULL;
+            char **refs = NULL;
+            int refCount = 0;
+            if (read_class_file(path, &classFile, &sourceFile, &refs, &refCount) == 0) {
+                // Without debug information (-g:none) the name of the class file has to do.
+                if (sourceFile == NULL)
+                    append_format(&sourceFile, "%.*s.java", (int)strcspn(entry->d_name, "$."), entry->d_name);
+
+                SourceRecord *record = find_compiled(stateIn, sourceDirectories[d], sourceDirectoryCounts[d],
+                                                     sourceFile);
+                if (record != NULL) {
+                    record->classes = realloc(record->classes, sizeof(ClassFile) * (record->classCount + 1));
+                    record->classes[record->classCount++] = classFile;
+                    for (int r = 0; r < refCount; r++)
+                        add_name(&record->refs, &record->refCount, refs[r], strlen(refs[r]));
+                    classFile.path = classFile.name = NULL;
+                }
+                free(classFile.path);
+                free(classFile.name);
+            } else {
+                // A class file that can't be read, javac was killed while writing it, is unknown. Its
+                // source, as far as the name tells, is compiled again by the next build.
+                append_format(&sourceFile, "%.*s.java", (int)strcspn(entry->d_name, "$."), entry->d_name);
+                SourceRecord *record = find_compiled(stateIn, sourceDirectories[d], sourceDirectoryCounts[d],
+                                                     sourceFile);
+                if (record != NULL)
+                    record->mtime = -1;
+            }
+            for (int r = 0; r < refCount; r++)
+                free(refs[r]);
+            free(refs);
+            free(sourceFile);
+            free(path);
+        }
+        if (dir != NULL)
+            closedir(dir);
+        for (int i = 0; i < sourceDirectoryCounts[d]; i++)
+            free(sourceDirectories[d][i]);
+        free(sourceDirectories[d]);
+        free(directories[d]);
+    }
+    free(directories);
+    free(sourceDirectories);
+    free(sourceDirectoryCounts);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Marks every source not compiled yet that references one of the given classes.
+ *
+ * @param JavaState *stateIn    - The state.
+ * @param char **namesIn        - Binary names of classes whose api changed or that are gone.
+ * @param int countIn           - Number of names.
+ * @return int                  - The number of sources marked.
+ * -------------------------------------------------------------------------------------------------------- */
+int mark_dependents(JavaState *stateIn, char **namesIn, int countIn) {
+    int marked = 0;
+    for (int i = 0; i < stateIn->count; i++) {
+        SourceRecord *record = &stateIn->sources[i];
+        if (!record->seen || record->dirty)
+            continue;
+        for (int r = 0; r < record->refCount && !record->dirty; r++)
+            for (int n = 0; n < countIn && !record->dirty; n++)
+                record->dirty = strcmp(record->refs[r], namesIn[n]) == 0;
+        marked += record->dirty;
+    }
+    return marked;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Compiles what changed since the last build. Changed, new and sources with a missing class file are
+ * compiled first. Then the api hashes of their new classes are compared with the last build: sources
+ * referencing a class whose api changed or that vanished are compiled in a further round, until no api
+ * changes anymore. A changed constant compiles everything, javac inlines constants. Sources that are gone
+ * take their classes with them.
+ *
+ * @param const char *makefileIn    - The makefile, names the state file.
+ * @param const char *outIn         - The value of out=, empty to put classes next to their sources.
+ * @param const char *javacIn       - The compiler.
+ * @param const char *classpathIn   - The classpath, empty for none.
+ * @param const char *srcIn         - The value of src=.
+ * @param const char *ignoreIn      - The value of ignore=.
+ * @param int fullIn                - 1 to compile everything (--full).
+ * @param int serverIn              - 1 to compile through the compiler server.
+ * @param int *apiChangedOut        - Set to 1 if a class changed its api or is gone, other modules using
+ *                                    this one have to be compiled again.
+ * @return int                      - 0 on success, the exit status of javac otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int build_incremental(const char *makefileIn, const char *outIn, const char *javacIn, const char *classpathIn,
+                      const char *srcIn, const char *ignoreIn, int fullIn, int serverIn, int *apiChangedOut) {
+    char *statePath = state_path(makefileIn);
+    char *directory = NULL;
+    append_format(&directory, "%.*s", (int)(strrchr(statePath, '/') - statePath), statePath);
+    _makedir(directory);
+    free(directory);
+
+    JavaState state;
+    load_java_state(statePath, &state);
+
+    char **sources = NULL;
+    int sourceCount = list_sources(&state, srcIn, ignoreIn, &sources);
+
+    // Look up every source, new ones are added after the lookups to keep the records sorted meanwhile.
+    int known = state.count;
+    char **added = NULL;
+    int addedCount = 0;
+    for (int i = 0; i < sourceCount; i++) {
+        SourceRecord *record = find_source(&state, sources[i]);
+        if (record != NULL) {
+            record->seen = 1;
+        } else {
+            added = realloc(added, sizeof(char *) * (addedCount + 1));
+            added[addedCount++] = sources[i];
+        }
+    }
+    for (int i = 0; i < addedCount; i++) {
+        state.sources = realloc(state.sources, sizeof(SourceRecord) * (state.count + 1));
+        SourceRecord *record = &state.sources[state.count++];
+        memset(record, 0, sizeof(SourceRecord));
+        append_format(&record->path, "%s", added[i]);
+        record->mtime = -1;
+        record->seen = 1;
+    }
+    free(added);
+    if (state.count > known)
+        qsort(state.sources, state.count, sizeof(SourceRecord), compare_sources);
+
+    // Classes of sources that are gone are deleted, whoever used them has to be compiled again.
+    char **changed = NULL;
+    int changedCount = 0;
+    int dirtyCount = 0;
+    for (int i = 0; i < state.count; i++) {
+        SourceRecord *record = &state.sources[i];
+        if (!record->seen) {
+            for (int c = 0; c < record->classCount; c++) {
+                remove(record->classes[c].path);
+                add_name(&changed, &changedCount, record->classes[c].name, strlen(record->classes[c].name));
+            }
+            continue;
+        }
+
+        long long mtime = 0, size = 0;
+        record->dirty = fullIn || stamp_file(record->path, &mtime, &size) != 0 ||
+                        mtime != record->mtime || size != record->size;
+        for (int c = 0; c < record->classCount && !record->dirty; c++)
+            record->dirty = stamp_file(record->classes[c].path, &mtime, &size) != 0;
+        dirtyCount += record->dirty;
+    }
+    int dependents = mark_dependents(&state, changed, changedCount);
+    *apiChangedOut = changedCount > 0;
+    if (outIn[0] != '\0')
+        make_directories(outIn);
+
+    int result = 0;
+    int compiledCount = 0;
+    int *round = malloc(sizeof(int) * (state.count + 1));
+    char **roundSources = malloc(sizeof(char *) * (state.count + 1));
+    char *argfile = NULL;
+    append_format(&argfile, "%.*s.args", (int)(strlen(statePath) - 6), statePath);
+
+    if (dirtyCount + dependents > 0)
+        printf("jmake: %d of %d source(s) changed.\n", dirtyCount, sourceCount);
+
+    for (;;) {
+        int count = 0;
+        for (int i = 0; i < state.count; i++) {
+            SourceRecord *record = &state.sources[i];
+            if (!record->seen || !record->dirty || record->compiled)
+                continue;
+
+            // The old classes are kept for the api comparison, their files go so no stale nested
+            // class survives.
+            for (int c = 0; c < record->classCount; c++)
+                remove(record->classes[c].path);
+            free_classes(record->previous, record->previousCount);
+            record->previous = record->classes;
+            record->previousCount = record->classCount;
+            record->classes = NULL;
+            record->classCount = 0;
+            for (int r = 0; r < record->refCount; r++)
+                free(record->refs[r]);
+            free(record->refs);
+            record->refs = NULL;
+            record->refCount = 0;
+
+            record->compiled = 1;
+            stamp_file(record->path, &record->mtime, &record->size);
+            round[count] = i;
+            roundSources[count++] = record->path;
+        }
+        if (count == 0)
+            break;
+
+        for (int n = 0; n < changedCount; n++)
+            free(changed[n]);
+        changedCount = 0;
+
+        result = run_javac(javacIn, classpathIn, argfile, roundSources, count, outIn, serverIn);
+        if (result != 0) {
+            // Nothing of this round counts, the next build compiles it again.
+            for (int i = 0; i < count; i++) {
+                SourceRecord *record = &state.sources[round[i]];
+                free_classes(record->classes, record->classCount);
+                record->classes = record->previous;
+                record->classCount = record->previousCount;
+                record->previous = NULL;
+                record->previousCount = 0;
+                record->mtime = -1;
+            }
+            break;
+        }
+        compiledCount += count;
+
+        collect_classes(&state, round, count, outIn);
+
+        // Which classes other sources see differently now.
+        int constantChanged = 0;
+        for (int i = 0; i < count; i++) {
+            SourceRecord *record = &state.sources[round[i]];
+            for (int p = 0; p < record->previousCount; p++) {
+                ClassFile *before = &record->previous[p];
+                ClassFile *after = NULL;
+                for (int c = 0; c < record->classCount && after == NULL; c++)
+                    if (strcmp(record->classes[c].name, before->name) == 0)
+                        after = &record->classes[c];
+                if (after == NULL || after->api != before->api)
+                    add_name(&changed, &changedCount, before->name, strlen(before->name));
+                if (after == NULL || after->constants != before->constants)
+                    constantChanged = 1;
+            }
+        }
+
+        *apiChangedOut |= changedCount > 0 || constantChanged;
+        if (constantChanged) {
+            printf("jmake: a constant changed, compiling everything that isn't compiled yet.\n");
+            for (int i = 0; i < state.count; i++)
+                state.sources[i].dirty |= state.sources[i].seen;
+        } else if (mark_dependents(&state, changed, changedCount) > 0) {
+            printf("jmake: the api of %d class(es) changed, compiling their users.\n", changedCount);
+        }
+    }
+
+    if (result == 0 && compiledCount == 0)
+        printf("jmake: everything is up to date.\n");
+    else if (result == 0)
+        printf("jmake: compiled %d of %d source(s).\n", compiledCount, sourceCount);
+
+    save_java_state(statePath, &state);
+    remove(argfile);
+
+    for (int n = 0; n < changedCount; n++)
+        free(changed[n]);
+    free(changed);
+    for (int i = 0; i < sourceCount; i++)
+        free(sources[i]);
+    free(sources);
+    free(round);
+    free(roundSources);
+    free(argfile);
+    free(statePath);
+    free_java_state(&state);
+    return result;
+}
+
+/* ****************************************END INCREMENTAL BUILD******************************************* */
+
+/* ***************************************START MODULES**************************************************** */
+
+/* --------------------------------------------------------------------------------------------------------
+ * A JMakefile holds the directives of one makefile.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char javac[MAX_LINE_LENGTH];            // The compiler, "javac" if left empty.
+    char classpath[MAX_LINE_LENGTH * 4];    // The classpath, entries separated by ':'.
+    char src[MAX_LINE_LENGTH * 4];          // The sources.
+    char ignore[MAX_LINE_LENGTH];           // Directories src=@ skips.
+    char out[MAX_LINE_LENGTH];              // Output directory of the classes, empty puts them next to their sources.
+    int server;                             // 1 for server=yes.
+    char **modules;                         // The makefiles of module=, relative to this makefile.
+    int moduleCount;                        // Number of modules.
+} JMakefile;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A Module is a project of module= with its own makefile, sources and output directory. It is built in
+ * its own directory, in a child process, once all modules on its classpath are built.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *makefile;         // The makefile as given in module=.
+    char *directory;        // The directory of the makefile, the module is built in there.
+    char *name;             // The file name of the makefile.
+    char *real;             // The canonical path of the directory.
+    char *realOut;          // The canonical path of its out=, NULL without one.
+    JMakefile config;       // Its directives.
+    int *deps;              // Positions of the modules on its classpath.
+    int depCount;           // Number of them.
+    int status;             // 0 waiting, 1 running, 2 built, 3 failed or skipped.
+    int full;               // 1 once it is compiled fully, by --full or a module it uses changed its api.
+    int apiChanged;         // 1 if its build changed the api of a class.
+#ifndef _WIN32
+    pid_t pid;              // The child process building it.
+    FILE *log;              // What the child printed, shown in one piece once it is done.
+#endif
+} Module;
+
+/* ------------------------------------------------------------------------------------------------
+ * The parse_makefile function reads the directives of a makefile: javac=, the classpath block,
+ * src=, ignore=, out=, server= and module=.
+ *
+ * @param filename  The name of the makefile to be read.
+ * @param makeOut   Receives the directives.
+ * @return          0 on success, -1 if the makefile can't be read.
+ * ------------------------------------------------------------------------------------------------- */
+int parse_makefile(const char *filename, JMakefile *makeOut) {
+    memset(makeOut, 0, sizeof(JMakefile));
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        perror(filename);
+        return -1;
+    }
+    
+    char line[MAX_LINE_LENGTH];
+    char *javac = makeOut->javac;
+    char *classpath = makeOut->classpath;
+    char *src = makeOut->src;
+    bool in_classpath = false;
+    
+    while (fgets(line, sizeof(line), file)) {
+        // Trim newline character
+        line[strcspn(line, "\n")] = 0;
+                
+        // Parse javac directive
+        if (strncmp(line, "javac=", 6) == 0 && !in_classpath) {
+            strcpy(javac, line + 6);
+            if (strlen(javac) == 0) {
+                strcpy(javac, "javac"); // Default to system javac
+            }
+        }
+
+        // Parse classpath directive
+        // Start processing a classpath block
+        if (strncmp(line, "classpath=", 10) == 0) {
+            in_classpath = true;
+            strcpy(classpath, line + 10);
+            if (classpath[0] == '@') {
+                // Handle @ directive for classpath
+                FILE *classpathFile = fopen(classpath + 1, "r");
+                if (classpathFile) {
+                    char path[MAX_LINE_LENGTH];
+                    classpath[0] = '\0'; // Reset classpath
+                    while (fgets(path, sizeof(path), classpathFile)) {
+                        path[strcspn(path, "\n")] = 0; // Trim newline characters
+                        if (path[0] == '#' || path[0] == '\0') continue; // Skip comments/empty lines
+                        if (strlen(classpath) > 0) strcat(classpath, ":");
+                        strcat(classpath, path);
+                    }
+                    fclose(classpathFile);
+                }
+                in_classpath = false; // Single-line directive is complete
+            }
+        } 
+        // Continue processing multi-line classpath block
+        else if (in_classpath) {
+            if (line[0] == '\0' || strncmp(line, "javac=", 6) == 0
+                || strncmp(line, "src=", 4) == 0
+                || strncmp(line, "ignore=", 7) == 0
+                || strncmp(line, "server=", 7) == 0
+                || strncmp(line, "out=", 4) == 0
+                || strncmp(line, "module=", 7) == 0
+                || strcmp(line, "# end of classpath") == 0) {
+                in_classpath = false; // End of classpath block
+            } else {
+                if (line[0] != '#') { // Skip comments/empty lines
+                    if (strlen(classpath) > 0) strcat(classpath, ":");
+                    strcat(classpath, line);
+                }
+            }
+        }
+        
+        // Parse src directive, also when it ends a classpath block
+        if (strncmp(line, "src=", 4) == 0 && !in_classpath) {
+            strcpy(src, line + 4);
+            if (strlen(src) == 0) {
+                strcpy(src, "*.java"); // Default to all .java files
+            }
+        }
+
+        // Parse ignore directive, directories src=@ doesn't look into
+        if (strncmp(line, "ignore=", 7) == 0 && !in_classpath)
+            strcpy(makeOut->ignore, line + 7);
+
+        // Parse server directive, compiles through the resident compiler server
+        if (strncmp(line, "server=", 7) == 0 && !in_classpath)
+            makeOut->server = strcmp(line + 7, "yes") == 0;
+
+        // Parse out directive, the directory javac -d writes the classes to
+        if (strncmp(line, "out=", 4) == 0 && !in_classpath) {
+            strcpy(makeOut->out, line + 4);
+            size_t length = strlen(makeOut->out);
+            while (length > 1 && makeOut->out[length - 1] == '/')
+                makeOut->out[--length] = '\0';
+        }
+
+        // Parse module directive, makefiles of projects to build first, several per line
+        if (strncmp(line, "module=", 7) == 0 && !in_classpath) {
+            for (char *word = strtok(line + 7, " \t"); word != NULL; word = strtok(NULL, " \t")) {
+                makeOut->modules = realloc(makeOut->modules, sizeof(char *) * (makeOut->moduleCount + 1));
+                makeOut->modules[makeOut->moduleCount] = NULL;
+                append_format(&makeOut->modules[makeOut->moduleCount++], "%s", word);
+            }
+        }
+    }
+    
+    fclose(file);
+
+    if (javac[0] == '\0')
+        strcpy(javac, "javac");
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Frees the module list of a makefile.
+ *
+ * @param JMakefile *makeIn - The makefile.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_makefile(JMakefile *makeIn) {
+    for (int i = 0; i < makeIn->moduleCount; i++)
+        free(makeIn->modules[i]);
+    free(makeIn->modules);
+    makeIn->modules = NULL;
+    makeIn->moduleCount = 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Resolves a path to its canonical form, so classpath entries and module directories spelled differently
+ * still compare equal.
+ *
+ * @param const char *baseIn    - The directory a relative path is relative to.
+ * @param const char *pathIn    - The path.
+ * @return char*                - The canonical path, NULL if it doesn't exist. The caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *canonical_path(const char *baseIn, const char *pathIn) {
+    char *joined = NULL;
+#ifdef _WIN32
+    int absolute = pathIn[0] == '/' || pathIn[0] == '\\' || (pathIn[0] != '\0' && pathIn[1] == ':');
+#else
+    int absolute = pathIn[0] == '/';
+#endif
+    if (absolute)
+        append_format(&joined, "%s", pathIn);
+    else
+        append_format(&joined, "%s/%s", baseIn, pathIn);
+
+    struct stat st;
+    char *real = NULL;
+    if (stat(joined, &st) == 0) {
+#ifdef _WIN32
+        real = _fullpath(NULL, joined, 0);
+#else
+        real = realpath(joined, NULL);
+#endif
+    }
+    free(joined);
+    return real;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Names the marker file that asks for a full build of a makefile, next to its state file.
+ *
+ * @param const char *makefileIn    - The makefile.
+ * @return char*                    - The marker, .jmake/<makefile>.full. The caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *full_marker(const char *makefileIn) {
+    char *statePath = state_path(makefileIn);
+    char *marker = NULL;
+    append_format(&marker, "%.*s.full", (int)(strlen(statePath) - 6), statePath);
+    free(statePath);
+    return marker;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Asks for a full build of a makefile, because a module it uses changed its api. The request is a file,
+ * so it survives a failed or skipped build and is only gone once the full build succeeded.
+ *
+ * @param const char *makefileIn - The makefile.
+ * -------------------------------------------------------------------------------------------------------- */
+void request_full_build(const char *makefileIn) {
+    char *statePath = state_path(makefileIn);
+    char *directory = NULL;
+    append_format(&directory, "%.*s", (int)(strrchr(statePath, '/') - statePath), statePath);
+    make_directories(directory);
+    free(directory);
+    free(statePath);
+
+    char *marker = full_marker(makefileIn);
+    FILE *file = fopen(marker, "w");
+    if (file != NULL)
+        fclose(file);
+    free(marker);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the sources of one makefile in the current directory.
+ *
+ * @param const char *makefileIn    - The makefile, names the state file.
+ * @param JMakefile *makeIn         - Its directives.
+ * @param int fullIn                - 1 to compile every source.
+ * @param int serverIn              - 1 to compile through the compiler server.
+ * @param int *apiChangedOut        - Set to 1 if the api of a class changed.
+ * @return int                      - 0 on success, the exit status of javac otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int build_makefile(const char *makefileIn, JMakefile *makeIn, int fullIn, int serverIn, int *apiChangedOut) {
+    char *marker = full_marker(makefileIn);
+    long long mtime, size;
+    if (stamp_file(marker, &mtime, &size) == 0) {
+        printf("jmake: a module on the classpath changed its api, compiling everything.\n");
+        fullIn = 1;
+    }
+
+    // Only what changed since the last build and whatever uses it is compiled.
+    int result = build_incremental(makefileIn, makeIn->out, makeIn->javac, makeIn->classpath, makeIn->src,
+                                   makeIn->ignore, fullIn, serverIn || makeIn->server, apiChangedOut);
+    if (result == 0)
+        remove(marker);
+    free(marker);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads the makefiles of module= and orders them: a module depends on every other module whose directory
+ * or out= directory is on its classpath.
+ *
+ * @param JMakefile *makeIn     - The makefile with the module= entries.
+ * @param Module **modulesOut   - Receives the modules.
+ * @return int                  - The number of modules, -1 if a makefile can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int load_modules(JMakefile *makeIn, Module **modulesOut) {
+    Module *modules = calloc(makeIn->moduleCount > 0 ? makeIn->moduleCount : 1, sizeof(Module));
+    int count = makeIn->moduleCount;
+    int result = 0;
+
+    for (int i = 0; i < count; i++) {
+        Module *module = &modules[i];
+        append_format(&module->makefile, "%s", makeIn->modules[i]);
+        const char *slash = strrchr(module->makefile, '/');
+        append_format(&module->directory, "%.*s", slash ? (int)(slash - module->makefile) : 1,
+                      slash ? module->makefile : ".");
+        append_format(&module->name, "%s", slash ? slash + 1 : module->makefile);
+        if (parse_makefile(module->makefile, &module->config) != 0) {
+            result = -1;
+            continue;
+        }
+        module->real = canonical_path(".", module->directory);
+        if (module->config.out[0] != '\0') {
+            // The output directory exists before the first build, so users of the module can find it.
+            char *out = NULL;
+            if (module->config.out[0] == '/')
+                append_format(&out, "%s", module->config.out);
+            else
+                append_format(&out, "%s/%s", module->directory, module->config.out);
+            make_directories(out);
+            module->realOut = canonical_path(".", out);
+            free(out);
+        }
+        if (module->config.moduleCount > 0)
+            fprintf(stderr, "jmake: module= of %s ignored, list every module in the top makefile.\n",
+                    module->makefile);
+    }
+
+    int *outListed = calloc(count > 0 ? count : 1, sizeof(int));
+    for (int i = 0; i < count && result == 0; i++) {
+        Module *module = &modules[i];
+        char *classpath = NULL;
+        append_format(&classpath, "%s", module->config.classpath);
+        memset(outListed, 0, sizeof(int) * count);
+        for (char *entry = strtok(classpath, ":"); entry != NULL; entry = strtok(NULL, ":")) {
+            char *real = canonical_path(module->directory, entry);
+            for (int j = 0; real != NULL && j < count; j++) {
+                int isOut = modules[j].realOut != NULL && strcmp(real, modules[j].realOut) == 0;
+                if (j == i || (strcmp(real, modules[j].real) != 0 && !isOut))
+                    continue;
+                outListed[j] |= isOut;
+                int known = 0;
+                for (int d = 0; d < module->depCount; d++)
+                    known |= module->deps[d] == j;
+                if (!known) {
+                    module->deps = realloc(module->deps, sizeof(int) * (module->depCount + 1));
+                    module->deps[module->depCount++] = j;
+                }
+            }
+            free(real);
+        }
+        free(classpath);
+
+        // The classes of a module with out= are in its out directory, which may not be on the classpath
+        // that named the module by its directory. Its own out directory run_javac puts first anyway.
+        char *outs = NULL;
+        for (int d = 0; d < module->depCount; d++) {
+            Module *dep = &modules[module->deps[d]];
+            if (dep->realOut != NULL && !outListed[module->deps[d]])
+                append_format(&outs, "%s:", dep->realOut);
+        }
+        if (outs != NULL) {
+            append_format(&outs, "%s", module->config.classpath);
+            if (strlen(outs) < sizeof(module->config.classpath))
+                strcpy(module->config.classpath, outs);
+            else
+                fprintf(stderr, "jmake: the classpath of %s is too long for the out= directories of its modules.\n",
+                        module->makefile);
+            free(outs);
+        }
+    }
+    free(outListed);
+
+    *modulesOut = modules;
+    return result == 0 ? count : -1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Starts the build of a module. On Unix a child process changes into the module directory and builds
+ * it, its output goes to a temporary file so concurrent builds don't mix their lines. On Windows the
+ * module is built right away.
+ *
+ * @param Module *moduleIn  - The module.
+ * @param int serverIn      - 1 to compile through the compiler server.
+ * @return int              - 0 if started, -1 on failure.
+ * -------------------------------------------------------------------------------------------------------- */
+int start_module(Module *moduleIn, int serverIn) {
+    moduleIn->status = 1;
+#ifdef _WIN32
+    char *back = _getcwd(NULL, 0);
+    printf("==> %s\n", moduleIn->makefile);
+    int result = _chdir(moduleIn->directory) == 0
+               ? build_makefile(moduleIn->name, &moduleIn->config, moduleIn->full, serverIn, &moduleIn->apiChanged)
+               : -1;
+    if (back != NULL)
+        _chdir(back);
+    free(back);
+    moduleIn->status = result == 0 ? 2 : 3;
+    return 0;
+#else
+    moduleIn->log = tmpfile();
+    fflush(NULL);
+    moduleIn->pid = fork();
+    if (moduleIn->pid < 0) {
+        perror("fork");
+        moduleIn->status = 3;
+        return -1;
+    }
+    if (moduleIn->pid == 0) {
+        if (moduleIn->log != NULL) {
+            dup2(fileno(moduleIn->log), 1);
+            dup2(fileno(moduleIn->log), 2);
+        }
+        int apiChanged = 0;
+        int result = -1;
+        if (chdir(moduleIn->directory) != 0)
+            perror(moduleIn->directory);
+        else
+            result = build_makefile(moduleIn->name, &moduleIn->config, moduleIn->full, serverIn, &apiChanged);
+        fflush(NULL);
+        _exit(result != 0 ? 1 : apiChanged ? 2 : 0);
+    }
+    return 0;
+#endif
+}
+
+#ifndef _WIN32
+    /* ----------------------------------------------------------------------------------------------------
+     * Waits for one of the running module builds and prints its output in one piece.
+     *
+     * @param Module *modulesIn - The modules.
+     * @param int countIn       - The number of modules.
+     * ---------------------------------------------------------------------------------------------------- */
+    void wait_module(Module *modulesIn, int countIn) {
+        int status = 0;
+        pid_t pid = wait(&status);
+        for (int i = 0; i < countIn; i++) {
+            Module *module = &modulesIn[i];
+            if (module->status != 1 || module->pid != pid)
+                continue;
+
+            int code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+            module->status = code == 0 || code == 2 ? 2 : 3;
+            module->apiChanged = code == 2;
+
+            printf("==> %s\n", module->makefile);
+            if (module->log != NULL) {
+                rewind(module->log);
+                char buffer[4096];
+                size_t n;
+                while ((n = fread(buffer, 1, sizeof(buffer), module->log)) > 0)
+                    fwrite(buffer, 1, n, stdout);
+                fclose(module->log);
+                module->log = NULL;
+            }
+            fflush(stdout);
+            return;
+        }
+    }
+#endif
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the number of cores of this machine, which is the default for the -j option.
+ *
+ * @return int - The number of online processors, at least 1.
+ * -------------------------------------------------------------------------------------------------------- */
+int default_job_count(void) {
+#ifdef _WIN32
+    char *cores = getenv("NUMBER_OF_PROCESSORS");
+    int count = cores ? atoi(cores) : 1;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the modules in the order of their classpaths, up to jobsIn of them at the same time. A module
+ * starts as soon as every module it uses is built, so the build takes as long as its longest chain of
+ * modules. A module whose user changed its api is compiled fully, the state of a module only knows its
+ * own classes. A failed module skips every module that uses it.
+ *
+ * @param Module *modulesIn     - The modules.
+ * @param int countIn           - The number of modules.
+ * @param int jobsIn            - How many modules are built at the same time.
+ * @param int fullIn            - 1 to compile every module fully.
+ * @param int serverIn          - 1 to compile through the compiler server.
+ * @param int *apiChangedOut    - Set to 1 if a module changed an api.
+ * @return int                  - 0 if every module was built, -1 otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int build_modules(Module *modulesIn, int countIn, int jobsIn, int fullIn, int serverIn, int *apiChangedOut) {
+    int result = 0;
+    int running = 0;
+    for (int i = 0; i < countIn; i++)
+        modulesIn[i].full = fullIn;
+
+    for (;;) {
+        int waiting = 0, started = 0;
+        for (int i = 0; i < countIn; i++) {
+            Module *module = &modulesIn[i];
+            if (module->status != 0)
+                continue;
+
+            int ready = 1, failed = 0;
+            for (int d = 0; d < module->depCount; d++) {
+                Module *dep = &modulesIn[module->deps[d]];
+                ready &= dep->status == 2 || dep->status == 3;
+                failed |= dep->status == 3;
+                if (dep->status == 2 && dep->apiChanged && !module->full) {
+                    request_full_build(module->makefile);
+                    module->full = 1;
+                }
+            }
+            if (ready && failed) {
+                fprintf(stderr, "jmake: %s skipped, a module it uses failed.\n", module->makefile);
+                module->status = 3;
+                started++;
+            } else if (ready && running < jobsIn) {
+                start_module(module, serverIn);
+                running += module->status == 1;
+                started++;
+            } else {
+                waiting++;
+            }
+        }
+
+        if (running == 0 && started == 0) {
+            // Nothing runs and nothing can start: what still waits depends on itself.
+            for (int i = 0; i < countIn && waiting > 0; i++) {
+                if (modulesIn[i].status == 0) {
+                    fprintf(stderr, "jmake: %s is part of a cycle of modules.\n", modulesIn[i].makefile);
+                    modulesIn[i].status = 3;
+                }
+            }
+            break;
+        }
+#ifndef _WIN32
+        if (running > 0 && started == 0) {
+            wait_module(modulesIn, countIn);
+            running--;
+        }
+#endif
+    }
+
+    for (int i = 0; i < countIn; i++) {
+        if (modulesIn[i].status == 3)
+            result = -1;
+        *apiChangedOut |= modulesIn[i].apiChanged;
+    }
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Frees the modules.
+ *
+ * @param Module *modulesIn - The modules.
+ * @param int countIn       - The number of modules.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_modules(Module *modulesIn, int countIn) {
+    for (int i = 0; i < countIn; i++) {
+        free(modulesIn[i].makefile);
+        free(modulesIn[i].directory);
+        free(modulesIn[i].name);
+        free(modulesIn[i].real);
+        free(modulesIn[i].realOut);
+        free(modulesIn[i].deps);
+        free_makefile(&modulesIn[i].config);
+    }
+    free(modulesIn);
+}
+
+/* ****************************************END MODULES***************************************************** */
+
+/* ------------------------------------------------------------------------------------------------
+ * The process_makefile function is a pivotal component of our custom "Make" program, designed to
+ * streamline the build process by reading and executing commands from a specified makefile. This
+ * function ensures efficient parsing and execution of build instructions, enhancing productivity
+ * and simplifying project management for developers. The modules of module= are built first, the
+ * sources of the makefile itself last.
+ *
+ * @param filename  The name of the makefile to be processed. This file contains the build instructions
+ *                  to be executed.
+ * @param fullIn    1 to compile every source, not only what changed since the last build.
+ * @param serverIn  1 to compile through the compiler server, also switched on by server=yes.
+ * @param jobsIn    How many modules are built at the same time.
+ * ------------------------------------------------------------------------------------------------- */
+void process_makefile(const char *filename, int fullIn, int serverIn, int jobsIn) {
+    JMakefile make;
+    if (parse_makefile(filename, &make) != 0)
+        exit(EXIT_FAILURE);
+    serverIn |= make.server;
+
+    int result = 0;
+    int apiChanged = 0;
+    if (make.moduleCount > 0) {
+        Module *modules = NULL;
+        int count = load_modules(&make, &modules);
+        result = count < 0 ? -1 : build_modules(modules, count, jobsIn, fullIn, serverIn, &apiChanged);
+        free_modules(modules, count < 0 ? make.moduleCount : count);
+    }
+
+    // A makefile with modules only has no sources of its own.
+    if (make.src[0] != '\0' || make.moduleCount == 0) {
+        if (apiChanged)
+            request_full_build(filename);
+        int ownApi = 0;
+        if (result == 0)
+            result = build_makefile(filename, &make, fullIn, serverIn, &ownApi);
+    }
+    free_makefile(&make);
+
+    if (result != 0)
+        exit(EXIT_FAILURE);
+}
+
+// ---------------------------------------------------------------------------------------------
+// main - The main function is the starting point of a C or C++ program, where execution begins.
+// This version of the main function allows the program to take command-line arguments when it
+// runs. The function typically returns an numbered value to the operating system, often zero
+// to signify successful execution.
+//
+// @param argc  The number of command-line arguments.
+// @param argv  The array of command-line arguments.
+// @return      0 on successful completion, 1 on error.
+// ----------------------------------------------------------------------------------------------
+int main (int argc, char **argv) {
+    // Check if the help is triggered.
+    if(isHelpTriggered(argc, argv[1])) {
+        print_help();
+        return 1;
+    }
+
+    // jmake --stop ends the compiler server of the current directory.
+    if (strcmp(argv[1], "--stop") == 0) {
+        printf(stop_server() ? "Compiler server stopped.\n" : "No compiler server running.\n");
+        return EXIT_SUCCESS;
+    }
+
+    int full = 0, server = 0, jobs = default_job_count();
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--full") == 0)
+            full = 1;
+        else if (strcmp(argv[i], "--server") == 0)
+            server = 1;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            jobs = atoi(argv[++i]);
+        else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0')
+            jobs = atoi(argv[i] + 2);
+        else
+            fprintf(stderr, "jmake: unknown option %s ignored.\n", argv[i]);
+    }
+    process_makefile(argv[1], full, server, jobs > 0 ? jobs : 1);
+    return EXIT_SUCCESS;
+}
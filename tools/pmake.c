@@ -42,6 +42,52 @@
  * Sun 2025-04-06 BugFix in with the library string. strcpy wasn't working.             Version: 00.16
  * Sun 2025-04-06 BugFix in the library string. Switched to append_format.              Version: 00.17
  * Sun 2025-04-06 Making sure that the bug fix doesn't influence the make_process.      Version: 00.18   
+ * Sat 2026-10-17 Every source file is now compiled into its own object file by a       Version: 00.19
+ *                parallel job scheduler (-j N, default is the number of cores) and
+ *                linked in one final step.
+ * Sat 2026-10-17 Incremental builds. A build state file in .pmake/ remembers source    Version: 00.20
+ *                stamps, content hashes and command lines, only changed translation
+ *                units are compiled and the link step runs only if an object changed.
+ * Sat 2026-10-17 Header dependencies. Compiles write -MMD depfiles, the headers they   Version: 00.21
+ *                list are stored with their stamps in the build state and editing a
+ *                header rebuilds exactly the translation units that include it.
+ * Sat 2026-10-17 Compilation cache. Objects are stored in a content addressed cache    Version: 00.22
+ *                in the user's home, keyed by preprocessed source, compiler identity
+ *                and flags, and shared by all projects. New option --cache-stats.
+ * Sat 2026-10-17 Multi-target makefiles. Every project= line starts a new target,      Version: 00.23
+ *                deps= names the targets it depends on, and all targets are built
+ *                in one job graph that only serializes the link steps of dependents.
+ * Sat 2026-10-17 Workspace builds. --workspace <dir> builds every *.makefile below     Version: 00.24
+ *                a directory with one shared job pool, orders the projects by the
+ *                libraries and objects they link and keeps going after failures.
+ * Sat 2026-10-17 Build timing. Every job is timed including the time it waits for a    Version: 00.25
+ *                worker, --trace writes a Chrome trace and --slowest N prints the
+ *                slowest translation units and link steps.
+ * Sat 2026-10-17 Unity builds. unity=yes compiles the sources of a target in batched   Version: 00.26
+ *                unity translation units, one batch per core, generated under .pmake/.
+ * Sat 2026-10-17 Build profiles. profile=debug|release|lto|pgo sets the optimization   Version: 00.27
+ *                flags, pgo builds an instrumented artifact, runs the train= command
+ *                and compiles everything again with the collected profile.
+ * Sat 2026-10-17 compile_commands.json is written next to every makefile. --dry-run    Version: 00.28
+ *                prints the planned jobs with the reason of each, cache hits are
+ *                predicted from manifests without running the preprocessor.
+ * Sat 2026-10-17 Build server. --serve keeps the workspace resident, watches the       Version: 00.29
+ *                tree with inotify and rebuilds on change, plain runs become clients
+ *                of the server over a Unix socket, --stop ends it.
+ * Sat 2026-10-17 Distributed compilation. --worker runs pmake as a compile worker,     Version: 00.30
+ *                --workers ships preprocessed units to such workers over TCP and
+ *                gets the objects back, linking stays local.
+ * Sat 2026-10-17 Precompiled headers. pch=<header> precompiles the header once per     Version: 00.31
+ *                set of flags and injects it into every compile of the target.
+ * Sat 2026-10-17 Commands without shell syntax are split into argv and started with    Version: 00.32
+ *                posix_spawn, the output of every job is collected through a pipe
+ *                and printed in one piece when the job finished.
+ * Sat 2026-10-17 The makefile is mapped and parsed into arena strings, values have no  Version: 00.33
+ *                length limit and may continue over several lines, src= and libs=
+ *                accept glob patterns like *.c.
+ * Sat 2026-10-17 ** patterns, directories and !excludes in src= and libs=. Directories Version: 00.34
+ *                are read with getdents64 on Linux and their listings are cached in
+ *                the build state as long as their modification time is unchanged.
  * -----------------------------------------------------------------------------------------------------
  * To Do's:
  * - Take cVersion.h & cVersion.c appart and integrate it directly into this code base.             Done.                             Done.
@@ -51,18 +97,32 @@
  * - Make sure if the library string isn't in the end, the program doesn't crash.                   Done.
  * *****************************************************************************************************/
 
+// glibc declares posix_spawn_file_actions_addchdir_np only for GNU sources.
+#ifdef __linux__
+    #define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <time.h>
 
 #ifdef _WIN32
     
     // Include Windows relevant libraries
     #include <io.h>
+    #include <direct.h>
+    #include <sys/stat.h>
+    #include <process.h>
+    #include <dirent.h>
     
     #define _home() getenv("USERPROFILE")
+    #define _makedir(p) _mkdir(p)
+    #define _hardlink(from, to) (-1)
+    #define getpid() _getpid()
+    #define _mtime_ns(st) ((long long)(st).st_mtime * 1000000000LL)
 
     /* ----------------------------------------------------------------------------------------------------
      * Windows version:
@@ -134,8 +194,41 @@
 #else
     // Include Unix relevant libraries
     #include <unistd.h>
+    #include <errno.h>
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <netdb.h>
+    #include <fcntl.h>
+    #include <dirent.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <spawn.h>
+    #include <sys/mman.h>
+
+    // posix_spawn can change the directory of the child since glibc 2.29 and macOS 10.15.
+    #if defined(__APPLE__) || (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29)))
+        #define PMAKE_SPAWN_CHDIR
+    #endif
+
+    extern char **environ;
+
+    #ifdef __linux__
+        #include <sys/inotify.h>
+        #include <sys/syscall.h>
+    #endif
 
     #define _home() getenv("HOME")
+    #define _makedir(p) mkdir(p, 0755)
+    #define _hardlink(from, to) link(from, to)
+
+    #ifdef __APPLE__
+        #define _mtime_ns(st) ((long long)(st).st_mtimespec.tv_sec * 1000000000LL + (st).st_mtimespec.tv_nsec)
+    #else
+        #define _mtime_ns(st) ((long long)(st).st_mtim.tv_sec * 1000000000LL + (st).st_mtim.tv_nsec)
+    #endif
 
     /* -------------------------------------------------------------------------------------------------
      * MacOS version:
@@ -412,8 +505,6 @@ int isHelpTriggered(int argcIn, char *argvIn) {
 
 /* ***************************************END INTEGRATION************************************************* */
 
-#define MAX_LINE_LENGTH 256
-
 /* -------------------------------------------------------------------------------------------------------
  * The print_help function is our top-notch guidance feature, crafted to provide users with clear,
  * intuitive instructions for leveraging our command-line utility within the Windows Command Prompt
@@ -433,7 +524,7 @@ int isHelpTriggered(int argcIn, char *argvIn) {
 void print_help() {
 
     // Version control implemented
-    Version v = create_version(0, 18);
+    Version v = create_version(0, 34);
     
     // The buffer is needed to write
     // the correct formated version number.
@@ -459,7 +550,13 @@ void print_help() {
     append_format(&manpage, "       turnaround times and improved project management.\n");
     append_format(&manpage, "\n");
     append_format(&manpage, "SYNOPSIS\n");
-    append_format(&manpage, "       pmake <makefile>\n");
+    append_format(&manpage, "       pmake [-j N] [--no-cache] [--dry-run] [--trace <file>] [--slowest N] <makefile>\n");
+    append_format(&manpage, "       pmake [-j N] [--no-cache] [--dry-run] [--trace <file>] [--slowest N] --workspace <dir>\n");
+    append_format(&manpage, "       pmake [-j N] --serve <makefile> | --serve --workspace <dir>\n");
+    append_format(&manpage, "       pmake --stop <makefile> | --stop --workspace <dir>\n");
+    append_format(&manpage, "       pmake [-j N] --workers <host:port[/slots],...> <makefile>\n");
+    append_format(&manpage, "       pmake [-j N] --worker [host:]port\n");
+    append_format(&manpage, "       pmake --cache-stats\n");
     append_format(&manpage, "       pmake <-h\\-help\\-H\\-Help>\n");
     append_format(&manpage, "\n");
     append_format(&manpage, "DESCRIPTION\n");
@@ -487,6 +584,124 @@ void print_help() {
     append_format(&manpage, "           libs=../mylibs/lib1.o ../mylibs/lib2.o\n");
     append_format(&manpage, "           ---------------------------------------\n");
     append_format(&manpage, "\n");
+    append_format(&manpage, "           A value has no length limit. Lines that start no directive of\n");
+    append_format(&manpage, "           their own continue the value of the line above, a trailing\n");
+    append_format(&manpage, "           backslash is allowed. src= and libs= take glob patterns, for\n");
+    append_format(&manpage, "           example src=main.c md4c/*.c, expanded in sorted order. **\n");
+    append_format(&manpage, "           crosses directories (src/**/*.c), a directory like md4c/\n");
+    append_format(&manpage, "           stands for every source below it and a word starting with !\n");
+    append_format(&manpage, "           excludes matches again: src=src/ !*_test.c !src/bench/**\n");
+    append_format(&manpage, "           Hidden files and directories are skipped. The listings are\n");
+    append_format(&manpage, "           cached in the build state and a directory is only read again\n");
+    append_format(&manpage, "           when its modification time changed.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           A makefile can hold several projects. Every project= line starts\n");
+    append_format(&manpage, "           a new target, directives above the first project= line are the\n");
+    append_format(&manpage, "           defaults of all targets. deps= lists the projects that have to\n");
+    append_format(&manpage, "           be built before a target is linked:\n");
+    append_format(&manpage, "           ---------------------------------------\n");
+    append_format(&manpage, "           comp=gcc\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           project=bin/libSamael\n");
+    append_format(&manpage, "           target=shared\n");
+    append_format(&manpage, "           src=Samael.c Framework.c\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           project=enigma\n");
+    append_format(&manpage, "           deps=bin/libSamael\n");
+    append_format(&manpage, "           libs=-Lbin -lSamael\n");
+    append_format(&manpage, "           ---------------------------------------\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           profile= selects the optimization flags of a target:\n");
+    append_format(&manpage, "             debug    -O0 -g\n");
+    append_format(&manpage, "             release  -O2 -DNDEBUG\n");
+    append_format(&manpage, "             lto      -O2 -DNDEBUG -flto, for compiling and linking\n");
+    append_format(&manpage, "             pgo      release, built twice: first instrumented, then\n");
+    append_format(&manpage, "                      the train= command runs, for example\n");
+    append_format(&manpage, "                      train=./enigma < corpus.txt, and everything is\n");
+    append_format(&manpage, "                      compiled again with the collected profile. With\n");
+    append_format(&manpage, "                      clang the profile is merged by llvm-profdata.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           unity=yes compiles the sources of a target in unity batches:\n");
+    append_format(&manpage, "           every batch is a generated file that #includes its share of\n");
+    append_format(&manpage, "           the sources, with one batch per core. Many small files then\n");
+    append_format(&manpage, "           cost one compiler start and one pass over the headers per\n");
+    append_format(&manpage, "           batch. The sources must not define conflicting static names.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "           pch=Samael.h precompiles an umbrella header once per set of\n");
+    append_format(&manpage, "           flags under .pmake/pch/ and compiles every unit of the target\n");
+    append_format(&manpage, "           with it (-include for gcc, -include-pch for clang). A change\n");
+    append_format(&manpage, "           of the header or of anything it includes builds it again,\n");
+    append_format(&manpage, "           together with all units of the target.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       -j N   Compile up to N translation units at the same time. Every\n");
+    append_format(&manpage, "              .c file of src= and libs= is compiled into its own object\n");
+    append_format(&manpage, "              file under .pmake/ and all objects are linked in one final\n");
+    append_format(&manpage, "              step. Defaults to the number of cores.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --workspace <dir>\n");
+    append_format(&manpage, "              Build every *.makefile below <dir> in one run. The order of\n");
+    append_format(&manpage, "              the projects is inferred from what they link: an object or\n");
+    append_format(&manpage, "              library in libs=, or a lib<name> found through -L and -l,\n");
+    append_format(&manpage, "              that another makefile produces is built first. All projects\n");
+    append_format(&manpage, "              share one pool of -j jobs, a failure only stops the projects\n");
+    append_format(&manpage, "              that depend on it, and a summary lists every target.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --dry-run\n");
+    append_format(&manpage, "              Print the jobs the build would run, each with the reason it is\n");
+    append_format(&manpage, "              needed (not built yet, source changed, header changed, command\n");
+    append_format(&manpage, "              changed, cache hit, ...) and the jobs it waits for. Nothing is\n");
+    append_format(&manpage, "              compiled. Every run, also a dry run, writes compile_commands.json\n");
+    append_format(&manpage, "              next to the makefile, with one entry per source, also for\n");
+    append_format(&manpage, "              unity=yes.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --trace <file>\n");
+    append_format(&manpage, "              Write the timing of every preprocess, compile and link step\n");
+    append_format(&manpage, "              as a Chrome trace (chrome://tracing, ui.perfetto.dev). Each\n");
+    append_format(&manpage, "              worker is one lane, the time a step waited for a free worker\n");
+    append_format(&manpage, "              shows up as a queue slice.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --slowest N\n");
+    append_format(&manpage, "              Print the N slowest steps after the build, with the time they\n");
+    append_format(&manpage, "              ran and the time they waited for a worker.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --serve\n");
+    append_format(&manpage, "              Run as a build server for the makefile or workspace. The\n");
+    append_format(&manpage, "              parsed makefiles, the dependency graph and the stamps of all\n");
+    append_format(&manpage, "              files stay in memory, the source tree is watched with inotify\n");
+    append_format(&manpage, "              (polled elsewhere) and the affected targets are rebuilt as\n");
+    append_format(&manpage, "              soon as files change. A plain pmake run on the same makefile\n");
+    append_format(&manpage, "              asks the server over .pmake/<makefile>.sock and prints its\n");
+    append_format(&manpage, "              output. Not available on Windows.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --stop Stop the build server of the makefile or workspace.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --workers <host:port[/slots],...>\n");
+    append_format(&manpage, "              Ship compiles to pmake --worker processes. The preprocessor\n");
+    append_format(&manpage, "              runs here, the preprocessed unit is compiled by a worker with\n");
+    append_format(&manpage, "              a free slot and the object comes back, linking stays local.\n");
+    append_format(&manpage, "              Without /slots a worker takes as many compiles as this host\n");
+    append_format(&manpage, "              has cores. Unless -j is given, -j grows by all worker slots.\n");
+    append_format(&manpage, "              If a worker can't be reached the unit is compiled here.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --worker [host:]port\n");
+    append_format(&manpage, "              Run as a compile worker with -j slots. Without a host it only\n");
+    append_format(&manpage, "              listens on 127.0.0.1, 0.0.0.0:port listens on all interfaces.\n");
+    append_format(&manpage, "              A worker only runs cc, gcc, g++, clang and their versions\n");
+    append_format(&manpage, "              from its PATH, with -O, -W, -m, -g, -std=, -D, -U, -I and\n");
+    append_format(&manpage, "              a list of known -f flags. Any other flag, and any flag that\n");
+    append_format(&manpage, "              takes a path, is refused and the unit compiled locally.\n");
+    append_format(&manpage, "              Only expose it to trusted hosts.\n");
+    append_format(&manpage, "              Not on Windows.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --no-cache\n");
+    append_format(&manpage, "              Don't use the compilation cache. By default every object is\n");
+    append_format(&manpage, "              stored in ~/.local/share/pmake/cache (or $PMAKE_CACHE_DIR),\n");
+    append_format(&manpage, "              keyed by the preprocessed source, the compiler and the flags,\n");
+    append_format(&manpage, "              and identical compiles of any project are taken from there.\n");
+    append_format(&manpage, "\n");
+    append_format(&manpage, "       --cache-stats\n");
+    append_format(&manpage, "              Print the hits, misses and bytes saved of the cache and exit.\n");
+    append_format(&manpage, "\n");
     append_format(&manpage, "       -h, -help -H -Help\n");
     append_format(&manpage, "              Display this help and exit.\n");
     append_format(&manpage, "\n");
@@ -506,148 +721,5421 @@ void print_help() {
     free(manpage);
 }
 
-/* ------------------------------------------------------------------------------------------------
- * The process_makefile function is a pivotal component of our custom "Make" program, designed to
- * streamline the build process by reading and executing commands from a specified makefile. This
- * function ensures efficient parsing and execution of build instructions, enhancing productivity
- * and simplifying project management for developers.
+
+/* --------------------------------------------------------------------------------------------------------
+ * Checks whether a word from the src= or libs= directive is a translation unit pmake has to compile.
+ * Everything else (object files, -L and -l options, ...) is handed to the linker as it is.
  *
- * @param filename  The name of the makefile to be processed. This file contains the build instructions
- *                  to be executed.
- * ------------------------------------------------------------------------------------------------- */
-void process_makefile(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("fopen");
-        exit(EXIT_FAILURE);
+ * @param const char *wordIn - The word to check.
+ * @return int               - 1 if the word is a C/C++ source file, 0 otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int is_source_file(const char *wordIn) {
+    const char *dot = strrchr(wordIn, '.');
+    if (dot == NULL)
+        return 0;
+    return strcmp(dot, ".c") == 0 || strcmp(dot, ".cc") == 0 ||
+           strcmp(dot, ".cpp") == 0 || strcmp(dot, ".cxx") == 0 || strcmp(dot, ".m") == 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Splits a string into its whitespace separated words. The string is modified in place, the returned
+ * array points into it.
+ *
+ * @param char *textIn      - The string to split.
+ * @param int *countOut     - Receives the number of words.
+ * @return char**           - The array of words, the caller frees it (but not the words).
+ * -------------------------------------------------------------------------------------------------------- */
+char **split_words(char *textIn, int *countOut) {
+    int capacity = 16;
+    char **words = malloc(sizeof(char *) * capacity);
+    *countOut = 0;
+
+    if (words == NULL || textIn == NULL)
+        return words;
+
+    for (char *word = strtok(textIn, " \t\r\n"); word != NULL; word = strtok(NULL, " \t\r\n")) {
+        if (*countOut == capacity) {
+            capacity *= 2;
+            char **grown = realloc(words, sizeof(char *) * capacity);
+            if (grown == NULL) {
+                perror("realloc failed");
+                break;
+            }
+            words = grown;
+        }
+        words[(*countOut)++] = word;
     }
-    
-    char line[MAX_LINE_LENGTH];
-    char comp[50] = "gcc";
-    char cflags[100] = "";
-    char target[10] = "exec";
-    char project[50] = "";
-    char src[500] = "";
-    char* libs = NULL;
-    
-    int isLibs = -1;
 
-    while (fgets(line, sizeof(line), file)) {
-        
-        // Trim newline character
-        line[strcspn(line, "\n")] = 0;
-        
-        // Skip empty lines or comments
-        if (line[0] == '\0' || line[0] == '#') continue;
-        
-        // Parse the makefile variables
-        if (strncmp(line, "comp=", 5) == 0) {
-            isLibs = -1;
-            strcpy(comp, line + 5);
-        } else if (strncmp(line, "cflags=", 7) == 0) {
-            isLibs = -1;
-            strcpy(cflags, line + 7);
-        } else if (strncmp(line, "target=", 7) == 0) {
-            isLibs = -1;
-            strcpy(target, line + 7);
-        } else if (strncmp(line, "project=", 8) == 0) {
-            isLibs = -1;
-            strcpy(project, line + 8);
-        } else if (strncmp(line, "src=", 4) == 0) {
-            isLibs = -1;
-            strcpy(src, line + 4);
-        } else if (strncmp(line, "libs=", 5) == 0 || isLibs) {
-            isLibs = 1;
-            if(strncmp(line, "libs=", 5) == 0) 
-                append_format(&libs, "%s ", line + 5);
+    return words;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Tells whether a command needs /bin/sh: redirections, pipes, variables, globs and the like. Compiler
+ * and linker commands don't, they are started directly without a shell in between.
+ *
+ * @param const char *commandIn - The command.
+ * @return int                  - 1 if the command has to run through the shell.
+ * -------------------------------------------------------------------------------------------------------- */
+int needs_shell(const char *commandIn) {
+    char quote = '\0';
+    for (const char *p = commandIn; *p; p++) {
+        if (quote != '\0') {
+            if (*p == quote)
+                quote = '\0';
+            else if (quote == '"' && (*p == '$' || *p == '`'))
+                return 1;
+        } else if (*p == '\'' || *p == '"') {
+            quote = *p;
+        } else if (*p == '\\' && p[1] != '\0') {
+            p++;
+        } else if (strchr("|&;<>()$`*?[]{}~#!\n", *p) != NULL) {
+            return 1;
+        }
+    }
+
+    // VAR=value command sets the environment of the command.
+    const char *end = commandIn + strcspn(commandIn, " \t");
+    const char *equals = strchr(commandIn, '=');
+    return equals != NULL && equals < end;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Splits a command into the argument vector the shell would make of it: words are separated by blanks,
+ * single quotes keep everything literally, double quotes keep blanks, a backslash escapes the next
+ * character. Only meant for commands needs_shell() accepts.
+ *
+ * @param const char *commandIn - The command.
+ * @param char **textOut        - Receives the storage of the words, the caller frees it.
+ * @return char**               - The NULL terminated arguments, the caller frees the array.
+ * -------------------------------------------------------------------------------------------------------- */
+char **split_command(const char *commandIn, char **textOut) {
+    size_t length = strlen(commandIn);
+    char *text = malloc(length + 1);
+    char **argv = malloc(sizeof(char *) * (length / 2 + 2));
+    int count = 0;
+
+    char *out = text;
+    const char *p = commandIn;
+    while (*p) {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '\0')
+            break;
+
+        argv[count++] = out;
+        char quote = '\0';
+        for (; *p && (quote != '\0' || (*p != ' ' && *p != '\t')); p++) {
+            if (quote == '\0' && (*p == '\'' || *p == '"'))
+                quote = *p;
+            else if (quote != '\0' && *p == quote)
+                quote = '\0';
+            else if (quote != '\'' && *p == '\\' && p[1] != '\0')
+                *out++ = *++p;
             else
-                append_format(&libs, "%s ", line);
+                *out++ = *p;
         }
+        *out++ = '\0';
     }
-    
+
+    argv[count] = NULL;
+    *textOut = text;
+    return argv;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * An Arena hands out memory from large blocks and frees all of it at once. Everything read from a
+ * makefile lives in the arena of its project, so the values of a makefile have no size limit and cost
+ * neither a malloc nor a free each.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;    // The block allocated before this one.
+    size_t used;                // Bytes handed out from data.
+    size_t size;                // Size of data.
+    char data[];                // The memory.
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks;         // The newest block, the others follow through next.
+} Arena;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A StringView is a piece of a larger text, for example a value inside a mapped makefile. It is not
+ * terminated, only its length tells where it ends.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    const char *data;           // The first character.
+    size_t length;              // The number of characters.
+} StringView;
+
+/* --------------------------------------------------------------------------------------------------------
+ * Allocates memory from an arena.
+ *
+ * @param Arena *arenaIn    - The arena.
+ * @param size_t sizeIn     - The number of bytes.
+ * @return char*            - The memory, valid until the arena is freed, NULL if memory ran out.
+ * -------------------------------------------------------------------------------------------------------- */
+char *arena_alloc(Arena *arenaIn, size_t sizeIn) {
+    ArenaBlock *block = arenaIn->blocks;
+    if (block == NULL || block->size - block->used < sizeIn) {
+        size_t size = sizeIn > 65536 ? sizeIn : 65536;
+        block = malloc(sizeof(ArenaBlock) + size);
+        if (block == NULL) {
+            perror("malloc failed");
+            return NULL;
+        }
+        block->next = arenaIn->blocks;
+        block->used = 0;
+        block->size = size;
+        arenaIn->blocks = block;
+    }
+
+    char *memory = block->data + block->used;
+    block->used += sizeIn;
+    return memory;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Joins string views into one terminated string in an arena, separated by single blanks.
+ *
+ * @param Arena *arenaIn        - The arena.
+ * @param StringView *viewsIn   - The pieces.
+ * @param int countIn           - The number of pieces.
+ * @return const char*          - The joined string.
+ * -------------------------------------------------------------------------------------------------------- */
+const char *arena_join(Arena *arenaIn, StringView *viewsIn, int countIn) {
+    size_t length = 0;
+    for (int i = 0; i < countIn; i++)
+        length += viewsIn[i].length + 1;
+
+    char *text = arena_alloc(arenaIn, length + 1);
+    if (text == NULL)
+        return "";
+
+    char *out = text;
+    for (int i = 0; i < countIn; i++) {
+        if (i > 0)
+            *out++ = ' ';
+        memcpy(out, viewsIn[i].data, viewsIn[i].length);
+        out += viewsIn[i].length;
+    }
+    *out = '\0';
+    return text;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Frees all memory of an arena.
+ *
+ * @param Arena *arenaIn - The arena.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_arena(Arena *arenaIn) {
+    while (arenaIn->blocks != NULL) {
+        ArenaBlock *next = arenaIn->blocks->next;
+        free(arenaIn->blocks);
+        arenaIn->blocks = next;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Maps a whole file into memory read only. Windows reads it into a buffer instead.
+ *
+ * @param const char *pathIn    - The file.
+ * @param size_t *sizeOut       - Receives the size of the file.
+ * @return const char*          - The content, NULL if the file can't be read. Release it with unmap_file.
+ * -------------------------------------------------------------------------------------------------------- */
+const char *map_file(const char *pathIn, size_t *sizeOut) {
+#ifdef _WIN32
+    FILE *file = fopen(pathIn, "rb");
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = malloc(size > 0 ? size : 1);
+    *sizeOut = data ? fread(data, 1, size > 0 ? size : 0, file) : 0;
+    fclose(file);
+    return data;
+#else
+    int fd = open(pathIn, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    const char *data = NULL;
+    if (fstat(fd, &st) == 0) {
+        *sizeOut = (size_t)st.st_size;
+        // An empty file can't be mapped, any non NULL pointer does.
+        data = st.st_size == 0 ? "" : mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+            data = NULL;
+    }
+    close(fd);
+    return data;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Releases a file mapped by map_file.
+ * -------------------------------------------------------------------------------------------------------- */
+void unmap_file(const char *dataIn, size_t sizeIn) {
+#ifdef _WIN32
+    (void)sizeIn;
+    free((char *)dataIn);
+#else
+    if (sizeIn > 0)
+        munmap((void *)dataIn, sizeIn);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Creates a directory and all its missing parents, like mkdir -p does.
+ *
+ * @param const char *pathIn - The directory to create.
+ * -------------------------------------------------------------------------------------------------------- */
+void make_directories(const char *pathIn) {
+    char *path = NULL;
+    append_format(&path, "%s", pathIn);
+
+    for (char *p = path + 1; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            char c = *p;
+            *p = '\0';
+            _makedir(path);
+            *p = c;
+        }
+    }
+    _makedir(path);
+    free(path);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Every project gets its own build directory .pmake/<project> next to the makefile, so the same source
+ * compiled with different flags by two projects never shares an object file.
+ *
+ * @param const char *makefileIn - The path of the makefile.
+ * @param const char *projectIn  - The project name of the makefile.
+ * @return char*                 - The build directory, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *build_directory(const char *makefileIn, const char *projectIn) {
+    char *directory = NULL;
+    const char *slash = strrchr(makefileIn, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(makefileIn, '\\');
+    if (backslash > slash) slash = backslash;
+#endif
+
+    if (slash != NULL)
+        append_format(&directory, "%.*s/", (int)(slash - makefileIn), makefileIn);
+    append_format(&directory, ".pmake/%s", projectIn);
+    return directory;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Derives the object file of a translation unit inside the build directory. Path separators and parent
+ * directory references are flattened, so ToolBox/cManPage.c becomes ToolBox_cManPage.o and
+ * ../mylibs/Framework.c becomes __mylibs_Framework.o.
+ *
+ * @param const char *buildDirIn - The build directory of the project.
+ * @param const char *sourceIn   - The translation unit.
+ * @return char*                 - The object file path, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *object_name(const char *buildDirIn, const char *sourceIn) {
+    char *object = NULL;
+    append_format(&object, "%s/", buildDirIn);
+
+    size_t start = strlen(object);
+    append_format(&object, "%s", sourceIn);
+
+    char *dot = strrchr(object + start, '.');
+    if (dot != NULL) *dot = '\0';
+
+    for (char *p = object + start; *p; p++)
+        if (*p == '/' || *p == '\\' || (*p == '.' && (p[1] == '.' || p[1] == '/' || p[1] == '\\')))
+            *p = '_';
+
+    append_format(&object, ".o");
+    return object;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes a generated file only if its content differs from what is already there, so an unchanged file
+ * keeps its stamp and doesn't look modified to the build state.
+ *
+ * @param const char *pathIn    - The file.
+ * @param const char *contentIn - The new content.
+ * -------------------------------------------------------------------------------------------------------- */
+void write_if_changed(const char *pathIn, const char *contentIn) {
+    size_t length = strlen(contentIn);
+    FILE *file = fopen(pathIn, "rb");
+
+    if (file != NULL) {
+        char *old = malloc(length + 2);
+        size_t read = old ? fread(old, 1, length + 1, file) : 0;
+        int same = old != NULL && read == length && memcmp(old, contentIn, length) == 0;
+        free(old);
+        fclose(file);
+        if (same)
+            return;
+    }
+
+    file = fopen(pathIn, "wb");
+    if (file == NULL) {
+        perror(pathIn);
+        return;
+    }
+    fwrite(contentIn, 1, length, file);
     fclose(file);
+}
 
-    char *command = NULL;
+/* ***************************************START BUILD STATE************************************************ */
 
-    // Step 1: Start with the compiler in the command.
-    append_format(&command, "%s ", comp);
+/* --------------------------------------------------------------------------------------------------------
+ * A FileStamp is the cheap identity of a file: its modification time in nanoseconds and its size. If both
+ * are unchanged, pmake trusts that the content is unchanged as well and never opens the file.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    long long mtime;    // Modification time in nanoseconds.
+    long long size;     // Size in bytes.
+} FileStamp;
 
-    // Step 2: Set the flags if there are any.
-    if(cflags[0] != '\0')
-        append_format(&command, "%s ", cflags);
+/* --------------------------------------------------------------------------------------------------------
+ * A header a translation unit included the last time it was compiled, together with the stamp and content
+ * hash the header had back then.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *path;                 // The header as written in the depfile.
+    FileStamp stamp;            // Stamp of the header when the object was built.
+    unsigned long long hash;    // Content hash of the header when the object was built.
+} Dependency;
 
-    // Step 3: Check the target, is it object, exec or shared.
-    if(target[0] == 's')
-        append_format(&command, "-shared ");
-    else if(target[0] == 'o')
-        append_format(&command, "-c ");
+/* --------------------------------------------------------------------------------------------------------
+ * One line of the build state file. For a compile job the key is the object file, for a link job it is
+ * the final artifact. The hash is the content hash of the source for compile records and a fingerprint
+ * over all link inputs for link records.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char type;                  // 'O' for an object, 'L' for a link output.
+    char *key;                  // The file produced by the job.
+    char *source;               // The translation unit, empty for link records.
+    FileStamp stamp;            // Stamp of the source at the time it was compiled.
+    unsigned long long hash;    // Content hash or input fingerprint.
+    char *command;              // The exact command line that produced the key.
+    int valid;                  // 1 if the record describes the file on disk.
+    Dependency *deps;           // Headers of the translation unit, from its depfile.
+    int depCount;               // Number of headers.
+} StateRecord;
 
-    if(src[0] != '\0')
-        append_format(&command, "%s ", src);
-    else
-        append_format(&command, "%s.c ", project);
+/* --------------------------------------------------------------------------------------------------------
+ * The BuildState is the in-memory image of the state file. Records are found through a small open
+ * addressing hash index keyed by the record key, so even thousands of objects are looked up in O(1).
+ * Next to the records the state caches the stamp and hash of every file it looked at during this run,
+ * because a header like Samael.h is shared by nearly every translation unit and one stat() is enough.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *path;                 // The file.
+    int exists;                 // 1 if stat() found the file.
+    FileStamp stamp;            // Its current stamp.
+    int hashed;                 // 1 once the content hash was computed.
+    unsigned long long hash;    // Its current content hash.
+} FileInfo;
 
-    if(libs[0] != '\0')
-        append_format(&command, "%s ", libs);
+/* --------------------------------------------------------------------------------------------------------
+ * A DirListing is the cached content of a directory a glob pattern walked through. It is kept in the
+ * state file and trusted as long as the modification time of the directory is unchanged, so a tree of
+ * thousands of sources costs one stat() per directory instead of a full walk.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *path;             // The directory as the pattern names it, "." for the one of the makefile.
+    long long mtime;        // Modification time of the directory when it was read, -1 to read it again.
+    char **names;           // The entries without hidden ones, directories end in '/'.
+    int count;              // Number of entries.
+    int used;               // 1 if a pattern of this run looked at it, only those are saved.
+} DirListing;
 
+typedef struct {
+    StateRecord *records;   // All records.
+    int count;              // Number of records.
+    int capacity;           // Allocated number of records.
+    int *index;             // Hash index of record positions, -1 marks a free slot.
+    int indexSize;          // Number of slots, always a power of two.
+    FileInfo *files;        // Files looked at during this run, each one is stat'ed only once.
+    int fileCount;          // Number of files.
+    int fileSize;           // Number of slots in files, always a power of two.
+    DirListing *dirs;       // Directory listings for glob patterns, hashed by path like files.
+    int dirCount;           // Number of listings.
+    int dirSize;            // Number of slots in dirs, always a power of two.
+} BuildState;
 
-    #ifdef _WIN32
-        // Windows version
-        if(target[0] == 's')
-            append_format(&command, "-o %s.dll", project);
-        else if(target[0] == 'o')
-            append_format(&command, "-o %s.o", project);
-        else
-            append_format(&command, "-o %s", project);
-    #else
-        // Unix version
-        if(target[0] == 's')
-            append_format(&command, "-o %s.so", project);
-        else if(target[0] == 'o')
-            append_format(&command, "-o %s.o", project);
-        else
-            append_format(&command, "-o %s", project);
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME  1099511628211ULL
 
-    #endif
+/* --------------------------------------------------------------------------------------------------------
+ * Continues a 64 bit FNV-1a hash over a block of memory. FNV-1a is tiny, fast enough for source files and
+ * needs no library, which keeps pmake a single self contained code file.
+ *
+ * @param unsigned long long hashIn - The hash so far, FNV_OFFSET to start a new one.
+ * @param const void *dataIn        - The data to hash.
+ * @param size_t lengthIn           - The number of bytes.
+ * @return unsigned long long       - The updated hash.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long hash_bytes(unsigned long long hashIn, const void *dataIn, size_t lengthIn) {
+    const unsigned char *data = dataIn;
+    for (size_t i = 0; i < lengthIn; i++) {
+        hashIn ^= data[i];
+        hashIn *= FNV_PRIME;
+    }
+    return hashIn;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Continues a hash over a string including its terminating zero, so "ab"+"c" and "a"+"bc" differ.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long hash_string(unsigned long long hashIn, const char *textIn) {
+    return hash_bytes(hashIn, textIn, strlen(textIn) + 1);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads the stamp of a file.
+ *
+ * @param const char *pathIn    - The file.
+ * @param FileStamp *stampOut   - Receives modification time and size.
+ * @return int                  - 0 on success, -1 if the file doesn't exist.
+ * -------------------------------------------------------------------------------------------------------- */
+int stamp_file(const char *pathIn, FileStamp *stampOut) {
+    struct stat st;
+    if (stat(pathIn, &st) != 0)
+        return -1;
+    stampOut->mtime = _mtime_ns(st);
+    stampOut->size = (long long)st.st_size;
+    return 0;
+}
 
-    printf("Compiling command:\n");
-    printf("%s\n", command);
+/* --------------------------------------------------------------------------------------------------------
+ * Computes the content hash of a file.
+ *
+ * @param const char *pathIn            - The file.
+ * @param unsigned long long *hashOut   - Receives the hash.
+ * @return int                          - 0 on success, -1 if the file can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int hash_file(const char *pathIn, unsigned long long *hashOut) {
+    FILE *file = fopen(pathIn, "rb");
+    if (file == NULL)
+        return -1;
+
+    unsigned char buffer[65536];
+    unsigned long long hash = FNV_OFFSET;
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        hash = hash_bytes(hash, buffer, n);
 
-    // Execute the command
-    int result = system(command);
+    fclose(file);
+    *hashOut = hash;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the cached information about a file, calling stat() on the first request only.
+ *
+ * @param BuildState *stateIn   - The build state holding the cache.
+ * @param const char *pathIn    - The file.
+ * @return FileInfo*            - The cached information, valid until the next lookup of a new file.
+ * -------------------------------------------------------------------------------------------------------- */
+FileInfo *file_info(BuildState *stateIn, const char *pathIn) {
 
-    free(libs);
-    free(command);
+    if (stateIn->fileCount * 2 >= stateIn->fileSize) {
+        int size = stateIn->fileSize ? stateIn->fileSize * 2 : 256;
+        FileInfo *files = calloc(size, sizeof(FileInfo));
+        if (files == NULL) {
+            perror("calloc failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < stateIn->fileSize; i++) {
+            if (stateIn->files[i].path == NULL)
+                continue;
+            unsigned long long slot = hash_string(FNV_OFFSET, stateIn->files[i].path) & (size - 1);
+            while (files[slot].path != NULL)
+                slot = (slot + 1) & (size - 1);
+            files[slot] = stateIn->files[i];
+        }
+        free(stateIn->files);
+        stateIn->files = files;
+        stateIn->fileSize = size;
+    }
 
-    if (result != 0) {
-        fprintf(stderr, "Command failed: %s\n", command);
-        exit(EXIT_FAILURE);
+    unsigned long long slot = hash_string(FNV_OFFSET, pathIn) & (stateIn->fileSize - 1);
+    while (stateIn->files[slot].path != NULL) {
+        if (strcmp(stateIn->files[slot].path, pathIn) == 0)
+            return &stateIn->files[slot];
+        slot = (slot + 1) & (stateIn->fileSize - 1);
     }
+
+    FileInfo *info = &stateIn->files[slot];
+    append_format(&info->path, "%s", pathIn);
+    info->exists = (stamp_file(pathIn, &info->stamp) == 0);
+    stateIn->fileCount++;
+    return info;
 }
 
-// ---------------------------------------------------------------------------------------------------
-// Our main function serves as the command center of your network diagnostics tool, orchestrating the
-// seamless execution of all key operations. It handles user input, dynamically configures the scanning
-// range, initiates progress tracking, and processes the results with utmost efficiency. Designed for
-// top-down clarity, this function ensures that every step, from initialization to output, is executed
-// with precision.
-//
-// By leveraging the main function, developers can effortlessly manage complex network diagnostics tasks,
-// ensuring a streamlined and intuitive user experience. It integrates all components harmoniously,
-// reflecting the highest standards of coding excellence.
-//
-// @param argc  The number of command-line arguments.
-// @param argv  The array of command-line arguments.
-// @return      0 on successful completion, 1 on error.
-// ----------------------------------------------------------------------------------------------------
-int main (int argc, char **argv) {
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the content hash of a cached file, reading the file on the first request only.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long file_hash(FileInfo *infoIn) {
+    if (!infoIn->hashed) {
+        if (hash_file(infoIn->path, &infoIn->hash) != 0)
+            infoIn->hash = 0;
+        infoIn->hashed = 1;
+    }
+    return infoIn->hash;
+}
 
-    // Check if the help is triggered.
-    if(isHelpTriggered(argc, argv[1])) {
-        print_help();
-        return 1;
+/* --------------------------------------------------------------------------------------------------------
+ * Forgets the cached information about a file, for example after a compile job rewrote it.
+ * -------------------------------------------------------------------------------------------------------- */
+void forget_file(BuildState *stateIn, const char *pathIn) {
+    FileInfo *info = file_info(stateIn, pathIn);
+    info->exists = (stamp_file(pathIn, &info->stamp) == 0);
+    info->hashed = 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Stats every file of the file cache again. Only files whose stamp changed lose their content hash, so a
+ * build server pays one stat() per file and rebuild instead of parsing and hashing everything anew. The
+ * directories of glob patterns are checked the same way.
+ *
+ * @param BuildState *stateIn   - The build state, the current directory is the one of its makefile.
+ * @return int                  - The number of files that changed.
+ * -------------------------------------------------------------------------------------------------------- */
+int refresh_files(BuildState *stateIn) {
+    int changed = 0;
+    for (int i = 0; i < stateIn->fileSize; i++) {
+        FileInfo *info = &stateIn->files[i];
+        if (info->path == NULL)
+            continue;
+
+        FileStamp stamp = {0};
+        int exists = (stamp_file(info->path, &stamp) == 0);
+        if (exists != info->exists || stamp.mtime != info->stamp.mtime || stamp.size != info->stamp.size) {
+            info->exists = exists;
+            info->stamp = stamp;
+            info->hashed = 0;
+            changed++;
+        }
     }
 
-    process_makefile(argv[1]);
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    // A directory a glob pattern walked changes when an entry was created, deleted or renamed in it.
+    for (int i = 0; i < stateIn->dirSize; i++) {
+        DirListing *listing = &stateIn->dirs[i];
+        if (listing->path == NULL || !listing->used)
+            continue;
+        FileStamp stamp = {0};
+        if (stamp_file(listing->path, &stamp) != 0 || stamp.mtime != listing->mtime)
+            changed++;
+    }
+    return changed;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds an entry to a directory listing. Directories get a trailing '/', an entry of unknown type is
+ * stat'ed to find out.
+ *
+ * @param char ***namesIn       - The entries so far.
+ * @param int *countIn          - The number of entries.
+ * @param const char *dirIn     - The directory, to stat entries of unknown type.
+ * @param const char *nameIn    - The name of the entry.
+ * @param int isDirIn           - 1 for a directory, 0 for anything else, -1 if unknown.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_entry(char ***namesIn, int *countIn, const char *dirIn, const char *nameIn, int isDirIn) {
+    if (nameIn[0] == '.')
+        return;
+
+    if (isDirIn < 0) {
+        char *path = NULL;
+        append_format(&path, "%s/%s", dirIn, nameIn);
+        struct stat st;
+        isDirIn = stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+        free(path);
+    }
+
+    if (*countIn == 0 || (*countIn >= 16 && (*countIn & (*countIn - 1)) == 0)) {
+        char **grown = realloc(*namesIn, sizeof(char *) * (*countIn ? *countIn * 2 : 16));
+        if (grown == NULL)
+            return;
+        *namesIn = grown;
+    }
+    (*namesIn)[*countIn] = NULL;
+    append_format(&(*namesIn)[(*countIn)++], "%s%s", nameIn, isDirIn ? "/" : "");
+}
+
+int compare_names(const void *aIn, const void *bIn) {
+    return strcmp(*(char *const *)aIn, *(char *const *)bIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads the entries of a directory, sorted and without hidden entries, so .pmake/ and .git/ are never
+ * walked. Linux reads the raw getdents64 records in large batches, they carry the type of every entry
+ * and no entry needs a stat() of its own. Elsewhere readdir() does the same job.
+ *
+ * @param const char *dirIn     - The directory.
+ * @param char ***namesOut      - Receives the entries, the caller frees every entry and the array.
+ * @param int *countOut         - Receives the number of entries.
+ * @return int                  - 0 on success, -1 if the directory can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int read_directory(const char *dirIn, char ***namesOut, int *countOut) {
+    *namesOut = NULL;
+    *countOut = 0;
+
+#ifdef __linux__
+    int fd = open(dirIn, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    // The layout of the records the kernel writes.
+    struct linux_dirent64 {
+        unsigned long long ino;
+        long long offset;
+        unsigned short length;
+        unsigned char type;
+        char name[];
+    };
+
+    long long buffer[4096];
+    long n;
+    while ((n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0) {
+        for (long offset = 0; offset < n; ) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)((char *)buffer + offset);
+            add_entry(namesOut, countOut, dirIn, entry->name,
+                      entry->type == DT_UNKNOWN || entry->type == DT_LNK ? -1 : entry->type == DT_DIR);
+            offset += entry->length;
+        }
+    }
+    close(fd);
+    if (n < 0)
+        return -1;
+#else
+    DIR *dir = opendir(dirIn);
+    if (dir == NULL)
+        return -1;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        #ifdef DT_DIR
+            // Unix version
+            add_entry(namesOut, countOut, dirIn, entry->d_name,
+                      entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK ? -1 : entry->d_type == DT_DIR);
+        #else
+            // Windows version
+            add_entry(namesOut, countOut, dirIn, entry->d_name, -1);
+        #endif
+    }
+    closedir(dir);
+#endif
+
+    qsort(*namesOut, *countOut, sizeof(char *), compare_names);
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the cached listing of a directory, or adds an empty one that is read on first use.
+ *
+ * @param BuildState *stateIn   - The build state with the listings.
+ * @param const char *pathIn    - The directory.
+ * @return DirListing*          - The listing, valid until the next lookup of a new directory.
+ * -------------------------------------------------------------------------------------------------------- */
+DirListing *dir_listing(BuildState *stateIn, const char *pathIn) {
+
+    if (stateIn->dirCount * 2 >= stateIn->dirSize) {
+        int size = stateIn->dirSize ? stateIn->dirSize * 2 : 64;
+        DirListing *dirs = calloc(size, sizeof(DirListing));
+        if (dirs == NULL) {
+            perror("calloc failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < stateIn->dirSize; i++) {
+            if (stateIn->dirs[i].path == NULL)
+                continue;
+            unsigned long long slot = hash_string(FNV_OFFSET, stateIn->dirs[i].path) & (size - 1);
+            while (dirs[slot].path != NULL)
+                slot = (slot + 1) & (size - 1);
+            dirs[slot] = stateIn->dirs[i];
+        }
+        free(stateIn->dirs);
+        stateIn->dirs = dirs;
+        stateIn->dirSize = size;
+    }
+
+    unsigned long long slot = hash_string(FNV_OFFSET, pathIn) & (stateIn->dirSize - 1);
+    while (stateIn->dirs[slot].path != NULL) {
+        if (strcmp(stateIn->dirs[slot].path, pathIn) == 0)
+            return &stateIn->dirs[slot];
+        slot = (slot + 1) & (stateIn->dirSize - 1);
+    }
+
+    DirListing *listing = &stateIn->dirs[slot];
+    append_format(&listing->path, "%s", pathIn);
+    listing->mtime = -1;
+    stateIn->dirCount++;
+    return listing;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads a G line of the state file back into its listing.
+ *
+ * @param BuildState *stateIn   - The build state.
+ * @param char *lineIn          - The line behind "G\t": directory, mtime and entries, tab separated.
+ * -------------------------------------------------------------------------------------------------------- */
+void load_listing(BuildState *stateIn, char *lineIn) {
+    char *mtime = strchr(lineIn, '\t');
+    if (mtime == NULL)
+        return;
+    *mtime++ = '\0';
+
+    DirListing *listing = dir_listing(stateIn, lineIn);
+    listing->mtime = strtoll(mtime, NULL, 10);
+    for (char *entry = strchr(mtime, '\t'); entry != NULL; ) {
+        *entry++ = '\0';
+        char *next = strchr(entry, '\t');
+        if (next != NULL)
+            *next = '\0';
+        size_t length = strlen(entry);
+        int isDir = length > 0 && entry[length - 1] == '/';
+        if (isDir)
+            entry[length - 1] = '\0';
+        add_entry(&listing->names, &listing->count, listing->path, entry, isDir);
+        entry = next;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the listing of a directory, from the build state as long as the modification time of the
+ * directory is the recorded one, because creating, deleting or renaming an entry changes it. Otherwise
+ * the directory is read again. A directory modified in the last two seconds is read but not trusted
+ * next time, a file created in the same clock tick wouldn't change the time again.
+ *
+ * @param BuildState *stateIn   - The build state with the listings.
+ * @param const char *dirIn     - The directory, "" for the directory of the makefile, otherwise with '/'.
+ * @return DirListing*          - The listing, valid until the next lookup of a new directory. NULL if the
+ *                                directory can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+DirListing *list_directory(BuildState *stateIn, const char *dirIn) {
+    const char *path = dirIn[0] != '\0' ? dirIn : ".";
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode))
+        return NULL;
+    long long mtime = _mtime_ns(st);
+
+    DirListing *listing = dir_listing(stateIn, path);
+    listing->used = 1;
+    if (listing->mtime == mtime)
+        return listing;
+
+    for (int i = 0; i < listing->count; i++)
+        free(listing->names[i]);
+    free(listing->names);
+    if (read_directory(path, &listing->names, &listing->count) != 0)
+        return NULL;
+    listing->mtime = (long long)time(NULL) * 1000000000LL - mtime < 2000000000LL ? -1 : mtime;
+    return listing;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Matches a path against a glob pattern. * and ? never match a '/', [a-z] and [!a-z] match one character
+ * of a set, and ** also crosses directories: **.c matches a.c as well as x/y/a.c. Followed by a '/',
+ * ** stands for any number of whole directories, also none.
+ *
+ * @param const char *patternIn - The pattern.
+ * @param const char *pathIn    - The path.
+ * @return int                  - 1 if the path matches.
+ * -------------------------------------------------------------------------------------------------------- */
+int glob_match(const char *patternIn, const char *pathIn) {
+    while (*patternIn != '\0') {
+        if (patternIn[0] == '*' && patternIn[1] == '*') {
+            const char *rest = patternIn + 2;
+            while (*rest == '*')
+                rest++;
+            if (*rest == '\0')
+                return 1;
+            if (*rest == '/') {
+                for (const char *p = pathIn; p != NULL; p = strchr(p, '/') ? strchr(p, '/') + 1 : NULL)
+                    if (glob_match(rest + 1, p))
+                        return 1;
+            } else {
+                for (const char *p = pathIn; *p != '\0'; p++)
+                    if (glob_match(rest, p))
+                        return 1;
+            }
+            return 0;
+        }
+
+        if (*patternIn == '*') {
+            while (*patternIn == '*')
+                patternIn++;
+            for (const char *p = pathIn; ; p++) {
+                if (glob_match(patternIn, p))
+                    return 1;
+                if (*p == '\0' || *p == '/')
+                    return 0;
+            }
+        }
+
+        if (*pathIn == '\0')
+            return 0;
+
+        if (*patternIn == '?' && *pathIn != '/') {
+            patternIn++;
+            pathIn++;
+            continue;
+        }
+
+        const char *close = *patternIn == '[' ? strchr(patternIn + 2, ']') : NULL;
+        if (close != NULL && *pathIn != '/') {
+            const char *set = patternIn + 1;
+            int negate = (*set == '!' || *set == '^');
+            if (negate)
+                set++;
+            int found = 0;
+            for (const char *c = set; c < close; c++) {
+                if (c + 2 < close && c[1] == '-') {
+                    found |= (unsigned char)*pathIn >= (unsigned char)c[0] && (unsigned char)*pathIn <= (unsigned char)c[2];
+                    c += 2;
+                } else {
+                    found |= *pathIn == *c;
+                }
+            }
+            if (found == negate)
+                return 0;
+            patternIn = close + 1;
+            pathIn++;
+            continue;
+        }
+
+        if (*patternIn != *pathIn)
+            return 0;
+        patternIn++;
+        pathIn++;
+    }
+    return *pathIn == '\0';
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Collects the files below a directory that match a pattern. Only the directories the pattern can reach
+ * are listed: *.c lists a single directory, **.c the whole tree below it.
+ *
+ * @param BuildState *stateIn   - The build state with the listings.
+ * @param const char *dirIn     - The directory, "" or ending in '/'.
+ * @param const char *patternIn - The whole pattern, matched against the path of every file.
+ * @param int depthIn           - How many directories further down the pattern reaches, -1 for any.
+ * @param char ***matchesIn     - The matches, new ones are appended.
+ * @param int *countIn          - The number of matches.
+ * -------------------------------------------------------------------------------------------------------- */
+void walk_directory(BuildState *stateIn, const char *dirIn, const char *patternIn, int depthIn,
+                    char ***matchesIn, int *countIn) {
+    DirListing *listing = list_directory(stateIn, dirIn);
+    if (listing == NULL)
+        return;
+
+    // The listing moves when the recursion adds directories, the subdirectories are collected first.
+    char **subdirs = NULL;
+    int subdirCount = 0;
+    for (int i = 0; i < listing->count; i++) {
+        const char *name = listing->names[i];
+        if (name[strlen(name) - 1] == '/') {
+            if (depthIn != 0) {
+                subdirs = realloc(subdirs, sizeof(char *) * (subdirCount + 1));
+                subdirs[subdirCount] = NULL;
+                append_format(&subdirs[subdirCount++], "%s%s", dirIn, name);
+            }
+            continue;
+        }
+
+        char *path = NULL;
+        append_format(&path, "%s%s", dirIn, name);
+        if (!glob_match(patternIn, path)) {
+            free(path);
+            continue;
+        }
+        *matchesIn = realloc(*matchesIn, sizeof(char *) * (*countIn + 1));
+        (*matchesIn)[(*countIn)++] = path;
+    }
+
+    for (int i = 0; i < subdirCount; i++) {
+        walk_directory(stateIn, subdirs[i], patternIn, depthIn - 1, matchesIn, countIn);
+        free(subdirs[i]);
+    }
+    free(subdirs);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Expands the words of src= and libs=. A glob pattern like **.c is replaced by the files it matches in
+ * sorted order, a directory like md4c/ by every translation unit below it. Words starting with '!' are
+ * exclude patterns, !*_test.c drops the tests in every directory from what the patterns and directories
+ * matched, a pattern with a '/' has to match the whole path. Flags like -l* are left alone, a pattern
+ * matching nothing is reported.
+ *
+ * @param BuildState *stateIn   - The build state with the cached listings.
+ * @param char *wordsIn         - The words, released by this function.
+ * @param const char *projectIn - The project, for the message.
+ * @return char*                - The expanded words, the caller frees them.
+ * -------------------------------------------------------------------------------------------------------- */
+char *expand_globs(BuildState *stateIn, char *wordsIn, const char *projectIn) {
+    if (wordsIn == NULL || strpbrk(wordsIn, "*?[!/") == NULL)
+        return wordsIn;
+
+    int count = 0;
+    char **list = split_words(wordsIn, &count);
+    char *expanded = NULL;
+    append_format(&expanded, "%s", "");
+
+    for (int i = 0; i < count; i++) {
+        const char *word = list[i];
+        size_t length = strlen(word);
+        int isDirectory = word[0] != '-' && word[length - 1] == '/';
+        if (word[0] == '!' || (!isDirectory && (word[0] == '-' || strpbrk(word, "*?[") == NULL))) {
+            if (word[0] != '!')
+                append_format(&expanded, "%s ", word);
+            continue;
+        }
+
+        // Everything up to the last '/' in front of the first wildcard is listed as it is.
+        char *pattern = NULL;
+        append_format(&pattern, "%s%s", word, isDirectory ? "**" : "");
+        const char *wildcard = strpbrk(pattern, "*?[");
+        const char *base = wildcard;
+        while (base > pattern && base[-1] != '/')
+            base--;
+        int depth = 0;
+        if (strstr(base, "**") != NULL)
+            depth = -1;
+        else
+            for (const char *c = base; *c != '\0'; c++)
+                depth += *c == '/';
+
+        char *dir = NULL;
+        append_format(&dir, "%.*s", (int)(base - pattern), pattern);
+        char **matches = NULL;
+        int matchCount = 0;
+        walk_directory(stateIn, dir, pattern, depth, &matches, &matchCount);
+        qsort(matches, matchCount, sizeof(char *), compare_names);
+
+        int kept = 0;
+        for (int m = 0; m < matchCount; m++) {
+            int excluded = isDirectory && !is_source_file(matches[m]);
+            for (int e = 0; e < count && !excluded; e++) {
+                if (list[e][0] != '!')
+                    continue;
+                // Like in .gitignore, a pattern without '/' is matched against the file name alone.
+                const char *name = strrchr(matches[m], '/');
+                excluded = glob_match(list[e] + 1, strchr(list[e], '/') || name == NULL ? matches[m] : name + 1);
+            }
+            if (!excluded) {
+                append_format(&expanded, "%s ", matches[m]);
+                kept++;
+            }
+            free(matches[m]);
+        }
+        if (kept == 0)
+            fprintf(stderr, "pmake: '%s': nothing matches '%s'.\n", projectIn, word);
+
+        free(matches);
+        free(dir);
+        free(pattern);
+    }
+
+    free(list);
+    free(wordsIn);
+    return expanded;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Parses a make style depfile as written by gcc/clang with -MMD:
+ *   object.o: source.c header1.h \
+ *    header2.h
+ * Backslash-newline continues the line and "\ " is an escaped blank inside a path. The target in front
+ * of the colon and the translation unit itself are skipped, the rest are the headers, sorted and every
+ * header once.
+ *
+ * @param const char *pathIn    - The depfile.
+ * @param const char *sourceIn  - The translation unit, which is not a header.
+ * @param int *countOut         - Receives the number of headers.
+ * @return char**               - The headers, the caller frees every entry and the array. NULL if the
+ *                                depfile can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+char **parse_depfile(const char *pathIn, const char *sourceIn, int *countOut) {
+    FILE *file = fopen(pathIn, "r");
+    *countOut = 0;
+    if (file == NULL)
+        return NULL;
+
+    char **paths = NULL;
+    int capacity = 0;
+    char *word = NULL;
+    size_t length = 0, wordSize = 0;
+    int afterColon = 0;
+    int c;
+
+    do {
+        c = fgetc(file);
+
+        if (c == '\\') {
+            int next = fgetc(file);
+            if (next == '\n' || next == '\r') {
+                if (next == '\r') fgetc(file);
+                c = ' ';
+            } else if (next == ' ' || next == '#' || next == '\\') {
+                c = next;
+                goto add;
+            } else {
+                ungetc(next, file);
+                goto add;
+            }
+        }
+
+        if (c == EOF || c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (length == 0)
+                continue;
+            word[length] = '\0';
+            length = 0;
+
+            if (!afterColon) {
+                // The target ends with a colon, possibly as a separate word.
+                if (word[strlen(word) - 1] == ':')
+                    afterColon = 1;
+                continue;
+            }
+            if (strcmp(word, ":") == 0 || strcmp(word, sourceIn) == 0)
+                continue;
+
+            if (*countOut == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                paths = realloc(paths, sizeof(char *) * capacity);
+            }
+            paths[*countOut] = NULL;
+            append_format(&paths[(*countOut)++], "%s", word);
+            continue;
+        }
+
+    add:
+        if (length + 2 >= wordSize) {
+            wordSize = wordSize ? wordSize * 2 : 256;
+            word = realloc(word, wordSize);
+        }
+        word[length++] = (char)c;
+    } while (c != EOF);
+
+    free(word);
+    fclose(file);
+
+    // A header included from several places is listed more than once, keep it once.
+    if (*countOut > 1) {
+        int unique = 1;
+        qsort(paths, *countOut, sizeof(char *), compare_names);
+        for (int i = 1; i < *countOut; i++) {
+            if (strcmp(paths[i], paths[unique - 1]) == 0)
+                free(paths[i]);
+            else
+                paths[unique++] = paths[i];
+        }
+        *countOut = unique;
+    }
+    return paths;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Replaces the header list of a record with the headers from the depfile of its object and stamps every
+ * header as it is on disk now. The depfile is deleted afterwards, from now on the state is the only
+ * record of the header graph.
+ *
+ * @param BuildState *stateIn   - The build state.
+ * @param int recordIn          - The record of the object.
+ * @param const char *depfileIn - The depfile written by the compiler.
+ * -------------------------------------------------------------------------------------------------------- */
+void store_dependencies(BuildState *stateIn, int recordIn, const char *depfileIn) {
+    StateRecord *record = &stateIn->records[recordIn];
+    int count = 0;
+    char **headers = parse_depfile(depfileIn, record->source, &count);
+
+    for (int i = 0; i < record->depCount; i++)
+        free(record->deps[i].path);
+    free(record->deps);
+    record->deps = count ? malloc(sizeof(Dependency) * count) : NULL;
+    record->depCount = count;
+
+    for (int i = 0; i < count; i++) {
+        forget_file(stateIn, headers[i]);
+        FileInfo *info = file_info(stateIn, headers[i]);
+        record->deps[i].path = headers[i];
+        record->deps[i].stamp = info->stamp;
+        record->deps[i].hash = file_hash(info);
+    }
+
+    free(headers);
+    remove(depfileIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the record of a key.
+ *
+ * @param BuildState *stateIn   - The build state.
+ * @param const char *keyIn     - The object or output file.
+ * @return int                  - The position of the record, or -1 if there is none.
+ * -------------------------------------------------------------------------------------------------------- */
+int find_record(BuildState *stateIn, const char *keyIn) {
+    if (stateIn->indexSize == 0)
+        return -1;
+
+    unsigned long long slot = hash_string(FNV_OFFSET, keyIn) & (stateIn->indexSize - 1);
+    while (stateIn->index[slot] >= 0) {
+        if (strcmp(stateIn->records[stateIn->index[slot]].key, keyIn) == 0)
+            return stateIn->index[slot];
+        slot = (slot + 1) & (stateIn->indexSize - 1);
+    }
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Rebuilds the hash index with room for at least twice the number of records.
+ * -------------------------------------------------------------------------------------------------------- */
+void reindex_state(BuildState *stateIn) {
+    int size = 64;
+    while (size < stateIn->capacity * 2)
+        size *= 2;
+
+    free(stateIn->index);
+    stateIn->index = malloc(sizeof(int) * size);
+    stateIn->indexSize = size;
+    memset(stateIn->index, -1, sizeof(int) * size);
+
+    for (int i = 0; i < stateIn->count; i++) {
+        unsigned long long slot = hash_string(FNV_OFFSET, stateIn->records[i].key) & (size - 1);
+        while (stateIn->index[slot] >= 0)
+            slot = (slot + 1) & (size - 1);
+        stateIn->index[slot] = i;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the record of a key, creating an empty one if it doesn't exist yet. The state takes a copy of
+ * the key.
+ *
+ * @param BuildState *stateIn   - The build state.
+ * @param char typeIn           - 'O' or 'L'.
+ * @param const char *keyIn     - The object or output file.
+ * @return int                  - The position of the record.
+ * -------------------------------------------------------------------------------------------------------- */
+int get_record(BuildState *stateIn, char typeIn, const char *keyIn) {
+    int found = find_record(stateIn, keyIn);
+    if (found >= 0)
+        return found;
+
+    if (stateIn->count == stateIn->capacity) {
+        int capacity = stateIn->capacity ? stateIn->capacity * 2 : 64;
+        StateRecord *records = realloc(stateIn->records, sizeof(StateRecord) * capacity);
+        if (records == NULL) {
+            perror("realloc failed");
+            exit(EXIT_FAILURE);
+        }
+        stateIn->records = records;
+        stateIn->capacity = capacity;
+    }
+
+    StateRecord *record = &stateIn->records[stateIn->count];
+    memset(record, 0, sizeof(StateRecord));
+    record->type = typeIn;
+    append_format(&record->key, "%s", keyIn);
+    append_format(&record->source, "");
+    append_format(&record->command, "");
+    stateIn->count++;
+
+    if (stateIn->count * 2 > stateIn->indexSize)
+        reindex_state(stateIn);
+    else {
+        unsigned long long slot = hash_string(FNV_OFFSET, keyIn) & (stateIn->indexSize - 1);
+        while (stateIn->index[slot] >= 0)
+            slot = (slot + 1) & (stateIn->indexSize - 1);
+        stateIn->index[slot] = stateIn->count - 1;
+    }
+
+    return stateIn->count - 1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Replaces a string owned by a record.
+ * -------------------------------------------------------------------------------------------------------- */
+void set_record_string(char **fieldIn, const char *valueIn) {
+    free(*fieldIn);
+    *fieldIn = NULL;
+    append_format(fieldIn, "%s", valueIn);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The state file lives in .pmake/ next to the makefile and is named after it, so several makefiles in
+ * the same directory keep separate states.
+ *
+ * @param const char *makefileIn - The path of the makefile.
+ * @return char*                 - The path of the state file, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *state_path(const char *makefileIn) {
+    char *path = NULL;
+    const char *slash = strrchr(makefileIn, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(makefileIn, '\\');
+    if (backslash > slash) slash = backslash;
+#endif
+
+    if (slash != NULL)
+        append_format(&path, "%.*s/.pmake/%s.state", (int)(slash - makefileIn), makefileIn, slash + 1);
+    else
+        append_format(&path, ".pmake/%s.state", makefileIn);
+    return path;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Loads the state file. Every line is one tab separated record:
+ *   O <object> <source> <mtime> <size> <hash> <command>
+ *   L <output> -        <mtime> <size> <hash> <command>
+ *   D <object> <header> <mtime> <size> <hash>
+ *   G <directory> <mtime> <entry> <entry> ...
+ * The D lines follow the O line of their object and list the headers it depends on. A G line is the
+ * listing of a directory a glob pattern walked. A missing or unreadable file simply gives an empty
+ * state, which means everything gets built.
+ *
+ * @param const char *pathIn    - The state file.
+ * @param BuildState *stateOut  - The state to fill.
+ * -------------------------------------------------------------------------------------------------------- */
+void load_state(const char *pathIn, BuildState *stateOut) {
+    memset(stateOut, 0, sizeof(BuildState));
+    reindex_state(stateOut);
+
+    FILE *file = fopen(pathIn, "r");
+    if (file == NULL)
+        return;
+
+    char *line = NULL;
+    size_t lineSize = 0;
+    int c;
+
+    for (;;) {
+        // Read one complete line, command lines have no length limit.
+        size_t length = 0;
+        while ((c = fgetc(file)) != EOF && c != '\n') {
+            if (length + 1 >= lineSize) {
+                lineSize = lineSize ? lineSize * 2 : 1024;
+                line = realloc(line, lineSize);
+            }
+            line[length++] = (char)c;
+        }
+        if (length == 0 && c == EOF)
+            break;
+        if (line == NULL || length == 0)
+            continue;
+        line[length] = '\0';
+
+        if (line[0] == 'G' && line[1] == '\t') {
+            load_listing(stateOut, line + 2);
+            continue;
+        }
+
+        char *fields[7];
+        int n = 0;
+        char *cursor = line;
+        while (n < 6) {
+            fields[n++] = cursor;
+            cursor = strchr(cursor, '\t');
+            if (cursor == NULL) break;
+            *cursor++ = '\0';
+        }
+
+        if (line[0] == 'D' && n == 6) {
+            int r = find_record(stateOut, fields[1]);
+            if (r < 0)
+                continue;
+            StateRecord *record = &stateOut->records[r];
+            Dependency *deps = realloc(record->deps, sizeof(Dependency) * (record->depCount + 1));
+            if (deps == NULL)
+                continue;
+            Dependency *dep = &deps[record->depCount++];
+            dep->path = NULL;
+            append_format(&dep->path, "%s", fields[2]);
+            dep->stamp.mtime = strtoll(fields[3], NULL, 10);
+            dep->stamp.size = strtoll(fields[4], NULL, 10);
+            dep->hash = strtoull(fields[5], NULL, 16);
+            record->deps = deps;
+            continue;
+        }
+
+        if (n < 6 || cursor == NULL || (line[0] != 'O' && line[0] != 'L'))
+            continue;
+        fields[6] = cursor;
+
+        int r = get_record(stateOut, line[0], fields[1]);
+        StateRecord *record = &stateOut->records[r];
+        set_record_string(&record->source, strcmp(fields[2], "-") == 0 ? "" : fields[2]);
+        record->stamp.mtime = strtoll(fields[3], NULL, 10);
+        record->stamp.size = strtoll(fields[4], NULL, 10);
+        record->hash = strtoull(fields[5], NULL, 16);
+        set_record_string(&record->command, fields[6]);
+        record->valid = 1;
+    }
+
+    free(line);
+    fclose(file);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes all valid records back to the state file. The file is written under a temporary name and then
+ * renamed, so an interrupted pmake never leaves a half written state behind.
+ *
+ * @param const char *pathIn    - The state file.
+ * @param BuildState *stateIn   - The state to save.
+ * -------------------------------------------------------------------------------------------------------- */
+void save_state(const char *pathIn, BuildState *stateIn) {
+    char *temp = NULL;
+    append_format(&temp, "%s.tmp", pathIn);
+
+    FILE *file = fopen(temp, "w");
+    if (file == NULL) {
+        perror("fopen");
+        free(temp);
+        return;
+    }
+
+    for (int i = 0; i < stateIn->count; i++) {
+        StateRecord *record = &stateIn->records[i];
+        if (!record->valid)
+            continue;
+        fprintf(file, "%c\t%s\t%s\t%lld\t%lld\t%016llx\t%s\n", record->type, record->key,
+                record->source[0] ? record->source : "-", record->stamp.mtime, record->stamp.size,
+                record->hash, record->command);
+        for (int d = 0; d < record->depCount; d++)
+            fprintf(file, "D\t%s\t%s\t%lld\t%lld\t%016llx\n", record->key, record->deps[d].path,
+                    record->deps[d].stamp.mtime, record->deps[d].stamp.size, record->deps[d].hash);
+    }
+
+    for (int i = 0; i < stateIn->dirSize; i++) {
+        DirListing *listing = &stateIn->dirs[i];
+        if (listing->path == NULL || !listing->used || listing->mtime < 0)
+            continue;
+        fprintf(file, "G\t%s\t%lld", listing->path, listing->mtime);
+        for (int n = 0; n < listing->count; n++)
+            fprintf(file, "\t%s", listing->names[n]);
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    remove(pathIn);
+    rename(temp, pathIn);
+    free(temp);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Releases all memory of the build state.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_state(BuildState *stateIn) {
+    for (int i = 0; i < stateIn->count; i++) {
+        free(stateIn->records[i].key);
+        free(stateIn->records[i].source);
+        free(stateIn->records[i].command);
+        for (int d = 0; d < stateIn->records[i].depCount; d++)
+            free(stateIn->records[i].deps[d].path);
+        free(stateIn->records[i].deps);
+    }
+    for (int i = 0; i < stateIn->fileSize; i++)
+        free(stateIn->files[i].path);
+    free(stateIn->files);
+    for (int i = 0; i < stateIn->dirSize; i++) {
+        for (int n = 0; n < stateIn->dirs[i].count; n++)
+            free(stateIn->dirs[i].names[n]);
+        free(stateIn->dirs[i].names);
+        free(stateIn->dirs[i].path);
+    }
+    free(stateIn->dirs);
+    free(stateIn->records);
+    free(stateIn->index);
+    memset(stateIn, 0, sizeof(BuildState));
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Checks whether a file still matches a recorded stamp and hash. An equal stamp is trusted without reading
+ * the file. If only the stamp changed (a touch, a checkout) the content hash decides, and an unchanged
+ * hash refreshes the recorded stamp so the file isn't hashed again next time.
+ *
+ * @param BuildState *stateIn           - The build state with the file cache.
+ * @param const char *pathIn            - The file.
+ * @param FileStamp *stampIn            - The recorded stamp, refreshed if only the stamp changed.
+ * @param unsigned long long hashIn     - The recorded content hash.
+ * @return int                          - 1 if the file is unchanged, 0 if it changed or is gone.
+ * -------------------------------------------------------------------------------------------------------- */
+int is_unchanged(BuildState *stateIn, const char *pathIn, FileStamp *stampIn, unsigned long long hashIn) {
+    FileInfo *info = file_info(stateIn, pathIn);
+
+    if (!info->exists)
+        return 0;
+    if (info->stamp.mtime == stampIn->mtime && info->stamp.size == stampIn->size)
+        return 1;
+    if (info->stamp.size != stampIn->size || file_hash(info) != hashIn)
+        return 0;
+
+    *stampIn = info->stamp;
+    return 1;
+}
+
+// Why a translation unit has to be compiled.
+#define STALE_NONE    0  // The object is up to date.
+#define STALE_NEW     1  // The object was never built, or its last compile failed.
+#define STALE_OUTPUT  2  // The object file is gone.
+#define STALE_COMMAND 3  // The compile command changed.
+#define STALE_SOURCE  4  // The translation unit changed.
+#define STALE_HEADER  5  // A header it included changed.
+#define STALE_PCH     6  // The precompiled header it is compiled with is built again.
+
+/* --------------------------------------------------------------------------------------------------------
+ * Decides whether a translation unit has to be compiled. The object is up to date if it exists, was built
+ * with exactly the same command, and neither the source nor any header it included the last time changed.
+ * Otherwise the record is prepared with the new source stamp and hash and marked invalid until the compile
+ * job succeeded, its header list is replaced from the depfile of that compile.
+ *
+ * @param BuildState *stateIn   - The build state.
+ * @param const char *objectIn  - The object file.
+ * @param const char *sourceIn  - The translation unit.
+ * @param const char *commandIn - The compile command.
+ * @param int *recordOut        - Receives the record of the object.
+ * @param const char **headerOut - Receives the changed header for STALE_HEADER, may be NULL.
+ * @return int                  - One of the STALE_* reasons, STALE_NONE if the object is up to date.
+ * -------------------------------------------------------------------------------------------------------- */
+int needs_compile(BuildState *stateIn, const char *objectIn, const char *sourceIn,
+                  const char *commandIn, int *recordOut, const char **headerOut) {
+
+    int r = get_record(stateIn, 'O', objectIn);
+    StateRecord *record = &stateIn->records[r];
+    *recordOut = r;
+
+    int stale = STALE_NONE;
+    if (!record->valid)
+        stale = STALE_NEW;
+    else if (!file_info(stateIn, objectIn)->exists)
+        stale = STALE_OUTPUT;
+    else if (strcmp(record->command, commandIn) != 0 || strcmp(record->source, sourceIn) != 0)
+        stale = STALE_COMMAND;
+    else if (!is_unchanged(stateIn, sourceIn, &record->stamp, record->hash))
+        stale = STALE_SOURCE;
+
+    for (int i = 0; stale == STALE_NONE && i < record->depCount; i++) {
+        if (!is_unchanged(stateIn, record->deps[i].path, &record->deps[i].stamp, record->deps[i].hash)) {
+            stale = STALE_HEADER;
+            if (headerOut != NULL)
+                *headerOut = record->deps[i].path;
+        }
+    }
+
+    if (stale == STALE_NONE)
+        return STALE_NONE;
+
+    FileInfo *source = file_info(stateIn, sourceIn);
+    set_record_string(&record->source, sourceIn);
+    set_record_string(&record->command, commandIn);
+    record->stamp = source->stamp;
+    record->hash = file_hash(source);
+    record->valid = 0;
+    return stale;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Computes a fingerprint over the stamps of all link inputs that are files. Options like -L or -l are
+ * part of the link command and don't need a stamp.
+ *
+ * @param char **inputsIn       - The link inputs.
+ * @param int countIn           - Number of link inputs.
+ * @return unsigned long long   - The fingerprint.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long fingerprint_inputs(char **inputsIn, int countIn) {
+    unsigned long long hash = FNV_OFFSET;
+    for (int i = 0; i < countIn; i++) {
+        FileStamp stamp = {0, 0};
+        if (inputsIn[i][0] == '-')
+            continue;
+        stamp_file(inputsIn[i], &stamp);
+        hash = hash_string(hash, inputsIn[i]);
+        hash = hash_bytes(hash, &stamp, sizeof(stamp));
+    }
+    return hash;
+}
+
+/* ****************************************END BUILD STATE************************************************* */
+
+/* ***************************************START COMPILATION CACHE****************************************** */
+
+/* --------------------------------------------------------------------------------------------------------
+ * The CompilationCache is a content addressed store of object files shared by all projects of a user. The
+ * key of an object is a hash over the preprocessed translation unit, the identity of the compiler and the
+ * compile flags, so cManPage.c compiled by cp, ls and chkip with the same flags is compiled only once. The
+ * cache lives in ~/.local/share/pmake/cache (or $PMAKE_CACHE_DIR) and objects are hardlinked out of it,
+ * falling back to a copy where hardlinks are not possible.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *directory;            // The cache directory.
+    long long hits;             // Objects taken from the cache during this run.
+    long long misses;           // Objects compiled and stored during this run.
+    long long bytesSaved;       // Size of all objects taken from the cache during this run.
+} CompilationCache;
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the cache directory, $PMAKE_CACHE_DIR if set, otherwise pmake/cache below the data directory
+ * that also keeps the man pages.
+ *
+ * @return char* - The cache directory, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *cache_directory(void) {
+    char *directory = NULL;
+    if (getenv("PMAKE_CACHE_DIR") != NULL)
+        append_format(&directory, "%s", getenv("PMAKE_CACHE_DIR"));
+    else
+        append_format(&directory, "%s%spmake/cache", _home(), PATH);
+    return directory;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Identifies the compiler. Running "gcc --version" for every build would cost a process, instead the
+ * compiler is looked up in PATH and its location, size and modification time are hashed. An updated
+ * compiler therefore never reuses objects of the old one.
+ *
+ * @param const char *compIn    - The compiler from the comp= directive.
+ * @return unsigned long long   - The identity hash.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long compiler_identity(const char *compIn) {
+    unsigned long long hash = hash_string(FNV_OFFSET, compIn);
+    FileStamp stamp;
+
+    if (strchr(compIn, '/') != NULL || strchr(compIn, '\\') != NULL) {
+        if (stamp_file(compIn, &stamp) == 0)
+            hash = hash_bytes(hash, &stamp, sizeof(stamp));
+        return hash;
+    }
+
+    char *path = NULL;
+    append_format(&path, "%s", getenv("PATH") ? getenv("PATH") : "");
+
+#ifdef _WIN32
+    const char *separators = ";";
+#else
+    const char *separators = ":";
+#endif
+
+    for (char *dir = strtok(path, separators); dir != NULL; dir = strtok(NULL, separators)) {
+        char *candidate = NULL;
+        append_format(&candidate, "%s/%s", dir, compIn);
+        int found = (stamp_file(candidate, &stamp) == 0);
+        if (found) {
+            hash = hash_string(hash, candidate);
+            hash = hash_bytes(hash, &stamp, sizeof(stamp));
+        }
+        free(candidate);
+        if (found)
+            break;
+    }
+
+    free(path);
+    return hash;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Checks whether a line of preprocessor output is a line marker, # 12 "file.c" as gcc and clang write
+ * them or #line 12 "file.c". Other lines starting with #, like #pragma, are not.
+ *
+ * @param const char *lineIn    - The start of the line.
+ * @param const char *endIn     - The end of the line.
+ * @return int                  - 1 for a line marker, 0 otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int is_line_marker(const char *lineIn, const char *endIn) {
+    const char *p = lineIn;
+    if (p == endIn || *p++ != '#')
+        return 0;
+    while (p < endIn && (*p == ' ' || *p == '\t'))
+        p++;
+    if (endIn - p > 4 && strncmp(p, "line", 4) == 0 && (p[4] == ' ' || p[4] == '\t')) {
+        p += 4;
+        while (p < endIn && (*p == ' ' || *p == '\t'))
+            p++;
+    }
+    if (p == endIn || !isdigit((unsigned char)*p))
+        return 0;
+    while (p < endIn && isdigit((unsigned char)*p))
+        p++;
+    return p == endIn || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Hashes a preprocessed translation unit. Line markers (# 12 "file.c") carry the path the unit was
+ * reached by, skipping them lets ../mylibs/ToolBox/cManPage.c and ToolBox/cManPage.c share one object.
+ * Everything else is hashed, #pragma lines included, they change the generated code. Units compiled with
+ * debug information, where the markers end up in the object, have their path in the salt instead.
+ *
+ * @param const char *pathIn            - The preprocessor output.
+ * @param unsigned long long hashIn     - The hash so far.
+ * @param unsigned long long *hashOut   - Receives the hash.
+ * @return int                          - 0 on success, -1 if the file can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int hash_preprocessed(const char *pathIn, unsigned long long hashIn, unsigned long long *hashOut) {
+    size_t size = 0;
+    const char *data = map_file(pathIn, &size);
+    if (data == NULL)
+        return -1;
+
+    const char *end = data + size;
+    for (const char *line = data; line < end; ) {
+        const char *next = memchr(line, '\n', (size_t)(end - line));
+        next = next != NULL ? next + 1 : end;
+        if (!is_line_marker(line, next))
+            hashIn = hash_bytes(hashIn, line, (size_t)(next - line));
+        line = next;
+    }
+
+    unmap_file(data, size);
+    *hashOut = hashIn;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the path of the sub directory a key's entries and manifest are in.
+ * -------------------------------------------------------------------------------------------------------- */
+char *cache_bucket(CompilationCache *cacheIn, unsigned long long keyIn) {
+    char *bucket = NULL;
+    append_format(&bucket, "%s/%02llx", cacheIn->directory, keyIn >> 56);
+    return bucket;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the path of a cache entry. Entries are spread over 256 sub directories by the first byte of the
+ * key, so no single directory gets huge.
+ * -------------------------------------------------------------------------------------------------------- */
+char *cache_entry(CompilationCache *cacheIn, unsigned long long keyIn) {
+    char *entry = NULL;
+    append_format(&entry, "%s/%02llx/%016llx.o", cacheIn->directory, keyIn >> 56, keyIn);
+    return entry;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the path of the compiler output kept with a cache entry, the warnings a hit prints again.
+ * -------------------------------------------------------------------------------------------------------- */
+char *cache_log(CompilationCache *cacheIn, unsigned long long keyIn) {
+    char *log = NULL;
+    append_format(&log, "%s/%02llx/%016llx.log", cacheIn->directory, keyIn >> 56, keyIn);
+    return log;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Copies a file, used wherever a hardlink isn't possible (Windows, different file systems).
+ *
+ * @return int - 0 on success, -1 on failure.
+ * -------------------------------------------------------------------------------------------------------- */
+int copy_file(const char *fromIn, const char *toIn) {
+    FILE *from = fopen(fromIn, "rb");
+    if (from == NULL)
+        return -1;
+    FILE *to = fopen(toIn, "wb");
+    if (to == NULL) {
+        fclose(from);
+        return -1;
+    }
+
+    char buffer[65536];
+    size_t n;
+    int result = 0;
+    while ((n = fread(buffer, 1, sizeof(buffer), from)) > 0)
+        if (fwrite(buffer, 1, n, to) != n)
+            result = -1;
+
+    fclose(from);
+    if (fclose(to) != 0)
+        result = -1;
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Places a file at a new path as a hardlink, or as a copy if linking fails. The new path is written under
+ * a temporary name and renamed, so a concurrent pmake never sees a half written file.
+ *
+ * @return int - 0 on success, -1 on failure.
+ * -------------------------------------------------------------------------------------------------------- */
+int link_or_copy(const char *fromIn, const char *toIn) {
+    char *temp = NULL;
+    append_format(&temp, "%s.%ld.tmp", toIn, (long)getpid());
+    remove(temp);
+
+    int result = _hardlink(fromIn, temp);
+    if (result != 0)
+        result = copy_file(fromIn, temp);
+    if (result == 0) {
+        remove(toIn);
+        result = rename(temp, toIn);
+    }
+    if (result != 0)
+        remove(temp);
+
+    free(temp);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Looks up the object of a preprocessed translation unit. On a hit the object is linked into place, the
+ * compile is skipped and the warnings the compiler printed for it are printed again. On a miss the key is
+ * kept in the job so the compiled object can be stored.
+ *
+ * @param CompilationCache *cacheIn     - The cache.
+ * @param const char *preprocessedIn    - The preprocessor output of the unit.
+ * @param unsigned long long saltIn     - Hash over the compiler identity and compile flags of the unit.
+ * @param const char *objectIn          - The object file of the unit.
+ * @param unsigned long long *keyOut    - Receives the cache key.
+ * @return int                          - 1 on a hit, 0 on a miss.
+ * -------------------------------------------------------------------------------------------------------- */
+int cache_fetch(CompilationCache *cacheIn, const char *preprocessedIn, unsigned long long saltIn,
+                const char *objectIn, unsigned long long *keyOut) {
+
+    unsigned long long key;
+    if (hash_preprocessed(preprocessedIn, saltIn, &key) != 0) {
+        *keyOut = 0;
+        return 0;
+    }
+    *keyOut = key;
+
+    char *entry = cache_entry(cacheIn, key);
+    FileStamp stamp;
+    int hit = (stamp_file(entry, &stamp) == 0 && link_or_copy(entry, objectIn) == 0);
+
+    if (hit) {
+        cacheIn->hits++;
+        cacheIn->bytesSaved += stamp.size;
+
+        char *log = cache_log(cacheIn, key);
+        size_t size = 0;
+        const char *text = map_file(log, &size);
+        if (text != NULL) {
+            fwrite(text, 1, size, stdout);
+            unmap_file(text, size);
+        }
+        free(log);
+    }
+
+    free(entry);
+    return hit;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Stores a freshly compiled object under its key, with what the compiler printed for it. The output is
+ * written first, a concurrent pmake that finds the object finds its warnings as well.
+ *
+ * @param CompilationCache *cacheIn - The cache.
+ * @param const char *objectIn      - The object file.
+ * @param unsigned long long keyIn  - The cache key, 0 if the unit couldn't be hashed.
+ * @param const char *logIn         - The output of the compiler, NULL for none.
+ * -------------------------------------------------------------------------------------------------------- */
+void cache_store(CompilationCache *cacheIn, const char *objectIn, unsigned long long keyIn, const char *logIn) {
+    cacheIn->misses++;
+    if (keyIn == 0)
+        return;
+
+    char *directory = cache_bucket(cacheIn, keyIn);
+    make_directories(directory);
+    free(directory);
+
+    char *entry = cache_entry(cacheIn, keyIn);
+
+    char *log = cache_log(cacheIn, keyIn);
+    if (logIn != NULL && logIn[0] != '\0')
+        write_if_changed(log, logIn);
+    else
+        remove(log);
+    free(log);
+
+    link_or_copy(objectIn, entry);
+    free(entry);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Appends the counters of this run to the stats file of the cache. Every run writes one short line with
+ * a single append, so concurrent pmakes don't overwrite each other's numbers.
+ * -------------------------------------------------------------------------------------------------------- */
+void cache_save_stats(CompilationCache *cacheIn) {
+    if (cacheIn->hits == 0 && cacheIn->misses == 0)
+        return;
+
+    make_directories(cacheIn->directory);
+
+    char *path = NULL;
+    append_format(&path, "%s/stats", cacheIn->directory);
+    FILE *file = fopen(path, "a");
+    if (file != NULL) {
+        fprintf(file, "%lld %lld %lld\n", cacheIn->hits, cacheIn->misses, cacheIn->bytesSaved);
+        fclose(file);
+    }
+    free(path);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Prints the statistics of the cache for pmake --cache-stats: hits, misses and bytes saved over all runs.
+ *
+ * @return int - EXIT_SUCCESS.
+ * -------------------------------------------------------------------------------------------------------- */
+int print_cache_stats(void) {
+    char *directory = cache_directory();
+    char *path = NULL;
+    append_format(&path, "%s/stats", directory);
+
+    long long hits = 0, misses = 0, bytesSaved = 0, h, m, b;
+    FILE *file = fopen(path, "r");
+    if (file != NULL) {
+        while (fscanf(file, "%lld %lld %lld", &h, &m, &b) == 3) {
+            hits += h;
+            misses += m;
+            bytesSaved += b;
+        }
+        fclose(file);
+    }
+
+    printf("Cache directory: %s\n", directory);
+    printf("Hits:            %lld\n", hits);
+    printf("Misses:          %lld\n", misses);
+    if (hits + misses > 0)
+        printf("Hit rate:        %.1f%%\n", 100.0 * hits / (hits + misses));
+    printf("Bytes saved:     %lld\n", bytesSaved);
+
+    free(path);
+    free(directory);
+    return EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * A manifest lets pmake tell a cache hit without running the preprocessor. Its key is computed from what
+ * is known before the compile: compiler and flags (the salt), the directory, the translation unit and its
+ * content. The manifest holds the cache key of the object that came out the last time together with all
+ * headers and their content hashes. If all headers still have these hashes, the preprocessor would
+ * produce the same output and the object is in the cache under that key.
+ *
+ * @param unsigned long long saltIn         - The cache salt of the compile job.
+ * @param const char *directoryIn           - The directory the compile runs in.
+ * @param const char *sourceIn              - The translation unit.
+ * @param unsigned long long sourceHashIn   - The content hash of the translation unit.
+ * @return unsigned long long               - The manifest key.
+ * -------------------------------------------------------------------------------------------------------- */
+unsigned long long manifest_key(unsigned long long saltIn, const char *directoryIn, const char *sourceIn,
+                                unsigned long long sourceHashIn) {
+    unsigned long long key = hash_string(saltIn, directoryIn);
+    key = hash_string(key, sourceIn);
+    return hash_bytes(key, &sourceHashIn, sizeof(sourceHashIn));
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the path of a manifest inside the cache, next to the objects.
+ * -------------------------------------------------------------------------------------------------------- */
+char *cache_manifest(CompilationCache *cacheIn, unsigned long long keyIn) {
+    char *path = NULL;
+    append_format(&path, "%s/%02llx/%016llx.manifest", cacheIn->directory, keyIn >> 56, keyIn);
+    return path;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes the manifest of a compile: the cache key of the object and the headers of the build state record.
+ *
+ * @param CompilationCache *cacheIn     - The cache.
+ * @param unsigned long long manifestIn - The manifest key.
+ * @param unsigned long long objectIn   - The cache key of the object.
+ * @param StateRecord *recordIn         - The record of the object with its current headers.
+ * -------------------------------------------------------------------------------------------------------- */
+void cache_store_manifest(CompilationCache *cacheIn, unsigned long long manifestIn, unsigned long long objectIn,
+                          StateRecord *recordIn) {
+    char *directory = cache_bucket(cacheIn, manifestIn);
+    make_directories(directory);
+    free(directory);
+
+    char *path = cache_manifest(cacheIn, manifestIn);
+
+    char *content = NULL;
+    append_format(&content, "%016llx\n", objectIn);
+    for (int i = 0; i < recordIn->depCount; i++)
+        append_format(&content, "%016llx\t%s\n", recordIn->deps[i].hash, recordIn->deps[i].path);
+
+    write_if_changed(path, content);
+    free(content);
+    free(path);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Checks whether the cache can serve a compile without preprocessing it: the manifest exists, every header
+ * it lists still has the same content and the object it points to is still in the cache. Header hashes
+ * come from the file cache of the build state, so every header is read at most once per run.
+ *
+ * @param CompilationCache *cacheIn     - The cache.
+ * @param BuildState *stateIn           - The build state with the file cache.
+ * @param unsigned long long manifestIn - The manifest key.
+ * @return int                          - 1 if the object is in the cache, 0 otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int cache_lookup_manifest(CompilationCache *cacheIn, BuildState *stateIn, unsigned long long manifestIn) {
+    char *path = cache_manifest(cacheIn, manifestIn);
+    FILE *file = fopen(path, "r");
+    free(path);
+    if (file == NULL)
+        return 0;
+
+    char line[4096];
+    unsigned long long key = 0, hash;
+    int hit = fgets(line, sizeof(line), file) != NULL && sscanf(line, "%llx", &key) == 1;
+
+    while (hit && fgets(line, sizeof(line), file) != NULL) {
+        char *tab = strchr(line, '\t');
+        if (tab == NULL || sscanf(line, "%llx", &hash) != 1)
+            break;
+        tab[1 + strcspn(tab + 1, "\r\n")] = '\0';
+        FileInfo *header = file_info(stateIn, tab + 1);
+        hit = header->exists && file_hash(header) == hash;
+    }
+    fclose(file);
+
+    if (hit) {
+        char *entry = cache_entry(cacheIn, key);
+        FileStamp stamp;
+        hit = stamp_file(entry, &stamp) == 0;
+        free(entry);
+    }
+    return hit;
+}
+
+/* ****************************************END COMPILATION CACHE******************************************* */
+
+/* ***************************************START REMOTE COMPILATION***************************************** */
+
+/* --------------------------------------------------------------------------------------------------------
+ * Compile jobs can be shipped to pmake --worker processes on this or other hosts. The coordinator runs
+ * the preprocessor locally, so the worker needs neither the sources nor the headers, sends the
+ * preprocessed unit together with the compiler and its flags, and gets the object and the compiler
+ * output back. Linking always stays local. The protocol is one request per TCP connection:
+ *
+ *   request:   PMAKE1 <flag bytes> <source bytes> <suffix>\n <flags> <preprocessed source>
+ *   response:  <exit code> <output bytes> <object bytes>\n <compiler output> <object>
+ *
+ * The suffix (.i, .ii or .mi) tells the compiler the language of the preprocessed unit.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *host;     // Host name or address of the worker.
+    char *port;     // Its TCP port.
+    int slots;      // The number of compiles it takes at the same time.
+    int busy;       // The number of compiles currently shipped to it.
+} RemoteWorker;
+
+/* --------------------------------------------------------------------------------------------------------
+ * The workers of a run, from --workers host:port[/slots],...
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    RemoteWorker *workers;  // All workers.
+    int count;              // Number of workers.
+} WorkerPool;
+
+/* --------------------------------------------------------------------------------------------------------
+ * Parses the --workers list. Every entry is host:port with an optional /slots.
+ *
+ * @param const char *listIn    - The comma separated list.
+ * @param int slotsIn           - The slots of a worker without /slots, the cores of this machine.
+ * @param WorkerPool *poolOut   - The pool the workers are added to.
+ * @return int                  - 0 on success, -1 if an entry has no port.
+ * -------------------------------------------------------------------------------------------------------- */
+int parse_workers(const char *listIn, int slotsIn, WorkerPool *poolOut) {
+    char *list = NULL;
+    append_format(&list, "%s", listIn);
+
+    int result = 0;
+    for (char *entry = strtok(list, ","); entry != NULL; entry = strtok(NULL, ",")) {
+        RemoteWorker worker = {0};
+        worker.slots = slotsIn;
+
+        char *slash = strchr(entry, '/');
+        if (slash != NULL) {
+            *slash = '\0';
+            worker.slots = atoi(slash + 1) > 0 ? atoi(slash + 1) : 1;
+        }
+
+        char *colon = strrchr(entry, ':');
+        if (colon == NULL || colon[1] == '\0') {
+            fprintf(stderr, "pmake: worker '%s' needs host:port.\n", entry);
+            result = -1;
+            continue;
+        }
+        *colon = '\0';
+        append_format(&worker.host, "%s", entry[0] ? entry : "127.0.0.1");
+        append_format(&worker.port, "%s", colon + 1);
+
+        poolOut->workers = realloc(poolOut->workers, sizeof(RemoteWorker) * (poolOut->count + 1));
+        poolOut->workers[poolOut->count++] = worker;
+    }
+
+    free(list);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Picks the worker for the next compile, the one with the most free slots.
+ *
+ * @param WorkerPool *poolIn    - The pool, may be NULL.
+ * @return int                  - The index of the worker, -1 if all are busy and the job compiles locally.
+ * -------------------------------------------------------------------------------------------------------- */
+int idle_worker(WorkerPool *poolIn) {
+    int best = -1;
+    for (int i = 0; poolIn != NULL && i < poolIn->count; i++) {
+        RemoteWorker *worker = &poolIn->workers[i];
+        if (worker->busy < worker->slots &&
+            (best < 0 || worker->slots - worker->busy > poolIn->workers[best].slots - poolIn->workers[best].busy))
+            best = i;
+    }
+    return best;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The suffix of a preprocessed unit, by the language of its source.
+ *
+ * @param const char *sourceIn  - The translation unit.
+ * @return const char*          - .ii for C++, .mi for Objective-C, .i for C.
+ * -------------------------------------------------------------------------------------------------------- */
+const char *preprocessed_suffix(const char *sourceIn) {
+    const char *dot = strrchr(sourceIn, '.');
+    if (dot != NULL && (strcmp(dot, ".cc") == 0 || strcmp(dot, ".cpp") == 0 || strcmp(dot, ".cxx") == 0))
+        return ".ii";
+    if (dot != NULL && strcmp(dot, ".m") == 0)
+        return ".mi";
+    return ".i";
+}
+
+#ifdef _WIN32
+
+// Windows has neither fork() nor the worker, every compile stays local.
+int ship_compile(RemoteWorker *workerIn, const char *flagsIn, const char *preprocessedIn, const char *suffixIn,
+                 const char *objectIn) {
+    (void)workerIn; (void)flagsIn; (void)preprocessedIn; (void)suffixIn; (void)objectIn;
+    return -1;
+}
+
+int serve_compiles(const char *addressIn, int slotsIn) {
+    (void)addressIn;
+    (void)slotsIn;
+    fprintf(stderr, "pmake: --worker is not supported on Windows.\n");
+    return EXIT_FAILURE;
+}
+
+#else
+
+/* --------------------------------------------------------------------------------------------------------
+ * Sends a whole buffer over a socket.
+ *
+ * @return int - 0 on success, -1 if the connection broke.
+ * -------------------------------------------------------------------------------------------------------- */
+int send_all(int fdIn, const char *dataIn, size_t sizeIn) {
+    while (sizeIn > 0) {
+        ssize_t n = write(fdIn, dataIn, sizeIn);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        dataIn += n;
+        sizeIn -= n;
+    }
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Receives exactly sizeIn bytes from a socket.
+ *
+ * @return int - 0 on success, -1 if the connection broke or ended early.
+ * -------------------------------------------------------------------------------------------------------- */
+int recv_all(int fdIn, char *dataOut, size_t sizeIn) {
+    while (sizeIn > 0) {
+        ssize_t n = read(fdIn, dataOut, sizeIn);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        dataOut += n;
+        sizeIn -= n;
+    }
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Receives the header line of a request or response, without the newline.
+ *
+ * @return int - 0 on success, -1 if the line is too long or the connection broke.
+ * -------------------------------------------------------------------------------------------------------- */
+int recv_line(int fdIn, char *lineOut, size_t sizeIn) {
+    for (size_t length = 0; length + 1 < sizeIn; length++) {
+        if (recv_all(fdIn, lineOut + length, 1) != 0)
+            return -1;
+        if (lineOut[length] == '\n') {
+            lineOut[length] = '\0';
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Sends the first sizeIn bytes of a file over a socket.
+ *
+ * @return int - 0 on success, -1 if the file can't be read or the connection broke.
+ * -------------------------------------------------------------------------------------------------------- */
+int send_file(int fdIn, const char *pathIn, long long sizeIn) {
+    FILE *file = fopen(pathIn, "rb");
+    if (file == NULL)
+        return -1;
+
+    char buffer[65536];
+    int result = 0;
+    while (sizeIn > 0 && result == 0) {
+        size_t n = fread(buffer, 1, sizeIn < (long long)sizeof(buffer) ? (size_t)sizeIn : sizeof(buffer), file);
+        if (n == 0 || send_all(fdIn, buffer, n) != 0)
+            result = -1;
+        sizeIn -= n;
+    }
+    fclose(file);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Receives sizeIn bytes from a socket into a new file.
+ *
+ * @return int - 0 on success, -1 if the file can't be written or the connection broke.
+ * -------------------------------------------------------------------------------------------------------- */
+int recv_file(int fdIn, const char *pathIn, long long sizeIn) {
+    FILE *file = fopen(pathIn, "wb");
+    if (file == NULL)
+        return -1;
+
+    char buffer[65536];
+    int result = 0;
+    while (sizeIn > 0 && result == 0) {
+        size_t n = sizeIn < (long long)sizeof(buffer) ? (size_t)sizeIn : sizeof(buffer);
+        if (recv_all(fdIn, buffer, n) != 0 || fwrite(buffer, 1, n, file) != n)
+            result = -1;
+        sizeIn -= n;
+    }
+    if (fclose(file) != 0)
+        result = -1;
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Opens a TCP connection.
+ *
+ * @return int - The connected socket, -1 if the host can't be reached.
+ * -------------------------------------------------------------------------------------------------------- */
+int connect_tcp(const char *hostIn, const char *portIn) {
+    struct addrinfo hints = {0}, *addresses;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(hostIn, portIn, &hints, &addresses) != 0)
+        return -1;
+
+    int fd = -1;
+    for (struct addrinfo *a = addresses; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Compiles a preprocessed unit on a worker. Runs in the process of the job, the compiler output is
+ * copied to stderr and the object is written to objectIn.
+ *
+ * @param RemoteWorker *workerIn        - The worker.
+ * @param const char *flagsIn           - The compiler and its flags.
+ * @param const char *preprocessedIn    - The preprocessed unit.
+ * @param const char *suffixIn          - The suffix of the preprocessed unit, by language.
+ * @param const char *objectIn          - The object to write.
+ * @return int                          - The exit code of the compiler, -1 if the worker failed.
+ * -------------------------------------------------------------------------------------------------------- */
+int ship_compile(RemoteWorker *workerIn, const char *flagsIn, const char *preprocessedIn, const char *suffixIn,
+                 const char *objectIn) {
+    FileStamp stamp;
+    if (stamp_file(preprocessedIn, &stamp) != 0)
+        return -1;
+
+    int fd = connect_tcp(workerIn->host, workerIn->port);
+    if (fd < 0)
+        return -1;
+
+    char line[256];
+    snprintf(line, sizeof(line), "PMAKE1 %zu %lld %s\n", strlen(flagsIn), stamp.size, suffixIn);
+
+    int status;
+    long long outputSize, objectSize;
+    if (send_all(fd, line, strlen(line)) != 0 || send_all(fd, flagsIn, strlen(flagsIn)) != 0 ||
+        send_file(fd, preprocessedIn, stamp.size) != 0 || recv_line(fd, line, sizeof(line)) != 0 ||
+        sscanf(line, "%d %lld %lld", &status, &outputSize, &objectSize) != 3) {
+        close(fd);
+        return -1;
+    }
+
+    // Warnings and errors of the compiler, as if it ran here.
+    char buffer[4096];
+    while (outputSize > 0) {
+        size_t n = outputSize < (long long)sizeof(buffer) ? (size_t)outputSize : sizeof(buffer);
+        if (recv_all(fd, buffer, n) != 0) {
+            close(fd);
+            return -1;
+        }
+        fwrite(buffer, 1, n, stderr);
+        outputSize -= n;
+    }
+
+    if (status == 0 && recv_file(fd, objectIn, objectSize) != 0) {
+        remove(objectIn);
+        status = -1;
+    }
+    close(fd);
+    return status;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * A worker runs the compiler a coordinator asks for, but only a compiler: the command is started without
+ * a shell and its program has to be one of the known compilers, found in the PATH of the worker, never a
+ * path the client chose. A version suffix like gcc-12 or clang-17 is fine.
+ *
+ * @param const char *programIn - The first word of the command.
+ * @return int                  - 1 if the program may run.
+ * -------------------------------------------------------------------------------------------------------- */
+int compiler_allowed(const char *programIn) {
+    static const char *compilers[] = { "cc", "c++", "gcc", "g++", "clang", "clang++", NULL };
+
+    if (strchr(programIn, '/') != NULL)
+        return 0;
+    size_t length = strlen(programIn);
+    const char *dash = strrchr(programIn, '-');
+    if (dash != NULL && dash[1] != '\0' && strspn(dash + 1, "0123456789.") == strlen(dash + 1))
+        length = (size_t)(dash - programIn);
+
+    for (int i = 0; compilers[i] != NULL; i++)
+        if (strlen(compilers[i]) == length && strncmp(programIn, compilers[i], length) == 0)
+            return 1;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Looks up the name of a -f or -g option in a list. A leading no-, a =value and a level like the 3 of
+ * -gdwarf-3 don't count.
+ *
+ * @param const char *nameIn    - The option without -f or -g.
+ * @param const char **listIn   - The known names, NULL terminated.
+ * @return int                  - 1 if the name is in the list.
+ * -------------------------------------------------------------------------------------------------------- */
+int option_listed(const char *nameIn, const char **listIn) {
+    if (strncmp(nameIn, "no-", 3) == 0)
+        nameIn += 3;
+    size_t length = strcspn(nameIn, "=");
+    size_t level = length;
+    while (level > 0 && isdigit((unsigned char)nameIn[level - 1]))
+        level--;
+    if (level < length && level > 0 && nameIn[level - 1] == '-')
+        level--;
+
+    for (int i = 0; listIn[i] != NULL; i++)
+        if (strlen(listIn[i]) == level && strncmp(nameIn, listIn[i], level) == 0)
+            return 1;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The flags of a compile request come from the network, so a worker only passes on flags it knows to be
+ * harmless for compiling a preprocessed unit: -O levels, warnings, -m machine options, -std=, debug
+ * information, a vetted list of -f options and -D, -U and -I, which do nothing on a preprocessed unit.
+ * Everything else is refused, above all flags that take a path, run other programs, load code into the
+ * compiler or read more flags from a file.
+ *
+ * @param const char *flagIn        - One word of the flags, after the compiler.
+ * @param const char *argumentIn    - The word after it, NULL if there is none.
+ * @return int                      - The number of words the flag takes, 0 if it is refused.
+ * -------------------------------------------------------------------------------------------------------- */
+int flag_allowed(const char *flagIn, const char *argumentIn) {
+    static const char *features[] = {
+        "PIC", "pic", "PIE", "pie", "plt", "semantic-interposition", "visibility", "visibility-inlines-hidden",
+        "common", "function-sections", "data-sections", "zero-initialized-in-bss", "merge-constants", "ident",
+        "exceptions", "rtti", "threadsafe-statics", "use-cxa-atexit", "asynchronous-unwind-tables",
+        "unwind-tables", "omit-frame-pointer", "optimize-sibling-calls", "inline", "inline-functions",
+        "inline-small-functions", "unroll-loops", "tree-vectorize", "vectorize", "slp-vectorize",
+        "align-functions", "align-loops", "align-jumps", "align-labels", "lto", "fast-math",
+        "finite-math-only", "math-errno", "signed-zeros", "trapping-math", "strict-aliasing",
+        "strict-overflow", "strict-flex-arrays", "wrapv", "trapv", "delete-null-pointer-checks",
+        "signed-char", "unsigned-char", "short-enums", "builtin", "freestanding", "hosted", "asm",
+        "gnu-keywords", "gnu89-inline", "ms-extensions", "permissive", "char8_t", "coroutines",
+        "openmp", "openmp-simd", "stack-protector", "stack-protector-strong", "stack-protector-all",
+        "stack-protector-explicit", "stack-clash-protection", "cf-protection", "trivial-auto-var-init",
+        "hardened", "sanitize", "sanitize-recover", "diagnostics-color", "color-diagnostics",
+        "diagnostics-show-option", "max-errors", "message-length", "template-depth", "constexpr-depth",
+        "constexpr-steps", NULL };
+    static const char *debugInfo[] = {
+        "", "gdb", "dwarf", "split-dwarf", "z", "column-info", "line-tables-only", "line-directives-only",
+        "strict-dwarf", "pubnames", "gnu-pubnames", "btf", "ctf", "codeview", "record-gcc-switches", "full",
+        "used", "inline-points", "statement-frontiers", "variable-location-views", "descriptive-names",
+        "simple-template-names", NULL };
+    static const char *plain[] = { "-w", "-pedantic", "-pedantic-errors", "-ansi", "-pthread", "-pipe",
+                                   "-O", "-O0", "-O1", "-O2", "-O3", "-Os", "-Oz", "-Og", "-Ofast", NULL };
+
+    for (int i = 0; plain[i] != NULL; i++)
+        if (strcmp(flagIn, plain[i]) == 0)
+            return 1;
+
+    if (strcmp(flagIn, "-D") == 0 || strcmp(flagIn, "-U") == 0 || strcmp(flagIn, "-I") == 0)
+        return argumentIn != NULL && argumentIn[0] != '-' ? 2 : 0;
+    if ((flagIn[1] == 'D' || flagIn[1] == 'U' || flagIn[1] == 'I') && flagIn[0] == '-')
+        return 1;
+
+    if (strncmp(flagIn, "-W", 2) == 0)
+        return flagIn[2] != '\0' && strchr(flagIn, ',') == NULL;
+    if (strncmp(flagIn, "-m", 2) == 0)
+        return flagIn[2] != '\0' && strncmp(flagIn, "-mllvm", 6) != 0 && strncmp(flagIn, "-module", 7) != 0;
+    if (strncmp(flagIn, "-std=", 5) == 0)
+        return flagIn[5] != '\0';
+    if (strncmp(flagIn, "-f", 2) == 0)
+        return option_listed(flagIn + 2, features);
+    if (strncmp(flagIn, "-g", 2) == 0)
+        return option_listed(flagIn + 2, debugInfo);
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Answers one compile request on a worker. The unit is compiled in a private temporary directory that is
+ * removed afterwards.
+ *
+ * @param int clientIn  - The connected coordinator.
+ * @return int          - 0 if a response was sent, -1 for a broken request.
+ * -------------------------------------------------------------------------------------------------------- */
+int compile_request(int clientIn) {
+    char line[256], suffix[8];
+    size_t flagsSize;
+    long long sourceSize;
+    if (recv_line(clientIn, line, sizeof(line)) != 0 ||
+        sscanf(line, "PMAKE1 %zu %lld %7s", &flagsSize, &sourceSize, suffix) != 3 || flagsSize > 65536 ||
+        (strcmp(suffix, ".i") != 0 && strcmp(suffix, ".ii") != 0 && strcmp(suffix, ".mi") != 0))
+        return -1;
+
+    char *flags = calloc(flagsSize + 1, 1);
+    char directory[] = "/tmp/pmake-worker-XXXXXX";
+    if (recv_all(clientIn, flags, flagsSize) != 0 || mkdtemp(directory) == NULL) {
+        free(flags);
+        return -1;
+    }
+
+    char *source = NULL, *object = NULL, *output = NULL;
+    append_format(&source, "%s/unit%s", directory, suffix);
+    append_format(&object, "%s/unit.o", directory);
+    append_format(&output, "%s/output", directory);
+
+    int status = -1;
+    if (recv_file(clientIn, source, sourceSize) == 0) {
+        printf("%s-c unit%s (%lld bytes)\n", flags, suffix, sourceSize);
+        fflush(stdout);
+
+        int count = 0;
+        char **words = split_words(flags, &count);
+        char **argv = malloc(sizeof(char *) * (count + 5));
+        memcpy(argv, words, sizeof(char *) * count);
+        argv[count] = "-c";
+        argv[count + 1] = source;
+        argv[count + 2] = "-o";
+        argv[count + 3] = object;
+        argv[count + 4] = NULL;
+
+        const char *refused = count == 0 || !compiler_allowed(argv[0]) ? (count ? argv[0] : "") : NULL;
+        for (int i = 1, taken = 1; refused == NULL && i < count; i += taken) {
+            taken = flag_allowed(argv[i], i + 1 < count ? argv[i + 1] : NULL);
+            if (taken == 0)
+                refused = argv[i];
+        }
+
+        if (refused != NULL) {
+            FILE *file = fopen(output, "w");
+            if (file != NULL) {
+                fprintf(file, "pmake worker: '%s' is not allowed.\n", refused);
+                fclose(file);
+            }
+            status = 126;
+        } else {
+            pid_t pid = fork();
+            if (pid == 0) {
+                int fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd >= 0) {
+                    dup2(fd, STDOUT_FILENO);
+                    dup2(fd, STDERR_FILENO);
+                    close(fd);
+                }
+                // Anything the compiler writes next to its output ends up in the private directory.
+                if (chdir(directory) != 0)
+                    _exit(127);
+                execvp(argv[0], argv);
+                _exit(127);
+            }
+            int wstatus;
+            if (pid > 0 && waitpid(pid, &wstatus, 0) == pid)
+                status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+        }
+        free(argv);
+        free(words);
+    }
+
+    FileStamp outputStamp = {0}, objectStamp = {0};
+    stamp_file(output, &outputStamp);
+    if (status != 0 || stamp_file(object, &objectStamp) != 0)
+        objectStamp.size = 0;
+
+    int result = -1;
+    if (status >= 0) {
+        snprintf(line, sizeof(line), "%d %lld %lld\n", status, outputStamp.size, objectStamp.size);
+        if (send_all(clientIn, line, strlen(line)) == 0 && send_file(clientIn, output, outputStamp.size) == 0 &&
+            send_file(clientIn, object, objectStamp.size) == 0)
+            result = 0;
+    }
+
+    remove(source);
+    remove(object);
+    remove(output);
+    rmdir(directory);
+    free(source);
+    free(object);
+    free(output);
+    free(flags);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Runs pmake as a compile worker. Every connection is one compile in a process of its own, at most
+ * slotsIn of them at the same time, further connections wait in the listen queue. Without a host, or
+ * with an empty one as in :port, the worker only listens on 127.0.0.1: it runs compilers for whoever
+ * connects, so it must only be reachable from trusted hosts. 0.0.0.0:port listens on all interfaces.
+ *
+ * @param const char *addressIn - [host:]port to listen on.
+ * @param int slotsIn           - The number of compiles at the same time.
+ * @return int                  - EXIT_FAILURE if the worker can't listen.
+ * -------------------------------------------------------------------------------------------------------- */
+int serve_compiles(const char *addressIn, int slotsIn) {
+    char *host = NULL;
+    const char *port = addressIn;
+    const char *colon = strrchr(addressIn, ':');
+    if (colon != NULL && colon > addressIn)
+        append_format(&host, "%.*s", (int)(colon - addressIn), addressIn);
+    else
+        append_format(&host, "127.0.0.1");
+    if (colon != NULL)
+        port = colon + 1;
+
+    struct addrinfo hints = {0}, *address;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    int listener = -1, yes = 1;
+    if (getaddrinfo(host, port, &hints, &address) == 0) {
+        listener = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (listener >= 0 && (bind(listener, address->ai_addr, address->ai_addrlen) != 0 || listen(listener, 64) != 0)) {
+            close(listener);
+            listener = -1;
+        }
+        freeaddrinfo(address);
+    }
+    if (listener < 0) {
+        fprintf(stderr, "pmake: can't listen on %s.\n", addressIn);
+        free(host);
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    printf("pmake: compile worker on %s:%s with %d slot(s).\n", host, port, slotsIn);
+    fflush(stdout);
+    free(host);
+
+    int active = 0;
+    for (;;) {
+        // Reap finished compiles, and wait for one while all slots are taken.
+        while (active > 0 && waitpid(-1, NULL, active >= slotsIn ? 0 : WNOHANG) > 0)
+            active--;
+
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("accept");
+            break;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            int result = compile_request(client);
+            close(client);
+            _exit(result == 0 ? 0 : 1);
+        }
+        close(client);
+        if (pid > 0)
+            active++;
+    }
+
+    close(listener);
+    return EXIT_FAILURE;
+}
+
+#endif
+
+/* ****************************************END REMOTE COMPILATION****************************************** */
+
+/* ***************************************START JOB SCHEDULER********************************************** */
+
+// Possible states of a job in the build plan.
+#define JOB_WAITING  0  // Still waiting for at least one prerequisite.
+#define JOB_READY    1  // All prerequisites are done, the job sits in the ready queue.
+#define JOB_RUNNING  2  // The command is executing in a worker process.
+#define JOB_DONE     3  // The command finished successfully.
+#define JOB_FAILED   4  // The command returned a non zero exit code.
+
+// Phases of a compile job that goes through the compilation cache.
+#define PHASE_COMMAND    0  // A plain job, it only runs its command.
+#define PHASE_PREPROCESS 1  // The preprocessor runs to compute the cache key.
+#define PHASE_COMPILE    2  // The cache missed, the compiler runs and the object is stored.
+#define PHASE_REMOTE     3  // The cache missed, a remote worker compiles the preprocessed unit.
+
+/* --------------------------------------------------------------------------------------------------------
+ * A Job is one single step of the build: compiling one translation unit into an object file or linking
+ * all objects into the final artifact. Jobs know which other jobs wait for them (dependents) and how many
+ * of their own prerequisites are still outstanding (pendingDeps). As soon as pendingDeps drops to zero the
+ * job is handed to the next free worker process. A compile job with a preprocess command first runs the
+ * preprocessor and only runs the compiler if the compilation cache doesn't have the object yet.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    char *command;      // The complete compiler command of this job.
+    char *output;       // The file this job produces.
+    int *dependents;    // Indices of the jobs that wait for this job.
+    int dependentCount; // Number of entries in dependents.
+    int pendingDeps;    // Number of prerequisites that are not done yet.
+    int state;          // One of the JOB_* states.
+    int status;         // Exit code of the command once it is finished.
+    long pid;           // Process id of the worker while the job is running.
+    int pipe;           // Read end of the pipe with the output of the running command, -1 once closed.
+    char *log;          // What the running command wrote to stdout and stderr so far.
+    int record;         // Build state record that becomes valid once the job succeeded, or -1.
+    char *preprocess;   // Preprocessor command of a cacheable compile job, NULL otherwise.
+    char *flags;        // Compiler and flags of a cacheable compile job, what a worker runs on the unit.
+    int worker;         // The remote worker compiling the job, -1 while it runs locally.
+    unsigned long long cacheSalt;   // Hash over compiler identity and flags, part of the cache key.
+    unsigned long long cacheKey;    // The cache key once the preprocessor ran.
+    int phase;          // One of the PHASE_* values.
+    char *directory;    // Directory the commands run in, NULL for the current directory.
+    char *source;       // The translation unit of a compile job, NULL for a link job.
+    const char *kind;   // compile, link or run, for the reports.
+    char *reason;       // Why the job is in the plan, for --dry-run.
+    int slot;           // The worker slot while the job is running, the lane in the trace.
+    long long readyAt;  // When the job entered the ready queue, in nanoseconds.
+    long long startedAt;        // When the first command of the job started.
+    long long phaseStartedAt;   // When the current command of the job started.
+    long long finishedAt;       // When the last command of the job finished.
+} Job;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A TraceEvent is one finished command of a job: the preprocessor, the compiler or the linker, with the
+ * worker slot it ran in. A compile job going through the cache has up to two of them.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    int job;            // The job the command belongs to.
+    int phase;          // The PHASE_* the job was in.
+    int slot;           // The worker slot.
+    long long start;    // Start of the command in nanoseconds.
+    long long end;      // End of the command in nanoseconds.
+} TraceEvent;
+
+/* --------------------------------------------------------------------------------------------------------
+ * The BuildPlan holds all jobs of one pmake run in a growing array. The index of a job in this array is
+ * its identity, dependencies between jobs are expressed with these indices.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    Job *jobs;      // All jobs of the plan.
+    int count;      // Number of jobs in the plan.
+    int capacity;   // Allocated number of jobs.
+    TraceEvent *events;     // Every command that ran, in the order they finished.
+    int eventCount;         // Number of events.
+    long long startedAt;    // When the plan started to run, in nanoseconds.
+    long long finishedAt;   // When the last job finished.
+} BuildPlan;
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns a monotonic clock in nanoseconds, only differences between two calls are meaningful.
+ *
+ * @return long long - The current time in nanoseconds.
+ * -------------------------------------------------------------------------------------------------------- */
+long long now_ns(void) {
+#ifdef _WIN32
+    return (long long)clock() * (1000000000LL / CLOCKS_PER_SEC);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the number of cores of this machine, which is the default for the -j option. If the number
+ * can't be determined, pmake falls back to one job at a time.
+ *
+ * @return int - The number of online processors, at least 1.
+ * -------------------------------------------------------------------------------------------------------- */
+int default_job_count(void) {
+#ifdef _WIN32
+    char *cores = getenv("NUMBER_OF_PROCESSORS");
+    int count = cores ? atoi(cores) : 1;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds a new job to the build plan. The plan takes ownership of the command and output strings.
+ *
+ * @param BuildPlan *planIn - The plan the job is added to.
+ * @param char *commandIn   - The compiler command, allocated with append_format.
+ * @param char *outputIn    - The file the command produces, allocated with append_format.
+ * @return int              - The index of the new job, or -1 if memory ran out.
+ * -------------------------------------------------------------------------------------------------------- */
+int add_job(BuildPlan *planIn, char *commandIn, char *outputIn) {
+
+    if (planIn->count == planIn->capacity) {
+        int capacity = planIn->capacity ? planIn->capacity * 2 : 32;
+        Job *jobs = realloc(planIn->jobs, sizeof(Job) * capacity);
+        if (jobs == NULL) {
+            perror("realloc failed");
+            return -1;
+        }
+        planIn->jobs = jobs;
+        planIn->capacity = capacity;
+    }
+
+    Job *job = &planIn->jobs[planIn->count];
+    memset(job, 0, sizeof(Job));
+    job->command = commandIn;
+    job->output = outputIn;
+    job->state = JOB_WAITING;
+    job->record = -1;
+    job->worker = -1;
+    job->pipe = -1;
+    job->kind = "link";
+
+    return planIn->count++;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Declares that the job jobIn can only start after the job prerequisiteIn finished successfully.
+ *
+ * @param BuildPlan *planIn    - The plan both jobs belong to.
+ * @param int jobIn            - Index of the job that has to wait.
+ * @param int prerequisiteIn   - Index of the job that has to finish first.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_dependency(BuildPlan *planIn, int jobIn, int prerequisiteIn) {
+
+    Job *prerequisite = &planIn->jobs[prerequisiteIn];
+    int *dependents = realloc(prerequisite->dependents, sizeof(int) * (prerequisite->dependentCount + 1));
+    if (dependents == NULL) {
+        perror("realloc failed");
+        return;
+    }
+    dependents[prerequisite->dependentCount++] = jobIn;
+    prerequisite->dependents = dependents;
+    planIn->jobs[jobIn].pendingDeps++;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Releases all memory held by the build plan and its jobs.
+ *
+ * @param BuildPlan *planIn - The plan to free.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_plan(BuildPlan *planIn) {
+    for (int i = 0; i < planIn->count; i++) {
+        free(planIn->jobs[i].command);
+        free(planIn->jobs[i].output);
+        free(planIn->jobs[i].dependents);
+        free(planIn->jobs[i].preprocess);
+        free(planIn->jobs[i].flags);
+        free(planIn->jobs[i].log);
+        free(planIn->jobs[i].directory);
+        free(planIn->jobs[i].source);
+        free(planIn->jobs[i].reason);
+    }
+    free(planIn->jobs);
+    free(planIn->events);
+    memset(planIn, 0, sizeof(BuildPlan));
+}
+
+#ifndef _WIN32
+
+/* --------------------------------------------------------------------------------------------------------
+ * Starts a command in a new process, with stdout and stderr going into a pipe. Commands without shell
+ * syntax are split into their arguments and the program is started directly with posix_spawn, which
+ * saves a shell per compile, everything else runs through /bin/sh.
+ *
+ * @param const char *commandIn     - The command.
+ * @param const char *directoryIn   - The directory the command runs in, NULL for the current one.
+ * @param int outputIn              - The write end of the output pipe.
+ * @return pid_t                    - The process id, -1 if the command couldn't be started.
+ * -------------------------------------------------------------------------------------------------------- */
+pid_t spawn_command(const char *commandIn, const char *directoryIn, int outputIn) {
+    char *text = NULL;
+    char **argv = needs_shell(commandIn) ? NULL : split_command(commandIn, &text);
+    char *shell[] = { "sh", "-c", (char *)commandIn, NULL };
+    int direct = argv != NULL && argv[0] != NULL;
+    char **args = direct ? argv : shell;
+    pid_t pid = -1;
+
+#ifdef PMAKE_SPAWN_CHDIR
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, outputIn, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, outputIn, STDERR_FILENO);
+    if (directoryIn != NULL)
+        posix_spawn_file_actions_addchdir_np(&actions, directoryIn);
+
+    int error = direct ? posix_spawnp(&pid, args[0], &actions, NULL, args, environ)
+                       : posix_spawn(&pid, "/bin/sh", &actions, NULL, args, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0) {
+        fprintf(stderr, "pmake: %s: %s\n", args[0], strerror(error));
+        pid = -1;
+    }
+#else
+    // Without a directory for posix_spawn the child changes the directory itself.
+    pid = fork();
+    if (pid == 0) {
+        dup2(outputIn, STDOUT_FILENO);
+        dup2(outputIn, STDERR_FILENO);
+        if (directoryIn != NULL && chdir(directoryIn) != 0) {
+            perror(directoryIn);
+            _exit(127);
+        }
+        if (direct)
+            execvp(args[0], args);
+        else
+            execv("/bin/sh", args);
+        perror(args[0]);
+        _exit(127);
+    }
+    if (pid < 0)
+        perror("fork");
+#endif
+
+    free(argv);
+    free(text);
+    return pid;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Creates the pipe that collects the output of a job. Both ends are closed on exec, so no other job
+ * inherits them and the end of the output is seen as soon as the job's own process exits.
+ *
+ * @param int fdsOut[2] - Receives the read and the write end.
+ * @return int          - 0 on success, -1 on failure.
+ * -------------------------------------------------------------------------------------------------------- */
+int output_pipe(int fdsOut[2]) {
+    if (pipe(fdsOut) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    fcntl(fdsOut[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fdsOut[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+}
+
+#endif
+
+/* --------------------------------------------------------------------------------------------------------
+ * Starts a command of a job in its own process, so pmake can keep several of them busy at the same time.
+ * The output of the command is collected and printed in one piece once it finished, so diagnostics of
+ * parallel jobs never interleave. Windows has no fork(), there the command runs to completion right away
+ * and the scheduler degrades to one job at a time. A job with a directory runs its command inside that
+ * directory, the paths of a makefile are relative to it.
+ *
+ * @param Job *jobIn            - The job to start.
+ * @param const char *commandIn - The command to run, the job's command or its preprocess command.
+ * @return int                  - 0 if the job was started, -1 if no worker could be created.
+ * -------------------------------------------------------------------------------------------------------- */
+int start_job(Job *jobIn, const char *commandIn) {
+
+    printf("%s\n", commandIn);
+    fflush(stdout);
+
+    jobIn->phaseStartedAt = now_ns();
+    if (jobIn->startedAt == 0)
+        jobIn->startedAt = jobIn->phaseStartedAt;
+
+#ifdef _WIN32
+    if (jobIn->directory != NULL && _chdir(jobIn->directory) != 0)
+        perror(jobIn->directory);
+    jobIn->status = system(commandIn);
+    jobIn->pid = 0;
+#else
+    int fds[2];
+    if (output_pipe(fds) != 0)
+        return -1;
+
+    pid_t pid = spawn_command(commandIn, jobIn->directory, fds[1]);
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return -1;
+    }
+    jobIn->pid = pid;
+    jobIn->pipe = fds[0];
+#endif
+
+    jobIn->state = JOB_RUNNING;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Waits until one of the running jobs is finished and stores its exit code. While waiting, the output of
+ * all running jobs is collected. A job is finished once its output pipe is closed and its process is
+ * reaped, then its output is printed in one piece.
+ *
+ * @param BuildPlan *planIn - The plan with the running jobs.
+ * @return int              - The index of the finished job, or -1 if no job was running.
+ * -------------------------------------------------------------------------------------------------------- */
+int wait_for_job(BuildPlan *planIn) {
+
+#ifdef _WIN32
+    // The job already finished inside start_job().
+    for (int i = 0; i < planIn->count; i++)
+        if (planIn->jobs[i].state == JOB_RUNNING)
+            return i;
+    return -1;
+#else
+    struct pollfd *fds = malloc(sizeof(struct pollfd) * (planIn->count + 1));
+    int *owners = malloc(sizeof(int) * (planIn->count + 1));
+    int finished = -1;
+
+    while (finished < 0) {
+        int n = 0, running = 0;
+        for (int i = 0; i < planIn->count && finished < 0; i++) {
+            Job *job = &planIn->jobs[i];
+            if (job->state != JOB_RUNNING || job->pid <= 0)
+                continue;
+            running++;
+            if (job->pipe < 0) {
+                finished = i;
+            } else {
+                fds[n].fd = job->pipe;
+                fds[n].events = POLLIN;
+                fds[n].revents = 0;
+                owners[n++] = i;
+            }
+        }
+        if (finished >= 0 || running == 0)
+            break;
+
+        if (poll(fds, n, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+
+        for (int k = 0; k < n; k++) {
+            if (fds[k].revents == 0)
+                continue;
+            Job *job = &planIn->jobs[owners[k]];
+            char buffer[4096];
+            ssize_t length = read(job->pipe, buffer, sizeof(buffer));
+            if (length > 0) {
+                append_format(&job->log, "%.*s", (int)length, buffer);
+            } else if (length == 0 || errno != EINTR) {
+                close(job->pipe);
+                job->pipe = -1;
+            }
+        }
+    }
+
+    free(fds);
+    free(owners);
+    if (finished < 0)
+        return -1;
+
+    Job *job = &planIn->jobs[finished];
+    int status;
+    pid_t pid;
+    do {
+        pid = waitpid(job->pid, &status, 0);
+    } while (pid < 0 && errno == EINTR);
+    job->status = pid < 0 ? 127 : WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    job->pid = 0;
+
+    // The log stays with the job until run_plan moved it on, the cache keeps the compiler's warnings.
+    if (job->log != NULL) {
+        fwrite(job->log, 1, strlen(job->log), stdout);
+        fflush(stdout);
+    }
+    return finished;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Ships the compile of a job to a remote worker. A process of its own sends the preprocessed unit and
+ * waits for the object, so the scheduler waits for it like for any local command. If the worker can't be
+ * reached, that process compiles the unit locally instead.
+ *
+ * @param Job *jobIn                    - The job, its preprocessor already ran.
+ * @param WorkerPool *poolIn            - The workers.
+ * @param int workerIn                  - The worker to use.
+ * @param const char *preprocessedIn    - The preprocessed unit, removed once it was sent.
+ * @return int                          - 0 if the job was started, -1 if no process could be created.
+ * -------------------------------------------------------------------------------------------------------- */
+int start_remote(Job *jobIn, WorkerPool *poolIn, int workerIn, const char *preprocessedIn) {
+#ifdef _WIN32
+    (void)jobIn; (void)poolIn; (void)workerIn; (void)preprocessedIn;
+    return -1;
+#else
+    RemoteWorker *worker = &poolIn->workers[workerIn];
+    printf("%s (on %s:%s)\n", jobIn->command, worker->host, worker->port);
+    fflush(stdout);
+
+    int fds[2];
+    if (output_pipe(fds) != 0)
+        return -1;
+
+    jobIn->phaseStartedAt = now_ns();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        int status = ship_compile(worker, jobIn->flags, preprocessedIn, preprocessed_suffix(jobIn->source),
+                                  jobIn->output);
+        remove(preprocessedIn);
+        // 126 is a worker refusing the compiler or a flag, the unit can still be compiled here.
+        if (status >= 0 && status != 126)
+            _exit(status);
+
+        fprintf(stderr, "pmake: worker %s:%s failed, compiling %s here.\n", worker->host, worker->port,
+                jobIn->source);
+        execl("/bin/sh", "sh", "-c", jobIn->command, (char *)NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    jobIn->pid = pid;
+    jobIn->pipe = fds[0];
+    jobIn->worker = workerIn;
+    worker->busy++;
+    return 0;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Starts a job from the ready queue. With a cache or remote workers, a compile job starts with its
+ * preprocessor command.
+ *
+ * @return int - 0 if the job was started, -1 if no worker could be created.
+ * -------------------------------------------------------------------------------------------------------- */
+int launch_job(Job *jobIn, CompilationCache *cacheIn, WorkerPool *workersIn) {
+    if ((cacheIn != NULL || (workersIn != NULL && workersIn->count > 0)) && jobIn->preprocess != NULL) {
+        jobIn->phase = PHASE_PREPROCESS;
+        return start_job(jobIn, jobIn->preprocess);
+    }
+    jobIn->phase = PHASE_COMMAND;
+    return start_job(jobIn, jobIn->command);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Moves a cacheable compile job to its next phase after one of its commands succeeded. After the
+ * preprocessor the cache is asked for the object: on a hit the job is done, on a miss the compiler is
+ * started in the same worker slot, or the unit is shipped to a remote worker with a free slot. After the
+ * compiler the new object is stored in the cache.
+ *
+ * @param Job *jobIn                - The job whose command just finished successfully.
+ * @param CompilationCache *cacheIn - The cache, NULL if caching is off.
+ * @param WorkerPool *workersIn     - The remote workers, NULL for none.
+ * @return int                      - 1 if the job is still running, 0 if it is done, -1 on failure.
+ * -------------------------------------------------------------------------------------------------------- */
+int advance_job(Job *jobIn, CompilationCache *cacheIn, WorkerPool *workersIn) {
+
+    // The output paths of the job are relative to its directory.
+    if (jobIn->phase != PHASE_COMMAND && jobIn->directory != NULL && chdir(jobIn->directory) != 0) {
+        perror(jobIn->directory);
+        return -1;
+    }
+
+    if (jobIn->phase == PHASE_PREPROCESS) {
+        char *preprocessed = NULL;
+        append_format(&preprocessed, "%s.i", jobIn->output);
+        int hit = cacheIn != NULL &&
+                  cache_fetch(cacheIn, preprocessed, jobIn->cacheSalt, jobIn->output, &jobIn->cacheKey);
+
+        if (hit) {
+            remove(preprocessed);
+            free(preprocessed);
+            printf("Cache hit: %s\n", jobIn->output);
+            return 0;
+        }
+
+        // The compiler must write a new file, never into an inode shared with the cache.
+        remove(jobIn->output);
+
+        int worker = idle_worker(workersIn);
+        if (worker >= 0) {
+            jobIn->phase = PHASE_REMOTE;
+            int started = start_remote(jobIn, workersIn, worker, preprocessed);
+            free(preprocessed);
+            return started == 0 ? 1 : -1;
+        }
+
+        remove(preprocessed);
+        free(preprocessed);
+        jobIn->phase = PHASE_COMPILE;
+        return start_job(jobIn, jobIn->command) == 0 ? 1 : -1;
+    }
+
+    if ((jobIn->phase == PHASE_COMPILE || jobIn->phase == PHASE_REMOTE) && cacheIn != NULL)
+        cache_store(cacheIn, jobIn->output, jobIn->cacheKey, jobIn->log);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The run_plan function is the heart of the scheduler. It keeps up to maxJobsIn worker processes busy with
+ * jobs whose prerequisites are all done. Every time a worker finishes, the jobs waiting for it are
+ * released into the ready queue. After the first failure no new jobs are started, the running ones are
+ * allowed to finish so their diagnostics are not lost. With keepGoingIn the scheduler carries on instead,
+ * the jobs depending on a failed job simply never become ready and stay JOB_WAITING.
+ *
+ * @param BuildPlan *planIn         - The plan to execute.
+ * @param int maxJobsIn             - The maximum number of jobs running at the same time.
+ * @param CompilationCache *cacheIn - The compilation cache, NULL if caching is off.
+ * @param WorkerPool *workersIn     - The remote workers compiles are shipped to, NULL for none.
+ * @param int keepGoingIn           - 1 to keep building everything that doesn't depend on a failure.
+ * @return int                      - The number of failed jobs, 0 means the build succeeded.
+ * -------------------------------------------------------------------------------------------------------- */
+int run_plan(BuildPlan *planIn, int maxJobsIn, CompilationCache *cacheIn, WorkerPool *workersIn, int keepGoingIn) {
+
+    int *ready = malloc(sizeof(int) * (planIn->count + 1));
+    int *slots = calloc(maxJobsIn, sizeof(int));
+    int readyHead = 0, readyTail = 0;
+    int running = 0, failed = 0;
+
+    // Every command of a job is one event, a cached compile has two.
+    planIn->events = malloc(sizeof(TraceEvent) * (2 * planIn->count + 1));
+
+    if (ready == NULL || slots == NULL || planIn->events == NULL) {
+        perror("malloc failed");
+        free(ready);
+        free(slots);
+        return 1;
+    }
+
+    planIn->startedAt = now_ns();
+
+    // Seed the ready queue with every job that has no prerequisites.
+    for (int i = 0; i < planIn->count; i++) {
+        if (planIn->jobs[i].pendingDeps == 0) {
+            planIn->jobs[i].state = JOB_READY;
+            planIn->jobs[i].readyAt = planIn->startedAt;
+            ready[readyTail++] = i;
+        }
+    }
+
+    for (;;) {
+
+        // Fill all free worker slots, unless something already failed.
+        while ((!failed || keepGoingIn) && running < maxJobsIn && readyHead < readyTail) {
+            Job *job = &planIn->jobs[ready[readyHead++]];
+
+            // Take the first free worker slot.
+            job->slot = 0;
+            while (slots[job->slot])
+                job->slot++;
+
+            if (launch_job(job, cacheIn, workersIn) != 0) {
+                job->state = JOB_FAILED;
+                failed++;
+                if (!keepGoingIn)
+                    break;
+                continue;
+            }
+            slots[job->slot] = 1;
+            running++;
+        }
+
+        if (running == 0)
+            break;
+
+        int finished = wait_for_job(planIn);
+        if (finished < 0)
+            break;
+
+        Job *job = &planIn->jobs[finished];
+        job->finishedAt = now_ns();
+
+        TraceEvent *event = &planIn->events[planIn->eventCount++];
+        event->job = finished;
+        event->phase = job->phase;
+        event->slot = job->slot;
+        event->start = job->phaseStartedAt;
+        event->end = job->finishedAt;
+
+        // The remote worker has a free slot again.
+        if (job->worker >= 0) {
+            workersIn->workers[job->worker].busy--;
+            job->worker = -1;
+        }
+
+        int next = job->status == 0 ? advance_job(job, cacheIn, workersIn) : -1;
+        free(job->log);
+        job->log = NULL;
+
+        // The worker slot stays busy with the next phase of the same job.
+        if (next == 1)
+            continue;
+        slots[job->slot] = 0;
+        running--;
+
+        if (next != 0) {
+            job->state = JOB_FAILED;
+            fprintf(stderr, "Command failed: %s\n",
+                    job->phase == PHASE_PREPROCESS ? job->preprocess : job->command);
+            failed++;
+            continue;
+        }
+
+        job->state = JOB_DONE;
+        for (int i = 0; i < job->dependentCount; i++) {
+            Job *dependent = &planIn->jobs[job->dependents[i]];
+            if (--dependent->pendingDeps == 0) {
+                dependent->state = JOB_READY;
+                dependent->readyAt = job->finishedAt;
+                ready[readyTail++] = job->dependents[i];
+            }
+        }
+    }
+
+    planIn->finishedAt = now_ns();
+
+    free(slots);
+    free(ready);
+    return failed;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Appends a string as a JSON string literal, with quotes, backslashes and control characters escaped.
+ *
+ * @param char **destIn         - The string to append to, allocated with append_format.
+ * @param const char *textIn    - The string.
+ * -------------------------------------------------------------------------------------------------------- */
+void append_json_string(char **destIn, const char *textIn) {
+    append_format(destIn, "\"");
+    for (const unsigned char *p = (const unsigned char *)textIn; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            append_format(destIn, "\\%c", *p);
+        else if (*p < 0x20)
+            append_format(destIn, "\\u%04x", *p);
+        else
+            append_format(destIn, "%c", *p);
+    }
+    append_format(destIn, "\"");
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes a string as a JSON string literal, with quotes, backslashes and control characters escaped.
+ *
+ * @param FILE *fileIn          - The file to write to.
+ * @param const char *textIn    - The string.
+ * -------------------------------------------------------------------------------------------------------- */
+void write_json_string(FILE *fileIn, const char *textIn) {
+    char *json = NULL;
+    append_json_string(&json, textIn);
+    fputs(json, fileIn);
+    free(json);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Names the step a job performs: the translation unit of a compile job, the artifact of a link job.
+ * -------------------------------------------------------------------------------------------------------- */
+const char *job_name(Job *jobIn) {
+    return jobIn->source != NULL ? jobIn->source : jobIn->output;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes the timing of an executed plan as a Chrome trace (chrome://tracing, Perfetto, speedscope). Every
+ * worker slot is one lane with the preprocess, compile and link commands that ran in it. The time a job
+ * waited in the ready queue for a free worker is an async "queue" slice of its own, so a build that is
+ * starved for cores shows up as long queue slices.
+ *
+ * @param BuildPlan *planIn     - The executed plan.
+ * @param const char *pathIn    - The trace file.
+ * @return int                  - 0 on success, -1 if the file can't be written.
+ * -------------------------------------------------------------------------------------------------------- */
+int write_trace(BuildPlan *planIn, const char *pathIn) {
+    FILE *file = fopen(pathIn, "w");
+    if (file == NULL) {
+        perror(pathIn);
+        return -1;
+    }
+
+    const char *phases[] = { "link", "preprocess", "compile", "remote compile" };
+    int first = 1;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int i = 0; i < planIn->eventCount; i++) {
+        TraceEvent *event = &planIn->events[i];
+        Job *job = &planIn->jobs[event->job];
+        const char *category = phases[event->phase];
+        if (event->phase == PHASE_COMMAND && job->source != NULL)
+            category = "compile";
+
+        fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        write_json_string(file, job_name(job));
+        fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"status\":%d}}", category, event->slot + 1,
+                (event->start - planIn->startedAt) / 1000.0, (event->end - event->start) / 1000.0,
+                job->status);
+        first = 0;
+    }
+
+    // The time between entering the ready queue and getting a worker.
+    for (int i = 0; i < planIn->count; i++) {
+        Job *job = &planIn->jobs[i];
+        if (job->startedAt == 0)
+            continue;
+        for (int edge = 0; edge < 2; edge++) {
+            fprintf(file, ",\n{\"name\":");
+            write_json_string(file, job_name(job));
+            fprintf(file, ",\"cat\":\"queue\",\"ph\":\"%c\",\"id\":%d,\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+                    edge ? 'e' : 'b', i,
+                    ((edge ? job->startedAt : job->readyAt) - planIn->startedAt) / 1000.0);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    printf("pmake: trace written to %s\n", pathIn);
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Prints the slowest steps of an executed plan, sorted by the time their commands ran, together with the
+ * time they waited for a worker.
+ *
+ * @param BuildPlan *planIn - The executed plan.
+ * @param int countIn       - The number of steps to print.
+ * -------------------------------------------------------------------------------------------------------- */
+void print_slowest(BuildPlan *planIn, int countIn) {
+    int *order = malloc(sizeof(int) * (planIn->count + 1));
+    int n = 0;
+
+    for (int i = 0; i < planIn->count; i++)
+        if (planIn->jobs[i].startedAt != 0)
+            order[n++] = i;
+
+    // Insertion sort by run time, the list is short and mostly printed once.
+    for (int i = 1; i < n; i++) {
+        int job = order[i], j = i;
+        long long time = planIn->jobs[job].finishedAt - planIn->jobs[job].startedAt;
+        while (j > 0 && planIn->jobs[order[j - 1]].finishedAt - planIn->jobs[order[j - 1]].startedAt < time) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = job;
+    }
+
+    printf("\nSlowest %d of %d step(s), wall time %.3f s:\n", n < countIn ? n : countIn, n,
+           (planIn->finishedAt - planIn->startedAt) / 1e9);
+    for (int i = 0; i < n && i < countIn; i++) {
+        Job *job = &planIn->jobs[order[i]];
+        printf("  %8.3f s  queued %7.3f s  %-7s %s\n", (job->finishedAt - job->startedAt) / 1e9,
+               (job->startedAt - job->readyAt) / 1e9, job->kind, job_name(job));
+    }
+
+    free(order);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Prints a plan without running it: every job with its index, what it does, why it is needed and the jobs
+ * it waits for.
+ *
+ * @param BuildPlan *planIn - The plan.
+ * @param int unitsIn       - The number of translation units the plan was made for.
+ * -------------------------------------------------------------------------------------------------------- */
+void print_plan(BuildPlan *planIn, int unitsIn) {
+    printf("Dry run: %d job(s) for %d translation unit(s).\n", planIn->count, unitsIn);
+
+    for (int i = 0; i < planIn->count; i++) {
+        Job *job = &planIn->jobs[i];
+        printf("  [%d] %-7s %s (%s)", i, job->kind, job_name(job), job->reason ? job->reason : "");
+
+        // The jobs only know their dependents, the prerequisites are found the other way round.
+        int first = 1;
+        for (int j = 0; j < i; j++) {
+            for (int d = 0; d < planIn->jobs[j].dependentCount; d++) {
+                if (planIn->jobs[j].dependents[d] == i) {
+                    printf("%s%d", first ? " after " : ",", j);
+                    first = 0;
+                }
+            }
+        }
+        printf("\n");
+    }
+}
+
+/* ****************************************END JOB SCHEDULER*********************************************** */
+
+/* --------------------------------------------------------------------------------------------------------
+ * A Target is one project= block of a makefile. Directives above the first project= line are defaults
+ * every target starts with, directives below a project= line belong to that target until the next
+ * project= line. A makefile with a single project therefore reads exactly as before. With deps= a
+ * target names the projects of the same makefile that have to be built before it is linked.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    const char *comp;       // The compiler.
+    const char *cflags;     // The compiler flags.
+    const char *target;     // exec, shared or obj.
+    const char *project;    // The project name, also the name of the artifact.
+    const char *src;        // The source files, glob patterns like md4c/*.c are expanded while planning.
+    const char *libs;       // Libraries, objects and further sources.
+    const char *deps;       // Projects of the same makefile this target depends on.
+    const char *unity;      // yes to compile the sources in batched unity translation units.
+    const char *profile;    // The build profile: debug, release, lto or pgo.
+    const char *train;      // The training command of profile=pgo.
+    const char *pch;        // The header to precompile for every unit, for example Samael.h.
+
+    struct Project *owner;  // The makefile the target comes from.
+    int *depList;           // Workspace positions of all targets this target depends on.
+    int depCount;           // Number of entries in depList.
+    char *output;           // The artifact, set while planning.
+    char *fingerprint;      // All link inputs including the artifacts of deps, set while planning.
+    int firstJob;           // The first job of this target in the plan.
+    int lastJob;            // One past the last job of this target in the plan.
+    int linkJob;            // The job producing the artifact, -1 if the artifact is up to date.
+    int linkRecord;         // The build state record of the artifact, -1 without a link step.
+    int mark;               // Visit mark of the topological sort.
+} Target;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A Project is one makefile with its targets and its build state. All paths inside a makefile are
+ * relative to the directory of the makefile, so pmake changes into that directory whenever it plans,
+ * runs or records anything of the project.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct Project {
+    char *makefile;         // The makefile as it was given or found.
+    char *name;             // The file name of the makefile, relative to directory.
+    char *directory;        // The absolute directory of the makefile.
+    Target *targets;        // The targets of the makefile.
+    int count;              // Number of targets.
+    BuildState state;       // The build state of the makefile.
+    char *statePath;        // The state file, relative to directory.
+    char *compileCommands;  // The entries of compile_commands.json, collected while planning.
+    FileStamp makefileStamp;    // The stamp of the makefile when it was read.
+    int loaded;             // 1 once the state file was read, a build server keeps the state in memory.
+    Arena arena;            // Holds the values of the makefile.
+} Project;
+
+/* --------------------------------------------------------------------------------------------------------
+ * A Workspace is everything one pmake run builds: a single makefile or every makefile of a directory
+ * tree. The targets of all projects are additionally listed in one array, the dependency graph and the
+ * build order work on positions in this array.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    Project *projects;      // All makefiles.
+    int projectCount;       // Number of makefiles.
+    Target **targets;       // All targets of all makefiles.
+    int targetCount;        // Number of targets.
+} Workspace;
+
+/* --------------------------------------------------------------------------------------------------------
+ * BuildOptions are the command line options that shape a run: how many jobs run in parallel, whether a
+ * failure stops the build, the compilation cache and what is reported about the timing afterwards.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    int maxJobs;                // The maximum number of jobs running at the same time (-j).
+    int keepGoing;              // 1 to build everything that doesn't depend on a failure.
+    CompilationCache *cache;    // The compilation cache, NULL if caching is off (--no-cache).
+    const char *trace;          // The Chrome trace file to write, NULL for none (--trace).
+    int slowest;                // The number of slowest steps to print, 0 for none (--slowest).
+    int dryRun;                 // 1 to print the plan with the reason of every job instead of running it.
+    WorkerPool *workers;        // The remote workers compiles are shipped to, NULL for none (--workers).
+} BuildOptions;
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the field of a target a directive sets.
+ *
+ * @param Target *targetIn  - The target.
+ * @param StringView keyIn  - The name of the directive, like src or cflags.
+ * @return const char**     - The field, NULL for an unknown directive.
+ * -------------------------------------------------------------------------------------------------------- */
+const char **target_field(Target *targetIn, StringView keyIn) {
+    struct { const char *key; const char **field; } fields[] = {
+        { "comp", &targetIn->comp },       { "cflags", &targetIn->cflags },   { "target", &targetIn->target },
+        { "src", &targetIn->src },         { "libs", &targetIn->libs },       { "deps", &targetIn->deps },
+        { "unity", &targetIn->unity },     { "profile", &targetIn->profile }, { "train", &targetIn->train },
+        { "pch", &targetIn->pch },
+    };
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        if (strlen(fields[i].key) == keyIn.length && strncmp(fields[i].key, keyIn.data, keyIn.length) == 0)
+            return fields[i].field;
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Stores the collected value of a directive in its field. The pieces are the value of the directive line
+ * and its continuation lines.
+ *
+ * @param Arena *arenaIn        - The arena of the project.
+ * @param const char **fieldIn  - The field, NULL if there is no directive to finish.
+ * @param int appendIn          - 1 to append to the value the field already has, for libs=.
+ * @param StringView *piecesIn  - The pieces of the value.
+ * @param int countIn           - The number of pieces.
+ * -------------------------------------------------------------------------------------------------------- */
+void set_field(Arena *arenaIn, const char **fieldIn, int appendIn, StringView *piecesIn, int countIn) {
+    if (fieldIn == NULL)
+        return;
+
+    const char *value = arena_join(arenaIn, piecesIn, countIn);
+    if (appendIn && (*fieldIn)[0] != '\0' && value[0] != '\0') {
+        StringView both[2] = { { *fieldIn, strlen(*fieldIn) }, { value, strlen(value) } };
+        value = arena_join(arenaIn, both, 2);
+    } else if (appendIn && value[0] == '\0') {
+        value = *fieldIn;
+    }
+    *fieldIn = value;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads a makefile into its targets. The file is mapped and cut into string views, only the final values
+ * are copied, once, into the arena of the project. A value has no length limit and continues on every
+ * following line that doesn't start a directive of its own, a trailing backslash is allowed but not
+ * needed. Comments and empty lines are skipped. libs= adds to the libraries of the defaults, every other
+ * directive replaces the value.
+ *
+ * @param const char *filename  - The makefile.
+ * @param Arena *arenaIn        - The arena the values are stored in.
+ * @param Target **targetsOut   - Receives the targets.
+ * @param int *countOut         - Receives the number of targets.
+ * @return int                  - 0 on success, -1 if the makefile can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int parse_makefile(const char *filename, Arena *arenaIn, Target **targetsOut, int *countOut) {
+    size_t size = 0;
+    const char *text = map_file(filename, &size);
+    if (text == NULL) {
+        perror(filename);
+        return -1;
+    }
+
+    Target defaults = {0};
+    defaults.comp = "gcc";
+    defaults.target = "exec";
+    defaults.cflags = defaults.project = defaults.src = defaults.libs = defaults.deps = "";
+    defaults.unity = defaults.profile = defaults.train = defaults.pch = "";
+
+    Target *targets = NULL;
+    Target *current = &defaults;
+    int count = 0;
+
+    // The directive whose value is being collected.
+    const char **field = NULL;
+    int append = 0;
+    StringView *pieces = NULL;
+    int pieceCount = 0, pieceCapacity = 0;
+
+    const char *end = text + size;
+    int lineNumber = 0;
+    for (const char *p = text; p < end; ) {
+        const char *newline = memchr(p, '\n', end - p);
+        StringView line = { p, (newline ? newline : end) - p };
+        p = newline ? newline + 1 : end;
+        lineNumber++;
+
+        // Trim blanks on both ends, then skip empty lines and comments.
+        while (line.length > 0 && isspace((unsigned char)line.data[line.length - 1]))
+            line.length--;
+        while (line.length > 0 && isspace((unsigned char)line.data[0])) {
+            line.data++;
+            line.length--;
+        }
+        if (line.length == 0 || line.data[0] == '#')
+            continue;
+
+        if (line.data[line.length - 1] == '\\') {
+            line.length--;
+            while (line.length > 0 && isspace((unsigned char)line.data[line.length - 1]))
+                line.length--;
+        }
+
+        // A directive is a name followed by '=', anything else continues the last directive.
+        const char *equals = memchr(line.data, '=', line.length);
+        StringView key = { line.data, equals ? (size_t)(equals - line.data) : 0 };
+        int isDirective = key.length > 0;
+        for (size_t i = 0; i < key.length; i++)
+            isDirective &= isalnum((unsigned char)key.data[i]) || key.data[i] == '_';
+
+        if (!isDirective) {
+            if (field == NULL) {
+                fprintf(stderr, "%s:%d: the line belongs to no directive, it is ignored.\n", filename, lineNumber);
+                continue;
+            }
+            if (pieceCount == pieceCapacity) {
+                pieceCapacity = pieceCapacity ? pieceCapacity * 2 : 16;
+                pieces = realloc(pieces, sizeof(StringView) * pieceCapacity);
+            }
+            pieces[pieceCount++] = line;
+            continue;
+        }
+
+        set_field(arenaIn, field, append, pieces, pieceCount);
+        field = NULL;
+        pieceCount = 0;
+
+        StringView value = { equals + 1, line.length - key.length - 1 };
+        while (value.length > 0 && isspace((unsigned char)value.data[0])) {
+            value.data++;
+            value.length--;
+        }
+
+        // A project line starts a new target, filled with the defaults.
+        if (key.length == 7 && strncmp(key.data, "project", 7) == 0) {
+            Target *grown = realloc(targets, sizeof(Target) * (count + 1));
+            if (grown == NULL) {
+                perror("realloc failed");
+                break;
+            }
+            targets = grown;
+            current = &targets[count++];
+            *current = defaults;
+            current->project = arena_join(arenaIn, &value, 1);
+            continue;
+        }
+
+        field = target_field(current, key);
+        if (field == NULL) {
+            fprintf(stderr, "%s:%d: unknown directive '%.*s', it is ignored.\n", filename, lineNumber,
+                    (int)key.length, key.data);
+            continue;
+        }
+
+        append = key.length == 4 && strncmp(key.data, "libs", 4) == 0;
+        if (value.length > 0) {
+            if (pieceCount == pieceCapacity) {
+                pieceCapacity = pieceCapacity ? pieceCapacity * 2 : 16;
+                pieces = realloc(pieces, sizeof(StringView) * pieceCapacity);
+            }
+            pieces[pieceCount++] = value;
+        }
+    }
+    set_field(arenaIn, field, append, pieces, pieceCount);
+
+    free(pieces);
+    unmap_file(text, size);
+
+    *targetsOut = targets;
+    *countOut = count;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Joins a directory and a path and resolves "." and ".." without touching the file system, so it works
+ * for artifacts that don't exist yet. Absolute paths are only normalized.
+ *
+ * @param const char *directoryIn   - An absolute directory.
+ * @param const char *pathIn        - A path relative to it, or an absolute path.
+ * @return char*                    - The absolute path, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *absolute_path(const char *directoryIn, const char *pathIn) {
+    char *joined = NULL;
+    if (pathIn[0] == '/' || pathIn[0] == '\\' || (pathIn[0] != '\0' && pathIn[1] == ':'))
+        append_format(&joined, "%s", pathIn);
+    else
+        append_format(&joined, "%s/%s", directoryIn, pathIn);
+
+    // Collect the components, dropping "." and resolving "..".
+    int count = 0;
+    char **parts = malloc(sizeof(char *) * (strlen(joined) / 2 + 2));
+    for (char *part = strtok(joined, "/\\"); part != NULL; part = strtok(NULL, "/\\")) {
+        if (strcmp(part, ".") == 0)
+            continue;
+        if (strcmp(part, "..") == 0) {
+            if (count > 0) count--;
+            continue;
+        }
+        parts[count++] = part;
+    }
+
+    char *result = NULL;
+    append_format(&result, "%s", (directoryIn[0] != '/' && directoryIn[1] == ':') ? "" : "/");
+    for (int i = 0; i < count; i++)
+        append_format(&result, "%s%s", parts[i], i + 1 < count ? "/" : "");
+
+    free(parts);
+    free(joined);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Changes into the directory of a project.
+ *
+ * @return int - 0 on success, -1 if the directory is gone.
+ * -------------------------------------------------------------------------------------------------------- */
+int enter_project(Project *projectIn) {
+    if (chdir(projectIn->directory) != 0) {
+        perror(projectIn->directory);
+        return -1;
+    }
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds a makefile to the workspace.
+ *
+ * @param Workspace *workspaceIn    - The workspace.
+ * @param const char *makefileIn    - The makefile, relative to the current directory or absolute.
+ * @return int                      - 0 on success, -1 if the makefile can't be read.
+ * -------------------------------------------------------------------------------------------------------- */
+int add_project(Workspace *workspaceIn, const char *makefileIn) {
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        perror("getcwd");
+        return -1;
+    }
+
+    Project project = {0};
+    if (parse_makefile(makefileIn, &project.arena, &project.targets, &project.count) != 0)
+        return -1;
+
+    char *path = absolute_path(cwd, makefileIn);
+    char *slash = strrchr(path, '/');
+    append_format(&project.makefile, "%s", makefileIn);
+    append_format(&project.name, "%s", slash + 1);
+    append_format(&project.directory, "%.*s", (int)(slash == path ? 1 : slash - path), path);
+    free(path);
+
+    project.statePath = state_path(project.name);
+    stamp_file(makefileIn, &project.makefileStamp);
+
+    Project *grown = realloc(workspaceIn->projects, sizeof(Project) * (workspaceIn->projectCount + 1));
+    if (grown == NULL) {
+        perror("realloc failed");
+        return -1;
+    }
+    workspaceIn->projects = grown;
+    workspaceIn->projects[workspaceIn->projectCount++] = project;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Lists the targets of all projects in one array once all makefiles are read, and computes the artifact
+ * of every target. From here on the projects array doesn't move anymore.
+ * -------------------------------------------------------------------------------------------------------- */
+void index_targets(Workspace *workspaceIn) {
+    for (int p = 0; p < workspaceIn->projectCount; p++) {
+        Project *project = &workspaceIn->projects[p];
+        for (int i = 0; i < project->count; i++) {
+            Target *t = &project->targets[i];
+            workspaceIn->targets = realloc(workspaceIn->targets, sizeof(Target *) * (workspaceIn->targetCount + 1));
+            workspaceIn->targets[workspaceIn->targetCount++] = t;
+            t->owner = project;
+            t->linkJob = -1;
+            t->linkRecord = -1;
+
+            // The final artifact, a .dll or .so for shared, .o for obj, otherwise the executable.
+            #ifdef _WIN32
+                // Windows version
+                if(t->target[0] == 's')
+                    append_format(&t->output, "%s.dll", t->project);
+                else if(t->target[0] == 'o')
+                    append_format(&t->output, "%s.o", t->project);
+                else
+                    append_format(&t->output, "%s", t->project);
+            #else
+                // Unix version
+                if(t->target[0] == 's')
+                    append_format(&t->output, "%s.so", t->project);
+                else if(t->target[0] == 'o')
+                    append_format(&t->output, "%s.o", t->project);
+                else
+                    append_format(&t->output, "%s", t->project);
+            #endif
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Releases all memory of a workspace.
+ * -------------------------------------------------------------------------------------------------------- */
+void free_workspace(Workspace *workspaceIn) {
+    for (int p = 0; p < workspaceIn->projectCount; p++) {
+        Project *project = &workspaceIn->projects[p];
+        for (int i = 0; i < project->count; i++) {
+            free(project->targets[i].depList);
+            free(project->targets[i].output);
+            free(project->targets[i].fingerprint);
+        }
+        free(project->targets);
+        free_arena(&project->arena);
+        free_state(&project->state);
+        free(project->statePath);
+        free(project->compileCommands);
+        free(project->makefile);
+        free(project->name);
+        free(project->directory);
+    }
+    free(workspaceIn->projects);
+    free(workspaceIn->targets);
+    memset(workspaceIn, 0, sizeof(Workspace));
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Records that a target depends on another one, ignoring duplicates.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_target_dependency(Target *targetIn, int dependencyIn) {
+    for (int i = 0; i < targetIn->depCount; i++)
+        if (targetIn->depList[i] == dependencyIn)
+            return;
+    targetIn->depList = realloc(targetIn->depList, sizeof(int) * (targetIn->depCount + 1));
+    targetIn->depList[targetIn->depCount++] = dependencyIn;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Finds the target that produces a file. libSamael for example is produced by the target with the
+ * artifact .../mylibs/bin/libSamael.so, its absolute path is compared with the absolute artifacts of all
+ * targets.
+ *
+ * @return int - The workspace position of the producing target, or -1.
+ * -------------------------------------------------------------------------------------------------------- */
+int find_producer(Workspace *workspaceIn, const char *absoluteIn) {
+    for (int i = 0; i < workspaceIn->targetCount; i++) {
+        Target *t = workspaceIn->targets[i];
+        char *output = absolute_path(t->owner->directory, t->output);
+        int match = strcmp(output, absoluteIn) == 0;
+        free(output);
+        if (match)
+            return i;
+    }
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the dependency graph of the workspace. deps= names are looked up in the same makefile. With
+ * inferIn the link inputs are followed across makefiles as well: an object or library named directly in
+ * libs= and every lib<name> of a -l<name> found in one of the -L directories of cflags= or libs= makes
+ * the target depend on the project that produces that file. Sources like ../mylibs/ToolBox/cProgress.c
+ * are compiled by the project that lists them and need no ordering.
+ *
+ * @param Workspace *workspaceIn    - The workspace.
+ * @param int inferIn               - 1 to infer dependencies between makefiles from the link inputs.
+ * @return int                      - 0 on success, -1 on an unknown deps= name.
+ * -------------------------------------------------------------------------------------------------------- */
+int resolve_dependencies(Workspace *workspaceIn, int inferIn) {
+    int result = 0;
+
+    for (int i = 0; i < workspaceIn->targetCount; i++) {
+        Target *t = workspaceIn->targets[i];
+
+        char *deps = NULL;
+        int depCount = 0;
+        append_format(&deps, "%s", t->deps);
+        char **depList = split_words(deps, &depCount);
+
+        for (int d = 0; d < depCount; d++) {
+            int found = -1;
+            for (int j = 0; j < workspaceIn->targetCount && found < 0; j++)
+                if (workspaceIn->targets[j]->owner == t->owner &&
+                    strcmp(workspaceIn->targets[j]->project, depList[d]) == 0)
+                    found = j;
+
+            if (found < 0) {
+                fprintf(stderr, "pmake: '%s' depends on unknown project '%s'.\n", t->project, depList[d]);
+                result = -1;
+            } else {
+                add_target_dependency(t, found);
+            }
+        }
+        free(depList);
+        free(deps);
+
+        if (!inferIn)
+            continue;
+
+        char *words = NULL;
+        int wordCount = 0;
+        append_format(&words, "%s %s", t->cflags, t->libs);
+        char **wordList = split_words(words, &wordCount);
+
+        for (int w = 0; w < wordCount; w++) {
+            char *word = wordList[w];
+            if (word[0] == '-' || is_source_file(word))
+                continue;
+            char *path = absolute_path(t->owner->directory, word);
+            int producer = find_producer(workspaceIn, path);
+            if (producer >= 0 && producer != i)
+                add_target_dependency(t, producer);
+            free(path);
+        }
+
+        for (int w = 0; w < wordCount; w++) {
+            if (strncmp(wordList[w], "-l", 2) != 0)
+                continue;
+            for (int l = 0; l < wordCount; l++) {
+                if (strncmp(wordList[l], "-L", 2) != 0)
+                    continue;
+                const char *suffixes[] = { ".so", ".dll", ".a" };
+                for (int s = 0; s < 3; s++) {
+                    char *library = NULL;
+                    append_format(&library, "%s/lib%s%s", wordList[l] + 2, wordList[w] + 2, suffixes[s]);
+                    char *path = absolute_path(t->owner->directory, library);
+                    int producer = find_producer(workspaceIn, path);
+                    if (producer >= 0 && producer != i)
+                        add_target_dependency(t, producer);
+                    free(path);
+                    free(library);
+                }
+            }
+        }
+
+        free(wordList);
+        free(words);
+    }
+
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Appends a target and, first, everything it depends on to the build order (depth first search). A target
+ * reached again while it is still being visited closes a cycle.
+ *
+ * @param Workspace *workspaceIn    - The workspace.
+ * @param int targetIn              - Workspace position of the target to add.
+ * @param int *orderOut             - The build order.
+ * @param int *orderCount           - Number of targets in the build order.
+ * @return int                      - 0 on success, -1 on a cycle.
+ * -------------------------------------------------------------------------------------------------------- */
+int order_target(Workspace *workspaceIn, int targetIn, int *orderOut, int *orderCount) {
+    Target *target = workspaceIn->targets[targetIn];
+
+    if (target->mark == 2)
+        return 0;
+    if (target->mark == 1) {
+        fprintf(stderr, "pmake: dependency cycle through '%s'.\n", target->project);
+        return -1;
+    }
+    target->mark = 1;
+
+    for (int i = 0; i < target->depCount; i++)
+        if (order_target(workspaceIn, target->depList[i], orderOut, orderCount) != 0)
+            return -1;
+
+    target->mark = 2;
+    orderOut[(*orderCount)++] = targetIn;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Replaces the translation units of a target by unity translation units. The sources are grouped by their
+ * extension, every group is split into at most batchesIn batches of consecutive files and every batch
+ * becomes a file unity<N>.<ext> in the build directory that does nothing but #include its sources. This
+ * way the compiler starts and parses the common headers once per batch instead of once per file, while
+ * the batches still compile in parallel. Words that are no sources keep their position, the unity files
+ * take the position of the first source.
+ *
+ * @param const char *buildDirIn    - The build directory of the target.
+ * @param char **wordsIn            - The words of src= and libs=.
+ * @param int countIn               - Number of words.
+ * @param int batchesIn             - The maximum number of batches per extension.
+ * @return char*                    - The new words separated by spaces, the caller frees them.
+ * -------------------------------------------------------------------------------------------------------- */
+char *unity_words(const char *buildDirIn, char **wordsIn, int countIn, int batchesIn) {
+
+    // The sources are relative to the makefile, the unity files live in the build directory.
+    char *up = NULL;
+    append_format(&up, "../");
+    for (const char *p = buildDirIn; *p; p++)
+        if (*p == '/' || *p == '\\')
+            append_format(&up, "../");
+
+    char *result = NULL;
+    int placed = 0, number = 0;
+
+    for (int i = 0; i < countIn; i++) {
+        if (!is_source_file(wordsIn[i])) {
+            append_format(&result, "%s ", wordsIn[i]);
+            continue;
+        }
+        if (placed)
+            continue;
+        placed = 1;
+
+        for (int j = i; j < countIn; j++) {
+            if (!is_source_file(wordsIn[j]))
+                continue;
+            const char *extension = strrchr(wordsIn[j], '.');
+
+            // Every extension is handled once, at its first source.
+            int seen = 0;
+            for (int k = i; k < j && !seen; k++)
+                seen = is_source_file(wordsIn[k]) && strcmp(strrchr(wordsIn[k], '.'), extension) == 0;
+            if (seen)
+                continue;
+
+            int members = 0;
+            for (int k = j; k < countIn; k++)
+                members += is_source_file(wordsIn[k]) && strcmp(strrchr(wordsIn[k], '.'), extension) == 0;
+
+            int batches = members < batchesIn ? members : batchesIn;
+            int perBatch = (members + batches - 1) / batches;
+            int member = 0;
+            char *content = NULL;
+
+            for (int k = j; k < countIn; k++) {
+                if (!is_source_file(wordsIn[k]) || strcmp(strrchr(wordsIn[k], '.'), extension) != 0)
+                    continue;
+
+                if (content == NULL)
+                    append_format(&content, "/* Generated by pmake, unity translation unit. */\n");
+                if (wordsIn[k][0] == '/' || wordsIn[k][0] == '\\' || wordsIn[k][1] == ':')
+                    append_format(&content, "#include \"%s\"\n", wordsIn[k]);
+                else
+                    append_format(&content, "#include \"%s%s\"\n", up, wordsIn[k]);
+
+                if (++member % perBatch == 0 || member == members) {
+                    char *path = NULL;
+                    append_format(&path, "%s/unity%d%s", buildDirIn, ++number, extension);
+                    write_if_changed(path, content);
+                    append_format(&result, "%s ", path);
+                    free(path);
+                    free(content);
+                    content = NULL;
+                }
+            }
+        }
+    }
+
+    free(up);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Returns the optimization flags of a named build profile, used for compiling and linking.
+ *
+ * @param const char *profileIn - debug, release, lto or pgo. Empty for no profile.
+ * @return const char*          - The flags followed by a space, "" without a profile, NULL if unknown.
+ * -------------------------------------------------------------------------------------------------------- */
+const char *profile_flags(const char *profileIn) {
+    if (profileIn[0] == '\0')
+        return "";
+    if (strcmp(profileIn, "debug") == 0)
+        return "-O0 -g ";
+    if (strcmp(profileIn, "release") == 0 || strcmp(profileIn, "pgo") == 0)
+        return "-O2 -DNDEBUG ";
+    if (strcmp(profileIn, "lto") == 0)
+        return "-O2 -DNDEBUG -flto ";
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Removes all files of a directory, the directory itself stays. Used to throw away the profile data of
+ * an earlier training run before a new one starts.
+ *
+ * @param const char *directoryIn - The directory.
+ * -------------------------------------------------------------------------------------------------------- */
+void clear_directory(const char *directoryIn) {
+    DIR *dir = opendir(directoryIn);
+    if (dir == NULL)
+        return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        char *path = NULL;
+        append_format(&path, "%s/%s", directoryIn, entry->d_name);
+        remove(path);
+        free(path);
+    }
+
+    closedir(dir);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds a job running in the directory of a target, with the link jobs of the target's dependencies as
+ * prerequisites.
+ *
+ * @param BuildPlan *planIn         - The plan the job is added to.
+ * @param Workspace *workspaceIn    - The workspace.
+ * @param Target *targetIn          - The target the job belongs to.
+ * @param char *commandIn           - The command, the plan takes ownership.
+ * @param const char *outputIn      - The file or directory the command produces.
+ * @return int                      - The index of the new job.
+ * -------------------------------------------------------------------------------------------------------- */
+int add_target_job(BuildPlan *planIn, Workspace *workspaceIn, Target *targetIn, char *commandIn,
+                   const char *outputIn) {
+    char *output = NULL;
+    append_format(&output, "%s", outputIn);
+
+    int job = add_job(planIn, commandIn, output);
+    append_format(&planIn->jobs[job].directory, "%s", targetIn->owner->directory);
+
+    for (int i = 0; i < targetIn->depCount; i++) {
+        Target *dep = workspaceIn->targets[targetIn->depList[i]];
+        if (dep->linkJob >= 0)
+            add_dependency(planIn, job, dep->linkJob);
+    }
+    return job;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds the entry of one translation unit to the compile_commands.json of its project, for clangd,
+ * clang-tidy and friends.
+ *
+ * @param Project *projectIn    - The project of the target.
+ * @param const char *fileIn    - The source, relative to the makefile.
+ * @param const char *objectIn  - Its object.
+ * @param const char *commandIn - The command that compiles it.
+ * -------------------------------------------------------------------------------------------------------- */
+void add_compile_command(Project *projectIn, const char *fileIn, const char *objectIn, const char *commandIn) {
+    append_format(&projectIn->compileCommands, "%s  {\"directory\": ", projectIn->compileCommands ? ",\n" : "");
+    append_json_string(&projectIn->compileCommands, projectIn->directory);
+    append_format(&projectIn->compileCommands, ", \"file\": ");
+    append_json_string(&projectIn->compileCommands, fileIn);
+    append_format(&projectIn->compileCommands, ", \"output\": ");
+    append_json_string(&projectIn->compileCommands, objectIn);
+    append_format(&projectIn->compileCommands, ", \"command\": ");
+    append_json_string(&projectIn->compileCommands, commandIn);
+    append_format(&projectIn->compileCommands, "}");
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Adds the jobs of one target to the build plan: one compile job per translation unit whose object is
+ * out of date and a link job if the artifact has to be linked again. The link job waits for the compile
+ * jobs of its own target and for the link jobs of the targets it depends on. Compile jobs don't wait for
+ * anything, so independent work of all targets runs in parallel. The caller has already changed into the
+ * directory of the target's makefile.
+ *
+ * With profile=pgo and anything out of date the target is built twice in one chain of jobs: all units
+ * are compiled and linked with instrumentation, the train= command runs the instrumented artifact, and
+ * all units are compiled again into the same objects using the collected profile. The profile data
+ * doesn't show up in the preprocessed source, so these jobs bypass the compilation cache.
+ *
+ * Every job gets the reason it is in the plan, and every source an entry for the project's
+ * compile_commands.json, whether it is compiled or not and also when unity=yes batches it.
+ *
+ * @param BuildPlan *planIn         - The plan the jobs are added to.
+ * @param Workspace *workspaceIn    - The workspace, the dependencies of the target are already planned.
+ * @param int targetIn              - Workspace position of the target to plan.
+ * @param BuildOptions *optionsIn   - The options of the run.
+ * @param int *unitsOut             - Incremented by the number of translation units of the target.
+ * -------------------------------------------------------------------------------------------------------- */
+void plan_target(BuildPlan *planIn, Workspace *workspaceIn, int targetIn, BuildOptions *optionsIn,
+                 int *unitsOut) {
+
+    Target *t = workspaceIn->targets[targetIn];
+    BuildState *stateIn = &t->owner->state;
+    CompilationCache *cacheIn = optionsIn->cache;
+    t->firstJob = planIn->count;
+
+    // Step 1: Collect all words of src= (or <project>.c) and libs= in their original order.
+    char *words = NULL;
+    if(t->src[0] != '\0')
+        append_format(&words, "%s ", t->src);
+    else
+        append_format(&words, "%s.c ", t->project);
+
+    append_format(&words, "%s", t->libs);
+    words = expand_globs(stateIn, words, t->project);
+
+    // Step 2: The common part of every compile command, the compiler, the flags of the profile
+    // and the flags of the makefile.
+    const char *profile = profile_flags(t->profile);
+    if (profile == NULL) {
+        fprintf(stderr, "pmake: '%s' has an unknown profile '%s', it is ignored.\n", t->project, t->profile);
+        profile = "";
+    }
+    int pgo = strcmp(t->profile, "pgo") == 0;
+
+    char *compile = NULL;
+    append_format(&compile, "%s %s", t->comp, profile);
+    if(t->cflags[0] != '\0')
+        append_format(&compile, "%s ", t->cflags);
+#ifndef _WIN32
+    // Objects going into a shared library must be position independent.
+    if(t->target[0] == 's')
+        append_format(&compile, "-fPIC ");
+#endif
+
+    // Step 3: One unit per translation unit, everything else goes to the linker. An object
+    // target made of a single translation unit needs no link step, that unit is compiled
+    // straight into the output file.
+    char *buildDir = build_directory(t->owner->name, t->project);
+    char *linkInputs = NULL;
+    int units = 0;
+
+    int wordCount = 0;
+    char **wordList = split_words(words, &wordCount);
+
+    for (int i = 0; i < wordCount; i++)
+        units += is_source_file(wordList[i]);
+
+    int linkStep = !(t->target[0] == 'o' && units == 1);
+
+    make_directories(buildDir);
+
+    // With unity=yes the sources are compiled in one batch per core instead of one by one. The words of
+    // the makefile are kept for compile_commands.json, which lists the real sources.
+    char *plainWords = NULL;
+    char **plainList = NULL;
+    int plainCount = 0;
+    if (strcmp(t->unity, "yes") == 0 && linkStep && units > 1) {
+        plainWords = words;
+        plainList = wordList;
+        plainCount = wordCount;
+        words = unity_words(buildDir, wordList, wordCount, default_job_count());
+        wordList = split_words(words, &wordCount);
+    }
+
+    // PGO keeps its profile data in the build directory. The path is absolute, because the
+    // instrumented program writes it from whatever directory the training runs in.
+    int clang = strstr(t->comp, "clang") != NULL;
+    char *profileDir = NULL;
+    char *useFlags = NULL;
+    if (pgo) {
+        char *relative = NULL;
+        append_format(&relative, "%s/pgo", buildDir);
+        profileDir = absolute_path(t->owner->directory, relative);
+        free(relative);
+
+        if (clang)
+            append_format(&useFlags, "-fprofile-use=%s/default.profdata ", profileDir);
+        else
+            append_format(&useFlags, "-fprofile-use=%s -Wno-missing-profile ", profileDir);
+        append_format(&compile, "%s", useFlags);
+    }
+
+    // With pch= the header is precompiled once per set of flags into .pmake/pch/<flags hash>/, from a
+    // stub that includes the real header. gcc finds the .gch next to the stub through -include and
+    // falls back to the stub if the .gch doesn't fit, clang is given the .pch with -include-pch. The
+    // preprocessor, and with it the cache and the remote workers, always sees the plain header.
+    char *pchInclude = NULL;
+    char *pchText = NULL;
+    char *pchCommand = NULL;
+    char *pchOutput = NULL;
+    const char *pchHeader = NULL;
+    int pchStale = STALE_NONE, pchRecord = -1;
+    if (t->pch[0] != '\0') {
+        const char *language = "c-header";
+        for (int i = 0; i < wordCount; i++)
+            if (is_source_file(wordList[i]) && strcmp(preprocessed_suffix(wordList[i]), ".ii") == 0)
+                language = "c++-header";
+
+        char *pchRoot = build_directory(t->owner->name, "pch");
+        char *pchDir = NULL, *stub = NULL, *content = NULL;
+        append_format(&pchDir, "%s/%08llx", pchRoot, hash_string(0, compile) & 0xffffffffULL);
+        const char *base = strrchr(t->pch, '/');
+        append_format(&stub, "%s/%s", pchDir, base ? base + 1 : t->pch);
+
+        char *header = absolute_path(t->owner->directory, t->pch);
+        append_format(&content, "/* Generated by pmake, precompiled header of %s. */\n#include \"%s\"\n",
+                      t->project, header);
+        make_directories(pchDir);
+        write_if_changed(stub, content);
+
+        append_format(&pchOutput, "%s%s", stub, clang ? ".pch" : ".gch");
+        append_format(&pchCommand, "%s-MMD -MF %s.d -x %s %s -o %s", compile, pchOutput, language, stub, pchOutput);
+        append_format(&pchText, "-include %s ", stub);
+        if (clang)
+            append_format(&pchInclude, "-include-pch %s ", pchOutput);
+        else
+            append_format(&pchInclude, "%s", pchText);
+
+        pchStale = needs_compile(stateIn, pchOutput, stub, pchCommand, &pchRecord, &pchHeader);
+
+        free(header);
+        free(content);
+        free(stub);
+        free(pchDir);
+        free(pchRoot);
+    }
+
+    char **objects = malloc(sizeof(char *) * (wordCount + 1));
+    char **sources = malloc(sizeof(char *) * (wordCount + 1));
+    char **commands = malloc(sizeof(char *) * (wordCount + 1));
+    int *records = malloc(sizeof(int) * (wordCount + 1));
+    int *stale = malloc(sizeof(int) * (wordCount + 1));
+    char **changed = malloc(sizeof(char *) * (wordCount + 1));
+    int unitCount = 0, compiles = 0;
+
+    for (int i = 0; i < wordCount; i++) {
+        char *word = wordList[i];
+
+        if (!is_source_file(word)) {
+            append_format(&linkInputs, "%s ", word);
+            continue;
+        }
+
+        char *object = NULL;
+        size_t buildDirLength = strlen(buildDir);
+        if (!linkStep)
+            append_format(&object, "%s", t->output);
+        else if (strncmp(word, buildDir, buildDirLength) == 0 && word[buildDirLength] == '/')
+            // A generated unity file, its object sits next to it.
+            append_format(&object, "%.*s.o", (int)(strrchr(word, '.') - word), word);
+        else
+            object = object_name(buildDir, word);
+
+        char *command = NULL;
+        append_format(&command, "%s%s-MMD -MF %s.d -c %s -o %s", compile, pchInclude ? pchInclude : "",
+                      object, word, object);
+        append_format(&linkInputs, "%s ", object);
+
+        if (plainList == NULL)
+            add_compile_command(t->owner, word, object, command);
+
+        const char *header = NULL;
+        objects[unitCount] = object;
+        sources[unitCount] = word;
+        commands[unitCount] = command;
+        stale[unitCount] = needs_compile(stateIn, object, word, command, &records[unitCount], &header);
+        changed[unitCount] = NULL;
+        if (header != NULL)
+            append_format(&changed[unitCount], "%s", header);
+        compiles += stale[unitCount] != STALE_NONE;
+        unitCount++;
+    }
+
+    // A unity build still gets one entry per source, with the flags its batch is compiled with.
+    for (int i = 0; i < plainCount; i++) {
+        if (!is_source_file(plainList[i]))
+            continue;
+        char *object = object_name(buildDir, plainList[i]);
+        char *command = NULL;
+        append_format(&command, "%s%s-MMD -MF %s.d -c %s -o %s", compile, pchInclude ? pchInclude : "",
+                      object, plainList[i], object);
+        add_compile_command(t->owner, plainList[i], object, command);
+        free(command);
+        free(object);
+    }
+
+    // The depfile of a unit compiled with a precompiled header doesn't list the headers that came from
+    // it, so a rebuilt precompiled header rebuilds every unit of the target.
+    for (int u = 0; u < unitCount && pchStale != STALE_NONE; u++) {
+        if (stale[u] == STALE_NONE) {
+            stale[u] = STALE_PCH;
+            compiles++;
+        }
+    }
+
+    // Step 4: The link command. It is only needed if an object is compiled, a dependency is
+    // linked again, the link command changed or a link input was touched since the last link.
+    char *linkHead = NULL;
+    char *linkCommand = NULL;
+    const char *linkReason = compiles > 0 ? "objects compiled" : NULL;
+
+    if (linkStep) {
+        int depLinked = 0;
+
+        if (t->target[0] == 'o')
+            append_format(&linkHead, "%s -r ", t->comp);
+        else {
+            append_format(&linkHead, "%s %s", t->comp, profile);
+            if(t->cflags[0] != '\0')
+                append_format(&linkHead, "%s ", t->cflags);
+            if(t->target[0] == 's')
+                append_format(&linkHead, "-shared ");
+        }
+        append_format(&linkCommand, "%s%s-o %s", linkHead, linkInputs ? linkInputs : "", t->output);
+
+        // The artifacts of the dependencies are part of the fingerprint.
+        append_format(&t->fingerprint, "%s", linkInputs ? linkInputs : "");
+        for (int i = 0; i < t->depCount; i++) {
+            Target *dep = workspaceIn->targets[t->depList[i]];
+            char *output = absolute_path(dep->owner->directory, dep->output);
+            append_format(&t->fingerprint, " %s", output);
+            depLinked |= (dep->linkJob >= 0);
+            free(output);
+        }
+
+        char *inputCopy = NULL;
+        int inputCount = 0;
+        append_format(&inputCopy, "%s", t->fingerprint);
+        char **inputList = split_words(inputCopy, &inputCount);
+
+        t->linkRecord = get_record(stateIn, 'L', t->output);
+        StateRecord *record = &stateIn->records[t->linkRecord];
+
+        if (linkReason == NULL && depLinked)
+            linkReason = "dependency linked";
+        if (linkReason == NULL && !record->valid)
+            linkReason = "not linked yet";
+        if (linkReason == NULL && !file_info(stateIn, t->output)->exists)
+            linkReason = "output missing";
+        if (linkReason == NULL && strcmp(record->command, linkCommand) != 0)
+            linkReason = "command changed";
+        if (linkReason == NULL && record->hash != fingerprint_inputs(inputList, inputCount))
+            linkReason = "link inputs changed";
+
+        if (linkReason != NULL) {
+            set_record_string(&record->command, linkCommand);
+            record->valid = 0;
+        }
+
+        free(inputList);
+        free(inputCopy);
+    }
+
+    // Step 5: The instrumented build and the training run. Every unit is compiled again, so
+    // the profile covers the whole artifact and every object is optimized with it.
+    int profileJob = -1;
+    if (pgo && linkReason != NULL) {
+        make_directories(profileDir);
+        if (!optionsIn->dryRun)
+            clear_directory(profileDir);
+
+        char *generate = NULL;
+        append_format(&generate, "-fprofile-generate=%s ", profileDir);
+
+        int firstInstrumented = planIn->count;
+        for (int u = 0; u < unitCount; u++) {
+            char *command = NULL;
+            append_format(&command, "%s %s", t->comp, profile);
+            if(t->cflags[0] != '\0')
+                append_format(&command, "%s ", t->cflags);
+#ifndef _WIN32
+            if(t->target[0] == 's')
+                append_format(&command, "-fPIC ");
+#endif
+            append_format(&command, "%s-c %s -o %s", generate, sources[u], objects[u]);
+            int job = add_target_job(planIn, workspaceIn, t, command, objects[u]);
+            append_format(&planIn->jobs[job].source, "%s", sources[u]);
+            append_format(&planIn->jobs[job].reason, "instrumented for pgo");
+            planIn->jobs[job].kind = "compile";
+        }
+
+        int instrumentedLink = -1;
+        if (linkStep) {
+            // The runtime of the instrumentation comes in with the flag.
+            char *command = NULL;
+            append_format(&command, "%s%s%s-o %s", linkHead, generate, linkInputs ? linkInputs : "", t->output);
+            instrumentedLink = add_target_job(planIn, workspaceIn, t, command, t->output);
+            append_format(&planIn->jobs[instrumentedLink].reason, "instrumented for pgo");
+            for (int i = firstInstrumented; i < instrumentedLink; i++)
+                add_dependency(planIn, instrumentedLink, i);
+        }
+
+        if (t->train[0] == '\0')
+            fprintf(stderr, "pmake: '%s' uses profile=pgo without train=, the profile stays empty.\n",
+                    t->project);
+
+        char *train = NULL;
+        append_format(&train, "%s", t->train[0] != '\0' ? t->train : "echo no training");
+        profileJob = add_target_job(planIn, workspaceIn, t, train, profileDir);
+        append_format(&planIn->jobs[profileJob].reason, "pgo training");
+        planIn->jobs[profileJob].kind = "run";
+        if (instrumentedLink >= 0)
+            add_dependency(planIn, profileJob, instrumentedLink);
+        else
+            for (int i = firstInstrumented; i < profileJob; i++)
+                add_dependency(planIn, profileJob, i);
+
+        // clang writes raw profiles that have to be merged into one .profdata file first.
+        if (clang) {
+            char *merge = NULL;
+#ifdef __APPLE__
+            append_format(&merge, "xcrun llvm-profdata merge -output=%s/default.profdata %s", profileDir, profileDir);
+#else
+            append_format(&merge, "llvm-profdata merge -output=%s/default.profdata %s", profileDir, profileDir);
+#endif
+            int mergeJob = add_target_job(planIn, workspaceIn, t, merge, profileDir);
+            append_format(&planIn->jobs[mergeJob].reason, "pgo profile merge");
+            planIn->jobs[mergeJob].kind = "run";
+            add_dependency(planIn, mergeJob, profileJob);
+            profileJob = mergeJob;
+        }
+
+        free(generate);
+
+        // Every unit is compiled again with the profile, not only the stale ones.
+        for (int u = 0; u < unitCount; u++) {
+            stateIn->records[records[u]].valid = 0;
+            if (stale[u] == STALE_NONE)
+                stale[u] = -1;
+        }
+    }
+
+    // Step 6: One compile job per stale unit. Units whose object is up to date according to the
+    // build state get no job at all.
+    int firstCompile = planIn->count;
+    unsigned long long compilerIdentity = cacheIn ? compiler_identity(t->comp) : 0;
+
+    // Targets of a makefile with the same flags and header share one precompiled header job.
+    int pchJob = -1;
+    if (pchStale != STALE_NONE) {
+        for (int i = 0; i < planIn->count && pchJob < 0; i++)
+            if (strcmp(planIn->jobs[i].output, pchOutput) == 0 && planIn->jobs[i].directory != NULL &&
+                strcmp(planIn->jobs[i].directory, t->owner->directory) == 0)
+                pchJob = i;
+
+        if (pchJob < 0) {
+            pchJob = add_job(planIn, pchCommand, pchOutput);
+            Job *job = &planIn->jobs[pchJob];
+            job->record = pchRecord;
+            job->kind = "pch";
+            append_format(&job->source, "%s", t->pch);
+            append_format(&job->directory, "%s", t->owner->directory);
+            switch (pchStale) {
+                case STALE_HEADER:  append_format(&job->reason, "header changed: %s", pchHeader); break;
+                case STALE_OUTPUT:  append_format(&job->reason, "precompiled header missing"); break;
+                case STALE_COMMAND: append_format(&job->reason, "command changed"); break;
+                case STALE_SOURCE:  append_format(&job->reason, "header changed: %s", t->pch); break;
+                default:            append_format(&job->reason, "not built yet"); break;
+            }
+            pchCommand = NULL;
+            pchOutput = NULL;
+        }
+    }
+
+    for (int u = 0; u < unitCount; u++) {
+        if (stale[u] == STALE_NONE) {
+            free(commands[u]);
+            free(objects[u]);
+            free(changed[u]);
+            continue;
+        }
+
+        int job = add_job(planIn, commands[u], objects[u]);
+        Job *compileJob = &planIn->jobs[job];
+        compileJob->record = records[u];
+        compileJob->kind = "compile";
+        append_format(&compileJob->source, "%s", sources[u]);
+        append_format(&compileJob->directory, "%s", t->owner->directory);
+
+        switch (stale[u]) {
+            case STALE_NEW:     append_format(&compileJob->reason, "not built yet"); break;
+            case STALE_OUTPUT:  append_format(&compileJob->reason, "object missing"); break;
+            case STALE_COMMAND: append_format(&compileJob->reason, "command changed"); break;
+            case STALE_SOURCE:  append_format(&compileJob->reason, "source changed"); break;
+            case STALE_HEADER:  append_format(&compileJob->reason, "header changed: %s", changed[u]); break;
+            case STALE_PCH:     append_format(&compileJob->reason, "precompiled header rebuilt"); break;
+            default:            append_format(&compileJob->reason, "optimized with the pgo profile"); break;
+        }
+        free(changed[u]);
+
+        if (pchJob >= 0)
+            add_dependency(planIn, job, pchJob);
+
+        if (profileJob >= 0) {
+            append_format(&compileJob->reason, "%s", stale[u] > 0 ? ", optimized with the pgo profile" : "");
+            add_dependency(planIn, job, profileJob);
+            continue;
+        }
+
+        // The preprocessor writes the depfile as well, so a cache hit still knows its headers.
+        append_format(&planIn->jobs[job].preprocess, "%s%s-MMD -MF %s.d -MT %s -E %s -o %s.i",
+                      compile, pchText ? pchText : "", objects[u], objects[u], sources[u], objects[u]);
+        append_format(&planIn->jobs[job].flags, "%s", compile);
+        planIn->jobs[job].cacheSalt = hash_string(compilerIdentity, compile);
+        // With debug information the object embeds the source path and the directory it was compiled in,
+        // so both become part of the key.
+        if (strstr(compile, "-g") != NULL) {
+            planIn->jobs[job].cacheSalt = hash_string(planIn->jobs[job].cacheSalt, t->owner->directory);
+            planIn->jobs[job].cacheSalt = hash_string(planIn->jobs[job].cacheSalt, sources[u]);
+        }
+
+        // Only the dry run asks the manifests, the real build learns it from the preprocessor anyway.
+        if (optionsIn->dryRun && cacheIn != NULL) {
+            unsigned long long manifest = manifest_key(planIn->jobs[job].cacheSalt, t->owner->directory,
+                                                       sources[u], stateIn->records[records[u]].hash);
+            if (cache_lookup_manifest(cacheIn, stateIn, manifest))
+                append_format(&planIn->jobs[job].reason, ", cache hit");
+        }
+    }
+
+    // Without a link step the only compile job produces the artifact.
+    if (!linkStep && planIn->count > firstCompile)
+        t->linkJob = planIn->count - 1;
+
+    // Step 7: The link job waits for the compile jobs and the link jobs of the dependencies.
+    if (linkStep && linkReason != NULL) {
+        t->linkJob = add_target_job(planIn, workspaceIn, t, linkCommand, t->output);
+        planIn->jobs[t->linkJob].record = t->linkRecord;
+        append_format(&planIn->jobs[t->linkJob].reason, "%s", linkReason);
+        linkCommand = NULL;
+
+        for (int i = firstCompile; i < t->linkJob; i++)
+            add_dependency(planIn, t->linkJob, i);
+        if (profileJob >= 0)
+            add_dependency(planIn, t->linkJob, profileJob);
+    }
+
+    t->lastJob = planIn->count;
+    *unitsOut += units;
+
+    free(objects);
+    free(sources);
+    free(commands);
+    free(records);
+    free(stale);
+    free(changed);
+    free(profileDir);
+    free(useFlags);
+    free(pchInclude);
+    free(pchText);
+    free(pchCommand);
+    free(pchOutput);
+    free(linkHead);
+    free(linkCommand);
+    free(buildDir);
+    free(linkInputs);
+    free(compile);
+    free(wordList);
+    free(words);
+    free(plainList);
+    free(plainWords);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Writes back what a run built into the build state of one project: finished records become valid,
+ * compile records get their headers from the depfiles and link records their new fingerprint. Compiles
+ * that went through the cache leave a manifest, so the next dry run can tell a cache hit up front.
+ *
+ * @param BuildPlan *planIn         - The executed plan.
+ * @param Project *projectIn        - The project, the caller has changed into its directory.
+ * @param CompilationCache *cacheIn - The compilation cache, NULL if caching is off.
+ * -------------------------------------------------------------------------------------------------------- */
+void record_project(BuildPlan *planIn, Project *projectIn, CompilationCache *cacheIn) {
+    BuildState *state = &projectIn->state;
+
+    for (int t = 0; t < projectIn->count; t++) {
+        Target *target = &projectIn->targets[t];
+
+        for (int i = target->firstJob; i < target->lastJob; i++) {
+            Job *job = &planIn->jobs[i];
+
+            // The file cache has to see what the job wrote, a build server keeps using it.
+            if (job->state == JOB_DONE || job->state == JOB_FAILED)
+                forget_file(state, job->output);
+
+            if (job->state != JOB_DONE || job->record < 0)
+                continue;
+            state->records[job->record].valid = 1;
+
+            if (state->records[job->record].type == 'O') {
+                char *depfile = NULL;
+                append_format(&depfile, "%s.d", job->output);
+                store_dependencies(state, job->record, depfile);
+                free(depfile);
+
+                if (cacheIn != NULL && job->cacheKey != 0) {
+                    StateRecord *record = &state->records[job->record];
+                    cache_store_manifest(cacheIn, manifest_key(job->cacheSalt, job->directory, job->source,
+                                         record->hash), job->cacheKey, record);
+                }
+            }
+        }
+
+        if (target->linkRecord < 0 || target->linkJob < 0 ||
+            planIn->jobs[target->linkJob].state != JOB_DONE)
+            continue;
+        char *inputCopy = NULL;
+        int inputCount = 0;
+        append_format(&inputCopy, "%s", target->fingerprint);
+        char **inputList = split_words(inputCopy, &inputCount);
+        state->records[target->linkRecord].hash = fingerprint_inputs(inputList, inputCount);
+        free(inputList);
+        free(inputCopy);
+    }
+
+    save_state(projectIn->statePath, state);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds a workspace: orders all targets, plans them project by project into one build plan, runs it on
+ * one shared pool of workers and records the results. With keepGoing a failing job only stops the jobs
+ * that depend on it, everything independent is still built, and a summary per target is printed.
+ *
+ * @param Workspace *workspaceIn    - The workspace with resolved dependencies.
+ * @param BuildOptions *optionsIn   - The options of the run.
+ * @return int                      - EXIT_SUCCESS if everything was built, EXIT_FAILURE otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int build_workspace(Workspace *workspaceIn, BuildOptions *optionsIn) {
+
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        perror("getcwd");
+        return EXIT_FAILURE;
+    }
+
+    // A build server builds the same workspace again and again, forget the last plan.
+    for (int i = 0; i < workspaceIn->targetCount; i++) {
+        Target *t = workspaceIn->targets[i];
+        free(t->fingerprint);
+        t->fingerprint = NULL;
+        t->linkJob = -1;
+        t->linkRecord = -1;
+        t->mark = 0;
+    }
+    for (int p = 0; p < workspaceIn->projectCount; p++) {
+        free(workspaceIn->projects[p].compileCommands);
+        workspaceIn->projects[p].compileCommands = NULL;
+    }
+
+    // Step 1: Order the targets so every target comes after its dependencies.
+    int *order = malloc(sizeof(int) * (workspaceIn->targetCount + 1));
+    int ordered = 0;
+    for (int i = 0; i < workspaceIn->targetCount; i++) {
+        if (order_target(workspaceIn, i, order, &ordered) != 0) {
+            free(order);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Step 2: Plan all targets into one build plan, each from the directory of its makefile.
+    BuildPlan plan = {0};
+    int units = 0;
+
+    for (int p = 0; p < workspaceIn->projectCount; p++) {
+        Project *project = &workspaceIn->projects[p];
+        if (!project->loaded && enter_project(project) == 0) {
+            load_state(project->statePath, &project->state);
+            project->loaded = 1;
+        }
+    }
+
+    for (int i = 0; i < ordered; i++) {
+        Target *t = workspaceIn->targets[order[i]];
+        t->firstJob = t->lastJob = plan.count;
+        if (enter_project(t->owner) != 0)
+            continue;
+        plan_target(&plan, workspaceIn, order[i], optionsIn, &units);
+        if (!optionsIn->keepGoing && t->firstJob == t->lastJob)
+            printf("pmake: '%s' is up to date.\n", t->project);
+    }
+
+    if (chdir(cwd) != 0)
+        perror(cwd);
+
+    // Every project gets the compile commands of all its translation units.
+    for (int p = 0; p < workspaceIn->projectCount; p++) {
+        Project *project = &workspaceIn->projects[p];
+        if (project->compileCommands == NULL)
+            continue;
+        char *path = NULL, *content = NULL;
+        append_format(&path, "%s/compile_commands.json", project->directory);
+        append_format(&content, "[\n%s\n]\n", project->compileCommands);
+        write_if_changed(path, content);
+        free(content);
+        free(path);
+    }
+
+    if (optionsIn->dryRun) {
+        print_plan(&plan, units);
+        free_plan(&plan);
+        free(order);
+        return EXIT_SUCCESS;
+    }
+
+    // Step 3: Execute the plan.
+    int failed = 0;
+    if (plan.count > 0) {
+        printf("Running %d job(s) for %d translation unit(s) with up to %d job(s) in parallel:\n",
+               plan.count, units, optionsIn->maxJobs);
+        failed = run_plan(&plan, optionsIn->maxJobs, optionsIn->cache, optionsIn->workers, optionsIn->keepGoing);
+
+        // The cache steps of the jobs ran in their directories.
+        if (chdir(cwd) != 0)
+            perror(cwd);
+
+        if (optionsIn->trace != NULL)
+            write_trace(&plan, optionsIn->trace);
+        if (optionsIn->slowest > 0)
+            print_slowest(&plan, optionsIn->slowest);
+    }
+
+    // Step 4: Remember what was built.
+    for (int p = 0; p < workspaceIn->projectCount; p++) {
+        if (enter_project(&workspaceIn->projects[p]) == 0)
+            record_project(&plan, &workspaceIn->projects[p], optionsIn->cache);
+    }
+
+    if (chdir(cwd) != 0)
+        perror(cwd);
+
+    // Step 5: One line per target, so a workspace build ends with a single summary.
+    if (optionsIn->keepGoing) {
+        int built = 0, current = 0, broken = 0, skipped = 0;
+        printf("\nSummary:\n");
+        for (int i = 0; i < ordered; i++) {
+            Target *t = workspaceIn->targets[order[i]];
+            const char *status = "up to date";
+            for (int j = t->firstJob; j < t->lastJob; j++) {
+                if (plan.jobs[j].state == JOB_FAILED) { status = "FAILED"; break; }
+                if (plan.jobs[j].state != JOB_DONE) status = "skipped";
+                else if (strcmp(status, "up to date") == 0) status = "built";
+            }
+            built += strcmp(status, "built") == 0;
+            current += strcmp(status, "up to date") == 0;
+            broken += strcmp(status, "FAILED") == 0;
+            skipped += strcmp(status, "skipped") == 0;
+            printf("  %-12s %s (%s)\n", status, t->project, t->owner->makefile);
+        }
+        printf("%d built, %d up to date, %d failed, %d skipped.\n", built, current, broken, skipped);
+    }
+
+    free_plan(&plan);
+    free(order);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Collects every *.makefile below a directory. Hidden directories like .git and .pmake are skipped.
+ *
+ * @param Workspace *workspaceIn    - The workspace the makefiles are added to.
+ * @param const char *directoryIn   - The directory to walk.
+ * -------------------------------------------------------------------------------------------------------- */
+void find_makefiles(Workspace *workspaceIn, const char *directoryIn) {
+    DIR *dir = opendir(directoryIn);
+    if (dir == NULL)
+        return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        char *path = NULL;
+        append_format(&path, "%s/%s", directoryIn, entry->d_name);
+
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            size_t length = strlen(entry->d_name);
+            if (S_ISDIR(st.st_mode))
+                find_makefiles(workspaceIn, path);
+            else if (length > 9 && strcmp(entry->d_name + length - 9, ".makefile") == 0)
+                add_project(workspaceIn, path);
+        }
+        free(path);
+    }
+
+    closedir(dir);
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Reads a single makefile or every makefile below a directory into a workspace and resolves the
+ * dependencies between the targets. Dependencies between makefiles are only inferred for a directory.
+ *
+ * @param Workspace *workspaceIn    - The empty workspace to fill.
+ * @param const char *makefileIn    - The makefile, or NULL.
+ * @param const char *directoryIn   - The root of the workspace, or NULL.
+ * @return int                      - 0 on success, -1 if the workspace can't be built.
+ * -------------------------------------------------------------------------------------------------------- */
+int open_workspace(Workspace *workspaceIn, const char *makefileIn, const char *directoryIn) {
+    if (directoryIn != NULL) {
+        find_makefiles(workspaceIn, directoryIn);
+        index_targets(workspaceIn);
+        printf("Workspace %s: %d makefile(s), %d target(s).\n", directoryIn, workspaceIn->projectCount,
+               workspaceIn->targetCount);
+        return resolve_dependencies(workspaceIn, 1);
+    }
+
+    if (add_project(workspaceIn, makefileIn) != 0)
+        return -1;
+
+    index_targets(workspaceIn);
+
+    if (workspaceIn->targetCount == 0) {
+        fprintf(stderr, "pmake: %s defines no project.\n", makefileIn);
+        return -1;
+    }
+    return resolve_dependencies(workspaceIn, 0);
+}
+
+/* ------------------------------------------------------------------------------------------------
+ * The process_makefile function is a pivotal component of our custom "Make" program, designed to
+ * streamline the build process by reading and executing commands from a specified makefile. This
+ * function ensures efficient parsing and execution of build instructions, enhancing productivity
+ * and simplifying project management for developers.
+ *
+ * All targets of the makefile are planned in dependency order into one build plan, so the job
+ * scheduler runs every compile job of every target on up to maxJobsIn cores and only the link
+ * steps wait for the targets they depend on.
+ *
+ * @param filename  The name of the makefile to be processed. This file contains the build instructions
+ *                  to be executed.
+ * @param optionsIn The options of the run.
+ * @return int      EXIT_SUCCESS if the project was built, EXIT_FAILURE otherwise.
+ * ------------------------------------------------------------------------------------------------- */
+int process_makefile(const char *filename, BuildOptions *optionsIn) {
+
+    Workspace workspace = {0};
+    int result = EXIT_FAILURE;
+
+    if (open_workspace(&workspace, filename, NULL) == 0)
+        result = build_workspace(&workspace, optionsIn);
+
+    free_workspace(&workspace);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * The process_workspace function builds every makefile below a directory in one go. All makefiles are
+ * parsed into one plan, the order between them is inferred from their link inputs, and one pool of
+ * workers builds everything, so the wall time is bounded by the longest dependency chain instead of the
+ * sum of all projects. A failing project doesn't stop the projects that don't depend on it.
+ *
+ * @param const char *directoryIn   - The root of the workspace.
+ * @param BuildOptions *optionsIn   - The options of the run, keepGoing is always on.
+ * @return int                      - EXIT_SUCCESS if everything was built, EXIT_FAILURE otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int process_workspace(const char *directoryIn, BuildOptions *optionsIn) {
+
+    Workspace workspace = {0};
+    int result = EXIT_FAILURE;
+
+    optionsIn->keepGoing = 1;
+    if (open_workspace(&workspace, NULL, directoryIn) == 0)
+        result = build_workspace(&workspace, optionsIn);
+
+    free_workspace(&workspace);
+    return result;
+}
+
+/* ***************************************START BUILD SERVER*********************************************** */
+
+/* --------------------------------------------------------------------------------------------------------
+ * The socket of the build server lives in the .pmake directory next to the makefile, or in the .pmake
+ * directory of the workspace root, so every makefile or workspace has at most one server.
+ *
+ * @param const char *makefileIn    - The makefile, or NULL.
+ * @param const char *directoryIn   - The root of the workspace, or NULL.
+ * @return char*                    - The path of the socket, the caller frees it.
+ * -------------------------------------------------------------------------------------------------------- */
+char *socket_path(const char *makefileIn, const char *directoryIn) {
+    char *path = NULL;
+    if (directoryIn != NULL) {
+        append_format(&path, "%s/.pmake/workspace.sock", directoryIn);
+        return path;
+    }
+
+    // Same place as the state file, only with .sock instead of .state.
+    char *state = state_path(makefileIn);
+    append_format(&path, "%.*s.sock", (int)(strlen(state) - 6), state);
+    free(state);
+    return path;
+}
+
+#ifdef _WIN32
+
+/* --------------------------------------------------------------------------------------------------------
+ * Windows has no build server, every pmake run builds on its own.
+ * -------------------------------------------------------------------------------------------------------- */
+int request_server(const char *pathIn, const char *requestIn) {
+    (void)pathIn;
+    (void)requestIn;
+    return -1;
+}
+
+int serve_workspace(const char *makefileIn, const char *directoryIn, BuildOptions *optionsIn) {
+    (void)makefileIn;
+    (void)directoryIn;
+    (void)optionsIn;
+    fprintf(stderr, "pmake: --serve is not supported on Windows.\n");
+    return EXIT_FAILURE;
+}
+
+#else
+
+/* --------------------------------------------------------------------------------------------------------
+ * A BuildServer keeps a workspace resident between builds: the parsed makefiles, the dependency graph
+ * between the targets and the build state with the stamp and hash of every file it has seen. A rebuild
+ * then costs one stat() per known file instead of parsing, loading and hashing everything anew.
+ * -------------------------------------------------------------------------------------------------------- */
+typedef struct {
+    Workspace workspace;        // The resident workspace.
+    const char *makefile;       // The makefile served, or NULL.
+    const char *directory;      // The workspace root served, or NULL.
+    BuildOptions *options;      // The options every build runs with.
+    int inotify;                // The inotify descriptor, -1 if the tree is polled.
+    char cwd[4096];             // The directory the server was started in.
+} BuildServer;
+
+/* --------------------------------------------------------------------------------------------------------
+ * Connects to the build server listening on a socket.
+ *
+ * @param const char *pathIn    - The socket.
+ * @return int                  - The connected descriptor, -1 if no server listens.
+ * -------------------------------------------------------------------------------------------------------- */
+int connect_server(const char *pathIn) {
+    struct sockaddr_un address = {0};
+    if (strlen(pathIn) >= sizeof(address.sun_path))
+        return -1;
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, pathIn);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Sends one request to the build server and copies its output to stdout. The server ends its answer
+ * with a '\0' followed by the exit code of the build.
+ *
+ * @param const char *pathIn    - The socket of the server.
+ * @param const char *requestIn - "build" or "stop".
+ * @return int                  - The exit code of the server, -1 if no server listens.
+ * -------------------------------------------------------------------------------------------------------- */
+int request_server(const char *pathIn, const char *requestIn) {
+    int fd = connect_server(pathIn);
+    if (fd < 0)
+        return -1;
+
+    char *line = NULL;
+    append_format(&line, "%s\n", requestIn);
+    if (write(fd, line, strlen(line)) != (ssize_t)strlen(line)) {
+        free(line);
+        close(fd);
+        return -1;
+    }
+    free(line);
+
+    int result = EXIT_FAILURE;
+    int ended = 0;  // 0 while output comes, 1 after the '\0', 2 once the exit code is read.
+    char buffer[4096];
+    ssize_t n;
+    while (ended < 2 && (n = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < n && ended < 2; i++) {
+            if (ended == 1) {
+                result = (unsigned char)buffer[i];
+                ended = 2;
+            } else if (buffer[i] == '\0') {
+                fwrite(buffer, 1, i, stdout);
+                ended = 1;
+            }
+        }
+        if (ended == 0)
+            fwrite(buffer, 1, n, stdout);
+    }
+    fflush(stdout);
+    close(fd);
+
+    if (ended < 2)
+        fprintf(stderr, "pmake: the build server went away.\n");
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Watches the directories of the makefiles and of every file the build state knows, sources and headers
+ * alike. inotify isn't recursive, so a new include directory is picked up after the next build. The
+ * .pmake directories are left out, pmake itself writes there on every build.
+ *
+ * @param BuildServer *serverIn - The server.
+ * -------------------------------------------------------------------------------------------------------- */
+void watch_workspace(BuildServer *serverIn) {
+#ifdef __linux__
+    if (serverIn->inotify < 0)
+        return;
+
+    uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB;
+    for (int p = 0; p < serverIn->workspace.projectCount; p++) {
+        Project *project = &serverIn->workspace.projects[p];
+        inotify_add_watch(serverIn->inotify, project->directory, events);
+
+        for (int i = 0; i < project->state.fileSize; i++) {
+            FileInfo *info = &project->state.files[i];
+            if (info->path == NULL)
+                continue;
+
+            // Adding the same directory again only returns its existing watch.
+            char *path = absolute_path(project->directory, info->path);
+            char *slash = strrchr(path, '/');
+            if (slash != NULL && slash != path && strstr(path, "/.pmake") == NULL) {
+                *slash = '\0';
+                inotify_add_watch(serverIn->inotify, path, events);
+            }
+            free(path);
+        }
+
+        // New files in the directories of glob patterns join the build.
+        for (int i = 0; i < project->state.dirSize; i++) {
+            if (project->state.dirs[i].path == NULL || !project->state.dirs[i].used)
+                continue;
+            char *path = absolute_path(project->directory, project->state.dirs[i].path);
+            inotify_add_watch(serverIn->inotify, path, events);
+            free(path);
+        }
+    }
+#else
+    (void)serverIn;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Brings the resident workspace up to date with the disk. A changed makefile reloads the whole
+ * workspace, otherwise only the stamps of the known files are checked again.
+ *
+ * @param BuildServer *serverIn - The server.
+ * @return int                  - The number of changed files, 0 if a rebuild would do nothing.
+ * -------------------------------------------------------------------------------------------------------- */
+int refresh_workspace(BuildServer *serverIn) {
+    Workspace *workspace = &serverIn->workspace;
+
+    for (int p = 0; p < workspace->projectCount; p++) {
+        Project *project = &workspace->projects[p];
+        FileStamp stamp = {0};
+        stamp_file(project->makefile, &stamp);
+        if (stamp.mtime != project->makefileStamp.mtime || stamp.size != project->makefileStamp.size) {
+            printf("pmake: %s changed, reloading.\n", project->makefile);
+            free_workspace(workspace);
+            memset(workspace, 0, sizeof(Workspace));
+            open_workspace(workspace, serverIn->makefile, serverIn->directory);
+            return 1;
+        }
+    }
+
+    int changed = 0;
+    for (int p = 0; p < workspace->projectCount; p++) {
+        Project *project = &workspace->projects[p];
+        if (project->loaded && enter_project(project) == 0)
+            changed += refresh_files(&project->state);
+    }
+    if (chdir(serverIn->cwd) != 0)
+        perror(serverIn->cwd);
+    return changed;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Builds the resident workspace once and watches whatever the build taught the server about.
+ *
+ * @param BuildServer *serverIn - The server.
+ * @return int                  - EXIT_SUCCESS if everything was built, EXIT_FAILURE otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int server_build(BuildServer *serverIn) {
+    int result = EXIT_FAILURE;
+    if (serverIn->workspace.targetCount > 0)
+        result = build_workspace(&serverIn->workspace, serverIn->options);
+
+    if (chdir(serverIn->cwd) != 0)
+        perror(serverIn->cwd);
+
+    // The statistics are appended per build, so they must not be counted twice.
+    CompilationCache *cache = serverIn->options->cache;
+    if (cache != NULL) {
+        cache_save_stats(cache);
+        cache->hits = cache->misses = cache->bytesSaved = 0;
+    }
+
+    watch_workspace(serverIn);
+    fflush(stdout);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Answers one client. For "build" the output of the build, including the output of the compilers the
+ * jobs start, goes straight into the socket, then the exit code follows after a '\0'.
+ *
+ * @param BuildServer *serverIn - The server.
+ * @param int clientIn          - The connected client.
+ * @return int                  - 1 if the client asked the server to stop, 0 otherwise.
+ * -------------------------------------------------------------------------------------------------------- */
+int serve_client(BuildServer *serverIn, int clientIn) {
+    char request[64];
+    size_t length = 0;
+    while (length + 1 < sizeof(request) && read(clientIn, request + length, 1) == 1 && request[length] != '\n')
+        length++;
+    request[length] = '\0';
+
+    int result = EXIT_SUCCESS;
+    int stop = strcmp(request, "stop") == 0;
+
+    if (strcmp(request, "build") == 0) {
+        fflush(stdout);
+        fflush(stderr);
+        int out = dup(STDOUT_FILENO);
+        int err = dup(STDERR_FILENO);
+        dup2(clientIn, STDOUT_FILENO);
+        dup2(clientIn, STDERR_FILENO);
+
+        refresh_workspace(serverIn);
+        result = server_build(serverIn);
+
+        fflush(stdout);
+        fflush(stderr);
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+        close(out);
+        close(err);
+    } else if (stop) {
+        const char *message = "pmake: build server stopped.\n";
+        if (write(clientIn, message, strlen(message)) < 0)
+            perror("write");
+    } else {
+        result = EXIT_FAILURE;
+    }
+
+    char end[2] = {'\0', (char)result};
+    if (write(clientIn, end, sizeof(end)) < 0)
+        perror("write");
+    return stop;
+}
+
+/* --------------------------------------------------------------------------------------------------------
+ * Runs pmake as a build server. The workspace is built once, then the server waits for two things: a
+ * client asking for a build, and changes in the source tree reported by inotify. Changes are collected
+ * until the tree has been quiet for 100 ms, so saving ten files in an editor gives one rebuild. Without
+ * inotify the known files are checked every 500 ms instead.
+ *
+ * @param const char *makefileIn    - The makefile to serve, or NULL.
+ * @param const char *directoryIn   - The root of the workspace to serve, or NULL.
+ * @param BuildOptions *optionsIn   - The options of every build.
+ * @return int                      - EXIT_SUCCESS once a client stopped the server.
+ * -------------------------------------------------------------------------------------------------------- */
+int serve_workspace(const char *makefileIn, const char *directoryIn, BuildOptions *optionsIn) {
+    char *path = socket_path(makefileIn, directoryIn);
+
+    int probe = connect_server(path);
+    if (probe >= 0) {
+        close(probe);
+        fprintf(stderr, "pmake: a build server already listens on %s.\n", path);
+        free(path);
+        return EXIT_FAILURE;
+    }
+
+    // Compiler output goes to clients, it has to stay in order with the lines of pmake itself.
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    signal(SIGPIPE, SIG_IGN);
+
+    char *directory = NULL;
+    append_format(&directory, "%s", path);
+    *strrchr(directory, '/') = '\0';
+    make_directories(directory);
+    free(directory);
+
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "pmake: can't create the socket %s.\n", path);
+        free(path);
+        return EXIT_FAILURE;
+    }
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 8) != 0) {
+        perror(path);
+        close(listener);
+        free(path);
+        return EXIT_FAILURE;
+    }
+
+    BuildServer server = {0};
+    server.makefile = makefileIn;
+    server.directory = directoryIn;
+    server.options = optionsIn;
+    server.inotify = -1;
+    if (getcwd(server.cwd, sizeof(server.cwd)) == NULL) {
+        perror("getcwd");
+        close(listener);
+        free(path);
+        return EXIT_FAILURE;
+    }
+
+#ifdef __linux__
+    server.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
+    open_workspace(&server.workspace, makefileIn, directoryIn);
+    printf("pmake: serving %s on %s (%s).\n", makefileIn ? makefileIn : directoryIn, path,
+           server.inotify >= 0 ? "inotify" : "polling");
+    server_build(&server);
+
+    int dirty = 0;
+    for (;;) {
+        struct pollfd fds[2] = {{listener, POLLIN, 0}, {server.inotify, POLLIN, 0}};
+        int count = server.inotify >= 0 ? 2 : 1;
+        int timeout = server.inotify < 0 ? 500 : (dirty ? 100 : -1);
+
+        int ready = poll(fds, count, timeout);
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+
+        if (count == 2 && (fds[1].revents & POLLIN)) {
+            // Only the fact that something changed matters, the stamps tell what.
+            char events[4096];
+            while (read(server.inotify, events, sizeof(events)) > 0)
+                ;
+            dirty = 1;
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client = accept(listener, NULL, NULL);
+            if (client < 0)
+                continue;
+            int stop = serve_client(&server, client);
+            close(client);
+            if (stop)
+                break;
+            continue;
+        }
+
+        if (ready == 0 && (dirty || server.inotify < 0)) {
+            dirty = 0;
+            if (refresh_workspace(&server) > 0)
+                server_build(&server);
+        }
+    }
+
+    close(listener);
+    unlink(path);
+    if (server.inotify >= 0)
+        close(server.inotify);
+    free_workspace(&server.workspace);
+    free(path);
+    return EXIT_SUCCESS;
+}
+
+#endif
+
+/* ****************************************END BUILD SERVER************************************************ */
+
+// ---------------------------------------------------------------------------------------------------
+// Our main function serves as the command center of your network diagnostics tool, orchestrating the
+// seamless execution of all key operations. It handles user input, dynamically configures the scanning
+// range, initiates progress tracking, and processes the results with utmost efficiency. Designed for
+// top-down clarity, this function ensures that every step, from initialization to output, is executed
+// with precision.
+//
+// By leveraging the main function, developers can effortlessly manage complex network diagnostics tasks,
+// ensuring a streamlined and intuitive user experience. It integrates all components harmoniously,
+// reflecting the highest standards of coding excellence.
+//
+// @param argc  The number of command-line arguments.
+// @param argv  The array of command-line arguments.
+// @return      0 on successful completion, 1 on error.
+// ----------------------------------------------------------------------------------------------------
+int main (int argc, char **argv) {
+
+    // Check if the help is triggered.
+    if(isHelpTriggered(argc, argv[1])) {
+        print_help();
+        return 1;
+    }
+
+    BuildOptions options = {0};
+    int useCache = 1;
+    char *makefile = NULL;
+    char *workspace = NULL;
+    int serve = 0;
+    int stop = 0;
+    int jobsGiven = 0;
+    char *worker = NULL;
+    WorkerPool workers = {0};
+
+    options.maxJobs = default_job_count();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache-stats") == 0) {
+            return print_cache_stats();
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            useCache = 0;
+        } else if (strcmp(argv[i], "--workspace") == 0 && i + 1 < argc) {
+            workspace = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            serve = 1;
+        } else if (strcmp(argv[i], "--stop") == 0) {
+            stop = 1;
+        } else if (strcmp(argv[i], "--worker") == 0 && i + 1 < argc) {
+            worker = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            if (parse_workers(argv[++i], default_job_count(), &workers) != 0)
+                return 1;
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            options.dryRun = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.trace = argv[++i];
+        } else if (strcmp(argv[i], "--slowest") == 0 && i + 1 < argc) {
+            options.slowest = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options.maxJobs = atoi(argv[++i]);
+            jobsGiven = 1;
+        } else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+            options.maxJobs = atoi(argv[i] + 2);
+            jobsGiven = 1;
+        } else {
+            makefile = argv[i];
+        }
+    }
+
+    if (options.maxJobs < 1)
+        options.maxJobs = 1;
+
+    if (worker != NULL)
+        return serve_compiles(worker, options.maxJobs);
+
+    if (makefile == NULL && workspace == NULL) {
+        print_help();
+        return 1;
+    }
+
+    // Every slot of a worker needs a job here, a preprocessor or the process waiting for the object.
+    if (workers.count > 0) {
+        if (!jobsGiven)
+            for (int i = 0; i < workers.count; i++)
+                options.maxJobs += workers.workers[i].slots;
+        options.workers = &workers;
+    }
+
+    CompilationCache cache = {0};
+    cache.directory = cache_directory();
+    options.cache = useCache ? &cache : NULL;
+
+    char *socket = socket_path(makefile, workspace);
+    int result = -1;
+
+    if (stop) {
+        result = request_server(socket, "stop");
+        if (result < 0) {
+            fprintf(stderr, "pmake: no build server listens on %s.\n", socket);
+            result = EXIT_FAILURE;
+        }
+    } else if (serve) {
+        if (workspace != NULL)
+            options.keepGoing = 1;
+        result = serve_workspace(makefile, workspace, &options);
+    } else {
+        // A running build server already knows the state of every file, a plain build is sent there.
+        if (useCache && !options.dryRun && options.trace == NULL && options.slowest == 0 && workers.count == 0)
+            result = request_server(socket, "build");
+
+        if (result < 0 && workspace != NULL)
+            result = process_workspace(workspace, &options);
+        else if (result < 0)
+            result = process_makefile(makefile, &options);
+    }
+    free(socket);
+
+    if (!options.dryRun)
+        cache_save_stats(&cache);
+    free(cache.directory);
+    for (int i = 0; i < workers.count; i++) {
+        free(workers.workers[i].host);
+        free(workers.workers[i].port);
+    }
+    free(workers.workers);
+    return result;
+}